@@ -0,0 +1,449 @@
+/**
+ * @file dhcp_replay.cpp
+ *
+ *  @brief: pcap replay benchmark for dhcpmon packet classification path.
+ *
+ *  Captured packets are fed through the same parsing and counting logic used by the dhcpmon capture callbacks.
+ *  Redis lookups done in dual tor mode are replaced by an in-process stub.
+ */
+
+#include <errno.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/ether.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "dhcp_device.h"
+#include "dhcp_txn.h"
+
+/** pcap global header magic, microsecond resolution */
+#define PCAP_MAGIC          0xa1b2c3d4
+/** pcap global header magic, nanosecond resolution */
+#define PCAP_MAGIC_NSEC     0xa1b23c4d
+/** pcap link type of Ethernet captures */
+#define PCAP_LINKTYPE_ETHERNET  1
+
+/** pcap file global header */
+typedef struct
+{
+    uint32_t magic;             /** magic number */
+    uint16_t version_major;     /** major version number */
+    uint16_t version_minor;     /** minor version number */
+    int32_t thiszone;           /** GMT to local correction */
+    uint32_t sigfigs;           /** accuracy of timestamps */
+    uint32_t snaplen;           /** max length of captured packets */
+    uint32_t linktype;          /** data link type */
+} pcap_file_header_t;
+
+/** pcap record header */
+typedef struct
+{
+    uint32_t ts_sec;            /** timestamp seconds */
+    uint32_t ts_frac;           /** timestamp microseconds or nanoseconds */
+    uint32_t incl_len;          /** number of octets of packet saved in file */
+    uint32_t orig_len;          /** actual length of packet */
+} pcap_record_header_t;
+
+/** captured packet location within pcap file data */
+typedef struct
+{
+    size_t offset;              /** packet offset */
+    size_t len;                 /** packet captured length */
+} replay_packet_t;
+
+/** dhcp_device.cpp dependency normally defined by dhcpmon main */
+bool dual_tor_sock = false;
+
+/** Interface indexes handed out to the member interfaces named on the command line */
+static std::map<std::string, int> stub_ifindexes;
+
+/** Indexes of member interfaces reported as standby by the redis stub */
+static std::set<int> standby_members;
+
+/**
+ * @code usage(prog);
+ *
+ * @brief prints help message about how to use the benchmark
+ *
+ * @param prog program name
+ *
+ * @return none
+ */
+static void usage(const char *prog)
+{
+    printf("Usage: %s -r <pcap file> -d <downlink mac> -u <uplink mac> -g <giaddr> [-n <iterations>] "
+           "[-t <member interface>] [-s <standby member interface>]*\n", prog);
+    printf("where\n");
+    printf("\tpcap file: Ethernet capture of DHCP traffic,\n");
+    printf("\tdownlink mac: hardware address of the vlan interface,\n");
+    printf("\tuplink mac: hardware address of the uplink interfaces,\n");
+    printf("\tgiaddr: gateway IP address inserted by the relay,\n");
+    printf("\titerations: number of times the capture is replayed for throughput measurement (default 100),\n");
+    printf("\tmember interface: enables dual tor mode, packets are treated as received on this interface,\n");
+    printf("\tstandby member interface: member interface reported in standby mux state.\n");
+
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @code stub_ifindex(name);
+ *
+ * @brief assigns interface indexes to member interfaces, the replayed packets are not received on real interfaces
+ *
+ * @param name          member interface name
+ *
+ * @return interface index of name
+ */
+static int stub_ifindex(const char *name)
+{
+    auto it = stub_ifindexes.find(name);
+
+    if (it != stub_ifindexes.end()) {
+        return it->second;
+    }
+
+    int ifindex = (int) stub_ifindexes.size() + 1;
+    stub_ifindexes[name] = ifindex;
+
+    return ifindex;
+}
+
+/**
+ * @code stub_member_filter(vlan_intf, member_ifindex);
+ *
+ * @brief in-process replacement of the STATE_DB/CONFIG_DB lookups done in dual tor mode
+ *
+ * @param vlan_intf         vlan interface name
+ * @param member_ifindex    index of the interface the packet was received on
+ *
+ * @return true if member interface is not in standby state
+ */
+static bool stub_member_filter(const char *vlan_intf, int member_ifindex)
+{
+    return standby_members.find(member_ifindex) == standby_members.end();
+}
+
+/**
+ * @code now_ns();
+ *
+ * @brief monotonic clock accessor
+ *
+ * @return current monotonic time in nanoseconds
+ */
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @code load_pcap(path, data, packets);
+ *
+ * @brief loads pcap file in memory and indexes its packets
+ *
+ * @param path          pcap file path
+ * @param data(out)     pcap file content
+ * @param packets(out)  packets location within data
+ *
+ * @return 0 on success, otherwise for failure
+ */
+static int load_pcap(const char *path, std::vector<uint8_t> &data, std::vector<replay_packet_t> &packets)
+{
+    int rv = -1;
+    FILE *fp = fopen(path, "rb");
+
+    do {
+        if (fp == NULL) {
+            fprintf(stderr, "fopen: failed to open '%s' with '%s'\n", path, strerror(errno));
+            break;
+        }
+
+        uint8_t chunk[65536];
+        size_t sz;
+        while ((sz = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+            data.insert(data.end(), chunk, chunk + sz);
+        }
+
+        if (data.size() < sizeof(pcap_file_header_t)) {
+            fprintf(stderr, "'%s' is too small to be a pcap file\n", path);
+            break;
+        }
+
+        pcap_file_header_t *hdr = (pcap_file_header_t *) data.data();
+        bool swapped = false;
+        if (hdr->magic != PCAP_MAGIC && hdr->magic != PCAP_MAGIC_NSEC) {
+            swapped = true;
+            if (__builtin_bswap32(hdr->magic) != PCAP_MAGIC && __builtin_bswap32(hdr->magic) != PCAP_MAGIC_NSEC) {
+                fprintf(stderr, "'%s' is not a pcap file\n", path);
+                break;
+            }
+        }
+
+        uint32_t linktype = swapped ? __builtin_bswap32(hdr->linktype) : hdr->linktype;
+        if (linktype != PCAP_LINKTYPE_ETHERNET) {
+            fprintf(stderr, "'%s' link type %u is not supported, Ethernet capture is required\n", path, linktype);
+            break;
+        }
+
+        size_t offset = sizeof(pcap_file_header_t);
+        while (offset + sizeof(pcap_record_header_t) <= data.size()) {
+            pcap_record_header_t *rec = (pcap_record_header_t *) (data.data() + offset);
+            size_t len = swapped ? __builtin_bswap32(rec->incl_len) : rec->incl_len;
+
+            offset += sizeof(pcap_record_header_t);
+            if (offset + len > data.size()) {
+                fprintf(stderr, "'%s' is truncated, ignoring last packet\n", path);
+                break;
+            }
+
+            packets.push_back({.offset = offset, .len = len});
+            offset += len;
+        }
+
+        rv = 0;
+    } while (0);
+
+    if (fp != NULL) {
+        fclose(fp);
+    }
+
+    return rv;
+}
+
+/**
+ * @code replay(contexts, data, packets, member_ifindex, latencies);
+ *
+ * @brief feeds captured packets to every device context
+ *
+ * @param contexts          device (interface) contexts
+ * @param data              pcap file content
+ * @param packets           packets location within data
+ * @param member_ifindex    dual tor member interface index, 0 for single tor mode
+ * @param latencies         per packet processing time in nanoseconds, NULL to skip per packet timing
+ *
+ * @return none
+ */
+static void replay(std::vector<dhcp_device_context_t *> &contexts,
+                   const std::vector<uint8_t> &data,
+                   const std::vector<replay_packet_t> &packets,
+                   int member_ifindex,
+                   std::vector<uint64_t> *latencies)
+{
+    for (const replay_packet_t &packet : packets) {
+        const uint8_t *buffer = data.data() + packet.offset;
+        uint64_t start = latencies != NULL ? now_ns() : 0;
+
+        for (dhcp_device_context_t *context : contexts) {
+            if (member_ifindex != 0) {
+                dhcp_device_handle_packet_dual_tor(context, buffer, packet.len, member_ifindex);
+            } else {
+                dhcp_device_handle_packet(context, buffer, packet.len);
+            }
+        }
+
+        if (latencies != NULL) {
+            latencies->push_back(now_ns() - start);
+        }
+    }
+}
+
+/**
+ * @code reset_counters(contexts);
+ *
+ * @brief clears current counters of device contexts and aggregate device
+ *
+ * @param contexts          device (interface) contexts
+ *
+ * @return none
+ */
+static void reset_counters(std::vector<dhcp_device_context_t *> &contexts)
+{
+    for (dhcp_device_context_t *context : contexts) {
+        memset(context->counters, 0, sizeof(context->counters));
+    }
+    memset(dhcp_device_get_aggregate_context()->counters, 0, sizeof(dhcp_device_get_aggregate_context()->counters));
+}
+
+/**
+ * @code print_counters(context);
+ *
+ * @brief prints current counters of a device context
+ *
+ * @param context       device (interface) context
+ *
+ * @return none
+ */
+static void print_counters(dhcp_device_context_t *context)
+{
+    uint64_t (*counters)[DHCP_MESSAGE_TYPE_COUNT] = context->counters[DHCP_COUNTERS_CURRENT];
+
+    printf("%-16s rx/tx Discover: %lu/%lu, Offer: %lu/%lu, Request: %lu/%lu, ACK: %lu/%lu, NAK: %lu/%lu\n",
+           context->intf,
+           counters[DHCP_RX][DHCP_MESSAGE_TYPE_DISCOVER], counters[DHCP_TX][DHCP_MESSAGE_TYPE_DISCOVER],
+           counters[DHCP_RX][DHCP_MESSAGE_TYPE_OFFER], counters[DHCP_TX][DHCP_MESSAGE_TYPE_OFFER],
+           counters[DHCP_RX][DHCP_MESSAGE_TYPE_REQUEST], counters[DHCP_TX][DHCP_MESSAGE_TYPE_REQUEST],
+           counters[DHCP_RX][DHCP_MESSAGE_TYPE_ACK], counters[DHCP_TX][DHCP_MESSAGE_TYPE_ACK],
+           counters[DHCP_RX][DHCP_MESSAGE_TYPE_NAK], counters[DHCP_TX][DHCP_MESSAGE_TYPE_NAK]);
+}
+
+/**
+ * @code init_context(context, intf, mac, is_uplink, giaddr_ip);
+ *
+ * @brief initializes a device context without opening capture socket
+ *
+ * @return 0 on success, otherwise for failure
+ */
+static int init_context(dhcp_device_context_t *context,
+                        const char *intf,
+                        const char *mac,
+                        uint8_t is_uplink,
+                        in_addr_t giaddr_ip)
+{
+    struct ether_addr *addr = ether_aton(mac);
+
+    if (addr == NULL) {
+        fprintf(stderr, "invalid hardware address '%s'\n", mac);
+        return -1;
+    }
+
+    memset(context, 0, sizeof(*context));
+    strncpy(context->intf, intf, sizeof(context->intf) - 1);
+    memcpy(context->mac, addr->ether_addr_octet, sizeof(context->mac));
+    context->is_uplink = is_uplink;
+    context->giaddr_ip = giaddr_ip;
+
+    return 0;
+}
+
+/**
+ * @code main(argc, argv);
+ *
+ * @brief main entry point of dhcpmon pcap replay benchmark
+ *
+ * @return int 0 on success, otherwise on failure
+ */
+int main(int argc, char **argv)
+{
+    const char *pcap_file = NULL;
+    const char *downlink_mac = NULL;
+    const char *uplink_mac = NULL;
+    int member_ifindex = 0;
+    in_addr_t giaddr_ip = 0;
+    int iterations = 100;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:d:u:g:n:t:s:h")) != -1) {
+        switch (opt)
+        {
+        case 'r':
+            pcap_file = optarg;
+            break;
+        case 'd':
+            downlink_mac = optarg;
+            break;
+        case 'u':
+            uplink_mac = optarg;
+            break;
+        case 'g':
+            if (inet_pton(AF_INET, optarg, &giaddr_ip) != 1) {
+                usage(basename(argv[0]));
+            }
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 't':
+            member_ifindex = stub_ifindex(optarg);
+            break;
+        case 's':
+            standby_members.insert(stub_ifindex(optarg));
+            break;
+        default:
+            usage(basename(argv[0]));
+        }
+    }
+
+    if (pcap_file == NULL || downlink_mac == NULL || uplink_mac == NULL || giaddr_ip == 0 || iterations <= 0) {
+        usage(basename(argv[0]));
+    }
+
+    openlog(basename(argv[0]), LOG_PERROR, LOG_USER);
+    setlogmask(LOG_UPTO(LOG_ERR));
+
+    std::vector<uint8_t> data;
+    std::vector<replay_packet_t> packets;
+    if (load_pcap(pcap_file, data, packets) != 0 || packets.empty()) {
+        fprintf(stderr, "no packets to replay\n");
+        return EXIT_FAILURE;
+    }
+
+    dhcp_device_context_t downlink_dev, uplink_dev;
+    if (init_context(&downlink_dev, "downlink", downlink_mac, 0, giaddr_ip) != 0 ||
+        init_context(&uplink_dev, "uplink", uplink_mac, 1, giaddr_ip) != 0) {
+        return EXIT_FAILURE;
+    }
+    strncpy(dhcp_device_get_aggregate_context()->intf, "aggregate", IF_NAMESIZE - 1);
+
+    if (dhcp_txn_init(8192, 10) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<dhcp_device_context_t *> contexts = {&downlink_dev, &uplink_dev};
+    dual_tor_sock = member_ifindex != 0;
+    dhcp_device_set_member_filter(stub_member_filter);
+
+    // throughput, without per packet timing overhead
+    uint64_t start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        replay(contexts, data, packets, member_ifindex, NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    // per packet latency and counters of a single replay
+    std::vector<uint64_t> latencies;
+    latencies.reserve(packets.size());
+    reset_counters(contexts);
+    replay(contexts, data, packets, member_ifindex, &latencies);
+    std::sort(latencies.begin(), latencies.end());
+
+    uint64_t total_packets = (uint64_t) packets.size() * iterations;
+    uint64_t latency_sum = 0;
+    for (uint64_t latency : latencies) {
+        latency_sum += latency;
+    }
+
+    printf("packets: %zu, iterations: %d, mode: %s\n", packets.size(), iterations,
+           member_ifindex != 0 ? "dual tor" : "single tor");
+    printf("throughput: %.0f packets/sec (%lu packets in %.3f sec)\n",
+           total_packets * 1e9 / (elapsed ? elapsed : 1), total_packets, elapsed / 1e9);
+    printf("latency (ns): min %lu, avg %lu, p50 %lu, p99 %lu, max %lu\n",
+           latencies.front(), latency_sum / latencies.size(), latencies[latencies.size() / 2],
+           latencies[latencies.size() * 99 / 100], latencies.back());
+    print_counters(&downlink_dev);
+    print_counters(&uplink_dev);
+    print_counters(dhcp_device_get_aggregate_context());
+
+    const dhcp_txn_stats_t *discover_stats = dhcp_txn_get_stats(DHCP_TXN_DISCOVER_OFFER);
+    const dhcp_txn_stats_t *request_stats = dhcp_txn_get_stats(DHCP_TXN_REQUEST_ACK);
+    printf("transactions completed: Discover/Offer %lu, Request/Ack %lu, dropped: %lu/%lu\n",
+           discover_stats->completed, request_stats->completed, discover_stats->dropped, request_stats->dropped);
+
+    dhcp_txn_shutdown();
+
+    closelog();
+
+    return EXIT_SUCCESS;
+}
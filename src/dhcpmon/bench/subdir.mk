@@ -0,0 +1,17 @@
+BENCH_SRCS += \
+../bench/dhcp_replay.cpp
+
+BENCH_OBJS += \
+./bench/dhcp_replay.o
+
+C_DEPS += \
+./bench/dhcp_replay.d
+
+
+# Each subdirectory must supply rules for building sources it contributes
+bench/%.o: bench/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C Compiler'
+	$(CC) -O3 -g3 -Wall -I$(PWD)/src -I$(PWD)/../sonic-swss-common/common -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
@@ -23,8 +23,10 @@
 #include <netpacket/packet.h>
 #include "subscriberstatetable.h"
 #include "select.h"
+#include "redispipeline.h"
 
 #include "dhcp_device.h"
+#include "dhcp_txn.h"
 
 /** Counter print width */
 #define DHCP_COUNTER_WIDTH  9
@@ -39,8 +41,19 @@
 #define DHCP_START_OFFSET (UDP_START_OFFSET + sizeof(struct udphdr))
 /** Start of DHCP Options segment of a captured frame */
 #define DHCP_OPTIONS_HEADER_SIZE 240
+/** Offset of DHCP XID */
+#define DHCP_XID_OFFSET 4
 /** Offset of DHCP GIADDR */
 #define DHCP_GIADDR_OFFSET 24
+/** Offset of DHCP CHADDR */
+#define DHCP_CHADDR_OFFSET 28
+
+/** Min EWMA smoothing factor of rate based health check, smaller values smooth over minutes */
+#define DHCP_RATE_ALPHA_MIN 0.01
+/** Max DHCP packet rate (packets/sec) accepted as a rate based health check threshold */
+#define DHCP_RATE_MAX 1000000
+/** Max seconds of unhealthy rates accepted as a rate based health check threshold */
+#define DHCP_RATE_MAX_UNHEALTHY_SEC 3600
 
 #define OP_LDHA     (BPF_LD  | BPF_H   | BPF_ABS)   /** bpf ldh Abs */
 #define OP_LDHI     (BPF_LD  | BPF_H   | BPF_IND)   /** bpf ldh Ind */
@@ -51,11 +64,15 @@
 #define OP_JSET     (BPF_JMP | BPF_JSET | BPF_K)    /** bpf jset */
 #define OP_LDXB     (BPF_LDX | BPF_B    | BPF_MSH)  /** bpf ldxb */
 
-std::shared_ptr<swss::DBConnector> mStateDbPtr = std::make_shared<swss::DBConnector> ("STATE_DB", 0);
-std::shared_ptr<swss::Table> mStateDbMuxTablePtr = std::make_shared<swss::Table> (
-            mStateDbPtr.get(), "HW_MUX_CABLE_TABLE"
-        );
-swss::DBConnector configDb("CONFIG_DB", 0);
+/** Redis DB connections, created when the first device is initialized so that the packet
+ *  parsing logic can be used without a running redis (e.g. by the pcap replay benchmark) */
+std::shared_ptr<swss::DBConnector> mStateDbPtr;
+std::shared_ptr<swss::Table> mStateDbMuxTablePtr;
+std::shared_ptr<swss::DBConnector> mConfigDbPtr;
+std::shared_ptr<swss::DBConnector> mCountersDbPtr;
+std::shared_ptr<swss::RedisPipeline> mCountersDbPipelinePtr;
+std::shared_ptr<swss::Table> mCountersDbTablePtr;
+std::shared_ptr<swss::Table> mCountersDbLatencyTablePtr;
 
 /** Berkeley Packet Filter program for "udp and (port 67 or port 68)".
  * This program is obtained using the following command tcpdump:
@@ -110,6 +127,51 @@ static dhcp_message_type_t monitored_msgs[] = {
 /** Number of monitored DHCP message type */
 static uint8_t monitored_msg_sz = sizeof(monitored_msgs) / sizeof(*monitored_msgs);
 
+/** COUNTERS_DB field name prefix per packet direction */
+static const char *db_counter_dir_desc[DHCP_DIR_COUNT] = {
+    [DHCP_RX] = "RX_",
+    [DHCP_TX] = "TX_"
+};
+
+/** COUNTERS_DB field name suffix per DHCP message type */
+static const char *db_counter_msg_desc[DHCP_MESSAGE_TYPE_COUNT] = {
+    [0] = NULL,
+    [DHCP_MESSAGE_TYPE_DISCOVER] = "DISCOVER",
+    [DHCP_MESSAGE_TYPE_OFFER] = "OFFER",
+    [DHCP_MESSAGE_TYPE_REQUEST] = "REQUEST",
+    [DHCP_MESSAGE_TYPE_DECLINE] = "DECLINE",
+    [DHCP_MESSAGE_TYPE_ACK] = "ACK",
+    [DHCP_MESSAGE_TYPE_NAK] = "NAK",
+    [DHCP_MESSAGE_TYPE_RELEASE] = "RELEASE",
+    [DHCP_MESSAGE_TYPE_INFORM] = "INFORM"
+};
+
+/** COUNTERS_DB latency table key suffix per DHCP transaction type */
+static const char *txn_db_desc[DHCP_TXN_TYPE_COUNT] = {
+    [DHCP_TXN_DISCOVER_OFFER] = "DISCOVER_OFFER",
+    [DHCP_TXN_REQUEST_ACK] = "REQUEST_ACK"
+};
+
+/** DHCP relay latency statistics last written to COUNTERS_DB */
+static dhcp_txn_stats_t db_stats[DHCP_TXN_TYPE_COUNT];
+/** db_stats holds valid statistics */
+static bool db_stats_valid = false;
+
+/**
+ * @code get_xid(dhcphdr);
+ *
+ * @brief reads DHCP transaction id
+ *
+ * @param dhcphdr       pointer to DHCP header
+ *
+ * @return DHCP transaction id
+ */
+static inline uint32_t get_xid(const uint8_t *dhcphdr)
+{
+    return dhcphdr[DHCP_XID_OFFSET] << 24 | dhcphdr[DHCP_XID_OFFSET + 1] << 16 |
+           dhcphdr[DHCP_XID_OFFSET + 2] << 8 | dhcphdr[DHCP_XID_OFFSET + 3];
+}
+
 /**
  * @code handle_dhcp_option_53(context, dhcp_option, dir, iphdr, dhcphdr);
  *
@@ -144,6 +206,12 @@ static void handle_dhcp_option_53(dhcp_device_context_t *context,
             (!context->is_uplink && dir == DHCP_RX && iphdr->ip_dst.s_addr == INADDR_BROADCAST)) {
             context->counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
             aggregate_dev.counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
+            // client message received on downlink starts a relay round trip
+            if (!context->is_uplink && dhcp_option[2] == DHCP_MESSAGE_TYPE_DISCOVER) {
+                dhcp_txn_start(DHCP_TXN_DISCOVER_OFFER, get_xid(dhcphdr), dhcphdr + DHCP_CHADDR_OFFSET);
+            } else if (!context->is_uplink && dhcp_option[2] == DHCP_MESSAGE_TYPE_REQUEST) {
+                dhcp_txn_start(DHCP_TXN_REQUEST_ACK, get_xid(dhcphdr), dhcphdr + DHCP_CHADDR_OFFSET);
+            }
         }
         break;
     // DHCP messages send by server
@@ -154,6 +222,11 @@ static void handle_dhcp_option_53(dhcp_device_context_t *context,
             (!context->is_uplink && dir == DHCP_TX)) {
             context->counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
             aggregate_dev.counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
+            // server reply relayed out of downlink completes the round trip
+            if (!context->is_uplink) {
+                dhcp_txn_complete(dhcp_option[2] == DHCP_MESSAGE_TYPE_OFFER ? DHCP_TXN_DISCOVER_OFFER : DHCP_TXN_REQUEST_ACK,
+                                  get_xid(dhcphdr), dhcphdr + DHCP_CHADDR_OFFSET);
+            }
         }
         break;
     default:
@@ -162,6 +235,35 @@ static void handle_dhcp_option_53(dhcp_device_context_t *context,
     }
 }
 
+/**
+ * @code is_vlan_member_active(vlan_intf, member_intf);
+ *
+ * @brief default dual tor member filter. It looks up mux state in STATE_DB and VLAN membership in CONFIG_DB
+ *
+ * @param vlan_intf         vlan interface name
+ * @param member_ifindex    index of the interface the packet was received on
+ *
+ * @return true if member interface is an active member of the vlan, false otherwise
+ */
+static bool is_vlan_member_active(const char *vlan_intf, int member_ifindex)
+{
+    char member_intf[IF_NAMESIZE];
+
+    if (if_indextoname(member_ifindex, member_intf) == NULL) {
+        return false;
+    }
+
+    std::string member_table = std::string("VLAN_MEMBER|") + vlan_intf + "|" + member_intf;
+    std::string state;
+
+    mStateDbMuxTablePtr->hget(member_intf, "state", state);
+
+    return state != "standby" && mConfigDbPtr->exists(member_table);
+}
+
+/** Dual tor member filter applied to packets before they are counted */
+static dhcp_device_member_filter_t member_filter = is_vlan_member_active;
+
 /**
  * @code read_callback(fd, event, arg);
  *
@@ -180,54 +282,7 @@ static void read_callback(int fd, short event, void *arg)
 
     while ((event == EV_READ) &&
            ((buffer_sz = recv(fd, context->buffer, context->snaplen, MSG_DONTWAIT)) > 0)) {
-        struct ether_header *ethhdr = (struct ether_header*) context->buffer;
-        struct ip *iphdr = (struct ip*) (context->buffer + IP_START_OFFSET);
-        struct udphdr *udp = (struct udphdr*) (context->buffer + UDP_START_OFFSET);
-        uint8_t *dhcphdr = context->buffer + DHCP_START_OFFSET;
-        int dhcp_option_offset = DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE;
-
-        if (((unsigned)buffer_sz > UDP_START_OFFSET + sizeof(struct udphdr) + DHCP_OPTIONS_HEADER_SIZE) &&
-            (ntohs(udp->len) > DHCP_OPTIONS_HEADER_SIZE)) {
-            int dhcp_sz = ntohs(udp->len) < buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr) ?
-                          ntohs(udp->len) : buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr);
-            int dhcp_option_sz = dhcp_sz - DHCP_OPTIONS_HEADER_SIZE;
-            const u_char *dhcp_option = context->buffer + dhcp_option_offset;
-            dhcp_packet_direction_t dir = (ethhdr->ether_shost[0] == context->mac[0] &&
-                                           ethhdr->ether_shost[1] == context->mac[1] &&
-                                           ethhdr->ether_shost[2] == context->mac[2] &&
-                                           ethhdr->ether_shost[3] == context->mac[3] &&
-                                           ethhdr->ether_shost[4] == context->mac[4] &&
-                                           ethhdr->ether_shost[5] == context->mac[5]) ?
-                                           DHCP_TX : DHCP_RX;
-            int offset = 0;
-            int stop_dhcp_processing = 0;
-            while ((offset < (dhcp_option_sz + 1)) && dhcp_option[offset] != 255) {
-                switch (dhcp_option[offset])
-                {
-                case 53:
-                    if (offset < (dhcp_option_sz + 2)) {
-                        handle_dhcp_option_53(context, &dhcp_option[offset], dir, iphdr, dhcphdr);
-                    }
-                    stop_dhcp_processing = 1; // break while loop since we are only interested in Option 53
-                    break;
-                default:
-                    break;
-                }
-
-                if (stop_dhcp_processing == 1) {
-                    break;
-                }
-
-                if (dhcp_option[offset] == 0) { // DHCP Option Padding
-                    offset++;
-                } else {
-                    offset += dhcp_option[offset + 1] + 2;
-                }
-            }
-        } else {
-            syslog(LOG_WARNING, "read_callback(%s): read length (%ld) is too small to capture DHCP options",
-                   context->intf, buffer_sz);
-        }
+        dhcp_device_handle_packet(context, context->buffer, buffer_sz);
     }
 }
 
@@ -252,63 +307,7 @@ static void read_callback_dual_tor(int fd, short event, void *arg)
     while ((event == EV_READ) &&
            ((buffer_sz = recvfrom(fd, context->buffer, context->snaplen, MSG_DONTWAIT, (struct sockaddr *)&sll, &slen)) > 0)) 
     {
-        std::string member_table = std::string("VLAN_MEMBER|") + context->intf + "|";
-        char interfaceName[IF_NAMESIZE];
-        char *interface = if_indextoname(sll.sll_ifindex, interfaceName);
-        std::string state;
-        std::string intf(interface);
-        mStateDbMuxTablePtr->hget(intf, "state", state);
-        if (state != "standby" && configDb.exists(member_table.append(interface))) {
-            struct ether_header *ethhdr = (struct ether_header*) context->buffer;
-            struct ip *iphdr = (struct ip*) (context->buffer + IP_START_OFFSET);
-            struct udphdr *udp = (struct udphdr*) (context->buffer + UDP_START_OFFSET);
-            uint8_t *dhcphdr = context->buffer + DHCP_START_OFFSET;
-            int dhcp_option_offset = DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE;
-
-            if (((unsigned)buffer_sz > UDP_START_OFFSET + sizeof(struct udphdr) + DHCP_OPTIONS_HEADER_SIZE) &&
-                (ntohs(udp->len) > DHCP_OPTIONS_HEADER_SIZE)) 
-            {
-                int dhcp_sz = ntohs(udp->len) < buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr) ?
-                            ntohs(udp->len) : buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr);
-                int dhcp_option_sz = dhcp_sz - DHCP_OPTIONS_HEADER_SIZE;
-                const u_char *dhcp_option = context->buffer + dhcp_option_offset;
-                dhcp_packet_direction_t dir = (ethhdr->ether_shost[0] == context->mac[0] &&
-                                            ethhdr->ether_shost[1] == context->mac[1] &&
-                                            ethhdr->ether_shost[2] == context->mac[2] &&
-                                            ethhdr->ether_shost[3] == context->mac[3] &&
-                                            ethhdr->ether_shost[4] == context->mac[4] &&
-                                            ethhdr->ether_shost[5] == context->mac[5]) ?
-                                            DHCP_TX : DHCP_RX;
-                int offset = 0;
-                int stop_dhcp_processing = 0;
-                while ((offset < (dhcp_option_sz + 1)) && dhcp_option[offset] != 255) {
-                    switch (dhcp_option[offset])
-                    {
-                    case 53:
-                        if (offset < (dhcp_option_sz + 2)) {
-                            handle_dhcp_option_53(context, &dhcp_option[offset], dir, iphdr, dhcphdr);
-                        }
-                        stop_dhcp_processing = 1; // break while loop since we are only interested in Option 53
-                        break;
-                    default:
-                        break;
-                    }
-
-                    if (stop_dhcp_processing == 1) {
-                        break;
-                    }
-
-                    if (dhcp_option[offset] == 0) { // DHCP Option Padding
-                        offset++;
-                    } else {
-                        offset += dhcp_option[offset + 1] + 2;
-                    }
-                }
-            } else {
-                syslog(LOG_WARNING, "read_callback(%s): read length (%ld) is too small to capture DHCP options",
-                    context->intf, buffer_sz);
-            }
-        }
+        dhcp_device_handle_packet_dual_tor(context, context->buffer, buffer_sz, sll.sll_ifindex);
     }
 }
 
@@ -520,6 +519,30 @@ static int init_socket(dhcp_device_context_t *context, const char *intf)
     return rv;
 }
 
+/**
+ * @code init_db_connections();
+ *
+ * @brief connects to STATE_DB, CONFIG_DB and COUNTERS_DB unless already connected
+ *
+ * @return none
+ */
+static void init_db_connections()
+{
+    if (mStateDbPtr == nullptr) {
+        mStateDbPtr = std::make_shared<swss::DBConnector> ("STATE_DB", 0);
+        mStateDbMuxTablePtr = std::make_shared<swss::Table> (mStateDbPtr.get(), "HW_MUX_CABLE_TABLE");
+        mConfigDbPtr = std::make_shared<swss::DBConnector> ("CONFIG_DB", 0);
+        mCountersDbPtr = std::make_shared<swss::DBConnector> ("COUNTERS_DB", 0);
+        mCountersDbPipelinePtr = std::make_shared<swss::RedisPipeline> (mCountersDbPtr.get());
+        mCountersDbTablePtr = std::make_shared<swss::Table> (
+            mCountersDbPipelinePtr.get(), "DHCP_MON_COUNTERS_TABLE", true
+        );
+        mCountersDbLatencyTablePtr = std::make_shared<swss::Table> (
+            mCountersDbPipelinePtr.get(), "DHCP_MON_LATENCY_TABLE", true
+        );
+    }
+}
+
 /**
  * @code initialize_intf_mac_and_ip_addr(context);
  *
@@ -600,6 +623,89 @@ dhcp_device_context_t* dhcp_device_get_aggregate_context()
     return &aggregate_dev;
 }
 
+/**
+ * @code dhcp_device_set_member_filter(filter);
+ *
+ * @brief Sets dual tor member filter
+ */
+void dhcp_device_set_member_filter(dhcp_device_member_filter_t filter)
+{
+    member_filter = filter != NULL ? filter : is_vlan_member_active;
+}
+
+/**
+ * @code dhcp_device_handle_packet(context, buffer, buffer_sz);
+ *
+ * @brief parses captured DHCP packet and updates device (interface) counters
+ */
+void dhcp_device_handle_packet(dhcp_device_context_t *context, const uint8_t *buffer, ssize_t buffer_sz)
+{
+    struct ether_header *ethhdr = (struct ether_header*) buffer;
+    struct ip *iphdr = (struct ip*) (buffer + IP_START_OFFSET);
+    struct udphdr *udp = (struct udphdr*) (buffer + UDP_START_OFFSET);
+    uint8_t *dhcphdr = (uint8_t *) buffer + DHCP_START_OFFSET;
+    int dhcp_option_offset = DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE;
+
+    if (((unsigned)buffer_sz > UDP_START_OFFSET + sizeof(struct udphdr) + DHCP_OPTIONS_HEADER_SIZE) &&
+        (ntohs(udp->len) > DHCP_OPTIONS_HEADER_SIZE)) {
+        int dhcp_sz = ntohs(udp->len) < buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr) ?
+                      ntohs(udp->len) : buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr);
+        int dhcp_option_sz = dhcp_sz - DHCP_OPTIONS_HEADER_SIZE;
+        const u_char *dhcp_option = buffer + dhcp_option_offset;
+        dhcp_packet_direction_t dir = (ethhdr->ether_shost[0] == context->mac[0] &&
+                                       ethhdr->ether_shost[1] == context->mac[1] &&
+                                       ethhdr->ether_shost[2] == context->mac[2] &&
+                                       ethhdr->ether_shost[3] == context->mac[3] &&
+                                       ethhdr->ether_shost[4] == context->mac[4] &&
+                                       ethhdr->ether_shost[5] == context->mac[5]) ?
+                                       DHCP_TX : DHCP_RX;
+        int offset = 0;
+        int stop_dhcp_processing = 0;
+        while ((offset < (dhcp_option_sz + 1)) && dhcp_option[offset] != 255) {
+            switch (dhcp_option[offset])
+            {
+            case 53:
+                if (offset < (dhcp_option_sz + 2)) {
+                    handle_dhcp_option_53(context, &dhcp_option[offset], dir, iphdr, dhcphdr);
+                }
+                stop_dhcp_processing = 1; // break while loop since we are only interested in Option 53
+                break;
+            default:
+                break;
+            }
+
+            if (stop_dhcp_processing == 1) {
+                break;
+            }
+
+            if (dhcp_option[offset] == 0) { // DHCP Option Padding
+                offset++;
+            } else {
+                offset += dhcp_option[offset + 1] + 2;
+            }
+        }
+    } else {
+        syslog(LOG_WARNING, "read_callback(%s): read length (%ld) is too small to capture DHCP options",
+               context->intf, buffer_sz);
+    }
+}
+
+/**
+ * @code dhcp_device_handle_packet_dual_tor(context, buffer, buffer_sz, member_ifindex);
+ *
+ * @brief parses captured DHCP packet and updates device (interface) counters if the packet was received on
+ *        an active vlan member interface
+ */
+void dhcp_device_handle_packet_dual_tor(dhcp_device_context_t *context,
+                                        const uint8_t *buffer,
+                                        ssize_t buffer_sz,
+                                        int member_ifindex)
+{
+    if (member_filter(context->intf, member_ifindex)) {
+        dhcp_device_handle_packet(context, buffer, buffer_sz);
+    }
+}
+
 /**
  * @code dhcp_device_init(context, intf, is_uplink);
  *
@@ -612,17 +718,29 @@ int dhcp_device_init(dhcp_device_context_t **context, const char *intf, uint8_t
 
     if ((context != NULL) && (strlen(intf) < sizeof(dev_context->intf))) {
 
+        init_db_connections();
+
         dev_context = (dhcp_device_context_t *) malloc(sizeof(dhcp_device_context_t));
         if (dev_context != NULL) {
             if ((init_socket(dev_context, intf) == 0) &&
                 (initialize_intf_mac_and_ip_addr(dev_context) == 0)) {
 
                 dev_context->is_uplink = is_uplink;
+                dev_context->buffer = NULL;
+                dev_context->ev = NULL;
 
                 memset(dev_context->counters, 0, sizeof(dev_context->counters));
+                memset(dev_context->rate_counters, 0, sizeof(dev_context->rate_counters));
+                memset(dev_context->rates, 0, sizeof(dev_context->rates));
+                memset(dev_context->db_counters, 0xff, sizeof(dev_context->db_counters));
 
                 *context = dev_context;
                 rv = 0;
+            } else {
+                if (dev_context->sock >= 0) {
+                    close(dev_context->sock);
+                }
+                free(dev_context);
             }
         }
         else {
@@ -681,6 +799,7 @@ int dhcp_device_start_capture(dhcp_device_context_t *context,
             break;
         }
         event_add(ev, NULL);
+        context->ev = ev;
 
         rv = 0;
     } while (0);
@@ -695,7 +814,15 @@ int dhcp_device_start_capture(dhcp_device_context_t *context,
  */
 void dhcp_device_shutdown(dhcp_device_context_t *context)
 {
-    free(context);
+    if (context != NULL) {
+        dhcp_device_del_counters_db(context);
+        if (context->ev != NULL) {
+            event_free(context->ev);
+        }
+        close(context->sock);
+        free(context->buffer);
+        free(context);
+    }
 }
 
 /**
@@ -715,6 +842,114 @@ dhcp_mon_status_t dhcp_device_get_status(dhcp_mon_check_t check_type, dhcp_devic
     return rv;
 }
 
+/**
+ * @code dhcp_device_update_rates(context, interval_sec, alpha);
+ *
+ * @brief samples device/interface counters and updates their smoothed rates
+ */
+void dhcp_device_update_rates(dhcp_device_context_t *context, int interval_sec, double alpha)
+{
+    if (context != NULL && interval_sec > 0) {
+        uint64_t (*counters)[DHCP_MESSAGE_TYPE_COUNT] = context->counters[DHCP_COUNTERS_CURRENT];
+
+        for (uint8_t dir = 0; dir < DHCP_DIR_COUNT; dir++) {
+            for (uint8_t type = 0; type < DHCP_MESSAGE_TYPE_COUNT; type++) {
+                double rate = (double) (counters[dir][type] - context->rate_counters[dir][type]) / interval_sec;
+                context->rates[dir][type] = alpha * rate + (1 - alpha) * context->rates[dir][type];
+            }
+        }
+
+        memcpy(context->rate_counters, counters, sizeof(context->rate_counters));
+    }
+}
+
+/**
+ * @code dhcp_device_get_rate_status(context, thresholds);
+ *
+ * @brief collects DHCP relay status of a given interface using smoothed rx/tx rates of relayed messages
+ */
+dhcp_mon_status_t dhcp_device_get_rate_status(dhcp_device_context_t *context,
+                                              const dhcp_mon_rate_thresholds_t *thresholds)
+{
+    dhcp_mon_status_t rv = DHCP_MON_STATUS_INDETERMINATE;
+
+    if (context != NULL) {
+        for (uint8_t i = 0; (i < monitored_msg_sz) && (rv != DHCP_MON_STATUS_UNHEALTHY); i++) {
+            double rx_rate = context->rates[DHCP_RX][monitored_msgs[i]];
+            double tx_rate = context->rates[DHCP_TX][monitored_msgs[i]];
+
+            // quiet message types are left to the window based health check
+            if (rx_rate >= thresholds->min_rx_rate) {
+                rv = (tx_rate / rx_rate < thresholds->min_relay_ratio) ?
+                     DHCP_MON_STATUS_UNHEALTHY : DHCP_MON_STATUS_HEALTHY;
+            }
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * @code get_rate_threshold(table, vlan, field, min, max, value);
+ *
+ * @brief reads a vlan rate based health check threshold from CONFIG_DB. Values that do not parse or are out of
+ *        range are logged and ignored
+ *
+ * @param table         CONFIG_DB DHCP_MON_THRESHOLD table
+ * @param vlan          vlan interface name
+ * @param field         threshold field name
+ * @param min           min valid value
+ * @param max           max valid value
+ * @param value(inout)  threshold value, left unchanged unless a valid value is found
+ *
+ * @return none
+ */
+static void get_rate_threshold(swss::Table &table, const char *vlan, const char *field,
+                               double min, double max, double *value)
+{
+    std::string str;
+
+    if (table.hget(vlan, field, str)) {
+        bool valid = false;
+
+        try {
+            double parsed = std::stod(str);
+            // comparisons with nan are false, so nan is rejected too
+            if (parsed >= min && parsed <= max) {
+                *value = parsed;
+                valid = true;
+            }
+        } catch (const std::exception &e) {
+        }
+
+        if (!valid) {
+            syslog(LOG_WARNING, "dhcp_device_get_rate_thresholds(%s): ignoring invalid %s '%s' in CONFIG_DB, "
+                   "valid range is [%g, %g]", vlan, field, str.c_str(), min, max);
+        }
+    }
+}
+
+/**
+ * @code dhcp_device_get_rate_thresholds(vlan, thresholds);
+ *
+ * @brief reads vlan rate based health check thresholds from CONFIG_DB
+ */
+void dhcp_device_get_rate_thresholds(const char *vlan, dhcp_mon_rate_thresholds_t *thresholds)
+{
+    if (mConfigDbPtr == nullptr) {
+        return;
+    }
+
+    swss::Table table(mConfigDbPtr.get(), "DHCP_MON_THRESHOLD");
+    double max_unhealthy_sec = thresholds->max_unhealthy_sec;
+
+    get_rate_threshold(table, vlan, "alpha", DHCP_RATE_ALPHA_MIN, 1, &thresholds->alpha);
+    get_rate_threshold(table, vlan, "min_rx_rate", 0, DHCP_RATE_MAX, &thresholds->min_rx_rate);
+    get_rate_threshold(table, vlan, "min_relay_ratio", 0, 1, &thresholds->min_relay_ratio);
+    get_rate_threshold(table, vlan, "max_unhealthy_sec", 1, DHCP_RATE_MAX_UNHEALTHY_SEC, &max_unhealthy_sec);
+    thresholds->max_unhealthy_sec = (int) max_unhealthy_sec;
+}
+
 /**
  * @code dhcp_device_update_snapshot(context);
  *
@@ -729,6 +964,115 @@ void dhcp_device_update_snapshot(dhcp_device_context_t *context)
     }
 }
 
+/**
+ * @code dhcp_device_update_counters_db(context);
+ *
+ * @brief queues device/interface counters into COUNTERS_DB pipeline if they changed since last update
+ */
+void dhcp_device_update_counters_db(dhcp_device_context_t *context)
+{
+    if (context != NULL && context->intf[0] != '\0' && mCountersDbTablePtr != nullptr) {
+        // counters are updated by the packet path on this same event loop, so a plain copy is a consistent snapshot
+        uint64_t (*counters)[DHCP_MESSAGE_TYPE_COUNT] = context->counters[DHCP_COUNTERS_CURRENT];
+
+        if (memcmp(context->db_counters, counters, sizeof(context->db_counters)) != 0) {
+            std::vector<swss::FieldValueTuple> fvs;
+
+            for (uint8_t dir = 0; dir < DHCP_DIR_COUNT; dir++) {
+                for (uint8_t type = DHCP_MESSAGE_TYPE_DISCOVER; type < DHCP_MESSAGE_TYPE_COUNT; type++) {
+                    fvs.emplace_back(std::string(db_counter_dir_desc[dir]) + db_counter_msg_desc[type],
+                                     std::to_string(counters[dir][type]));
+                }
+            }
+            mCountersDbTablePtr->set(context->intf, fvs);
+
+            memcpy(context->db_counters, counters, sizeof(context->db_counters));
+        }
+    }
+}
+
+/**
+ * @code dhcp_device_del_counters_db(context);
+ *
+ * @brief removes device/interface counters from COUNTERS_DB
+ */
+void dhcp_device_del_counters_db(dhcp_device_context_t *context)
+{
+    if (context != NULL && context->intf[0] != '\0' && mCountersDbTablePtr != nullptr) {
+        mCountersDbTablePtr->del(context->intf);
+        mCountersDbTablePtr->flush();
+
+        memset(context->db_counters, 0xff, sizeof(context->db_counters));
+    }
+}
+
+/**
+ * @code dhcp_device_update_latency_db(vlan);
+ *
+ * @brief queues DHCP relay round trip latency histograms into COUNTERS_DB pipeline
+ */
+void dhcp_device_update_latency_db(const char *vlan)
+{
+    if (mCountersDbLatencyTablePtr == nullptr) {
+        return;
+    }
+
+    for (uint8_t type = 0; type < DHCP_TXN_TYPE_COUNT; type++) {
+        const dhcp_txn_stats_t *stats = dhcp_txn_get_stats((dhcp_txn_type_t) type);
+        std::vector<swss::FieldValueTuple> fvs;
+
+        if (db_stats_valid && memcmp(&db_stats[type], stats, sizeof(*stats)) == 0) {
+            continue;
+        }
+        db_stats[type] = *stats;
+
+        for (int bucket = 0; bucket < DHCP_TXN_HISTOGRAM_BUCKETS; bucket++) {
+            uint32_t limit = dhcp_txn_get_bucket_limit(bucket);
+            std::string field = limit ? "LT_" + std::to_string(limit) + "MS" :
+                                        "GE_" + std::to_string(dhcp_txn_get_bucket_limit(bucket - 1)) + "MS";
+            fvs.emplace_back(field, std::to_string(stats->buckets[bucket]));
+        }
+        fvs.emplace_back("COMPLETED", std::to_string(stats->completed));
+        fvs.emplace_back("LATENCY_SUM_USEC", std::to_string(stats->latency_sum_usec));
+        fvs.emplace_back("INCOMPLETE", std::to_string(stats->incomplete));
+        fvs.emplace_back("DROPPED", std::to_string(stats->dropped));
+
+        mCountersDbLatencyTablePtr->set(std::string(vlan) + "|" + txn_db_desc[type], fvs);
+    }
+    db_stats_valid = true;
+}
+
+/**
+ * @code dhcp_device_del_latency_db(vlan);
+ *
+ * @brief removes DHCP relay round trip latency histograms of a vlan from COUNTERS_DB
+ */
+void dhcp_device_del_latency_db(const char *vlan)
+{
+    if (mCountersDbLatencyTablePtr == nullptr) {
+        return;
+    }
+
+    for (uint8_t type = 0; type < DHCP_TXN_TYPE_COUNT; type++) {
+        mCountersDbLatencyTablePtr->del(std::string(vlan) + "|" + txn_db_desc[type]);
+    }
+    mCountersDbLatencyTablePtr->flush();
+
+    db_stats_valid = false;
+}
+
+/**
+ * @code dhcp_device_flush_counters_db();
+ *
+ * @brief writes queued device/interface counters to COUNTERS_DB in one pipelined batch
+ */
+void dhcp_device_flush_counters_db()
+{
+    if (mCountersDbTablePtr != nullptr) {
+        mCountersDbTablePtr->flush();
+    }
+}
+
 /**
  * @code dhcp_device_print_status(context, type);
  *
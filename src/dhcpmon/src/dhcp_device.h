@@ -68,6 +68,15 @@ typedef enum
     DHCP_MON_CHECK_POSITIVE,    /** Validate that received DORA packets are relayed */
 } dhcp_mon_check_t;
 
+/** DHCP relay rate based health check thresholds */
+typedef struct
+{
+    double alpha;                   /** EWMA smoothing factor of per second packet rates, in [0.01, 1] */
+    double min_rx_rate;             /** min smoothed rx rate (packets/sec) for rate based check to apply */
+    double min_relay_ratio;         /** min smoothed tx/rx ratio of a relayed message type to be healthy, in [0, 1] */
+    int max_unhealthy_sec;          /** max seconds of consecutive unhealthy rates before reporting to syslog */
+} dhcp_mon_rate_thresholds_t;
+
 /** DHCP device (interface) context */
 typedef struct
 {
@@ -79,10 +88,23 @@ typedef struct
     char intf[IF_NAMESIZE];         /** device (interface) name */
     uint8_t *buffer;                /** buffer used to read socket data */
     size_t snaplen;                 /** snap length or buffer size */
+    struct event *ev;               /** libevent read event of the raw socket */
     uint64_t counters[DHCP_COUNTERS_COUNT][DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
                                     /** current/snapshot counters of DHCP packets */
+    uint64_t db_counters[DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
+                                    /** counters of DHCP packets last written to COUNTERS_DB */
+    uint64_t rate_counters[DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
+                                    /** counters of DHCP packets at last rate sample */
+    double rates[DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
+                                    /** EWMA of DHCP packets rates (packets/sec) */
 } dhcp_device_context_t;
 
+/**
+ * Dual tor member filter, returns true if packets received on interface member_ifindex should be counted for
+ * vlan_intf
+ */
+typedef bool (*dhcp_device_member_filter_t)(const char *vlan_intf, int member_ifindex);
+
 /**
  * @code initialize_intf_mac_and_ip_addr(context);
  *
@@ -115,6 +137,48 @@ int dhcp_device_get_ip(dhcp_device_context_t *context, in_addr_t *ip);
  */
 dhcp_device_context_t* dhcp_device_get_aggregate_context();
 
+/**
+ * @code dhcp_device_set_member_filter(filter);
+ *
+ * @brief Sets dual tor member filter. Default filter looks up mux state and vlan membership in redis.
+ *
+ * @param filter        member filter, NULL restores the default filter
+ *
+ * @return none
+ */
+void dhcp_device_set_member_filter(dhcp_device_member_filter_t filter);
+
+/**
+ * @code dhcp_device_handle_packet(context, buffer, buffer_sz);
+ *
+ * @brief parses captured DHCP packet and updates device (interface) counters
+ *
+ * @param context       pointer to device (interface) context
+ * @param buffer        captured packet starting with Ethernet header
+ * @param buffer_sz     captured packet length
+ *
+ * @return none
+ */
+void dhcp_device_handle_packet(dhcp_device_context_t *context, const uint8_t *buffer, ssize_t buffer_sz);
+
+/**
+ * @code dhcp_device_handle_packet_dual_tor(context, buffer, buffer_sz, member_ifindex);
+ *
+ * @brief parses captured DHCP packet and updates device (interface) counters if the packet was received on
+ *        an active vlan member interface
+ *
+ * @param context           pointer to device (interface) context
+ * @param buffer            captured packet starting with Ethernet header
+ * @param buffer_sz         captured packet length
+ * @param member_ifindex    index of the interface the packet was received on
+ *
+ * @return none
+ */
+void dhcp_device_handle_packet_dual_tor(dhcp_device_context_t *context,
+                                        const uint8_t *buffer,
+                                        ssize_t buffer_sz,
+                                        int member_ifindex);
+
 /**
  * @code dhcp_device_init(context, intf, is_uplink);
  *
@@ -171,6 +235,46 @@ void dhcp_device_shutdown(dhcp_device_context_t *context);
  */
 dhcp_mon_status_t dhcp_device_get_status(dhcp_mon_check_t check_type, dhcp_device_context_t *context);
 
+/**
+ * @code dhcp_device_update_rates(context, interval_sec, alpha);
+ *
+ * @brief samples device/interface counters and updates their smoothed rates
+ *
+ * @param context       Device (interface) context
+ * @param interval_sec  time elapsed since previous sample
+ * @param alpha         EWMA smoothing factor
+ *
+ * @return none
+ */
+void dhcp_device_update_rates(dhcp_device_context_t *context, int interval_sec, double alpha);
+
+/**
+ * @code dhcp_device_get_rate_status(context, thresholds);
+ *
+ * @brief collects DHCP relay status of a given interface using smoothed rx/tx rates of relayed messages
+ *
+ * @param context       Device (interface) context
+ * @param thresholds    rate based health check thresholds
+ *
+ * @return DHCP_MON_STATUS_HEALTHY, DHCP_MON_STATUS_UNHEALTHY, or DHCP_MON_STATUS_INDETERMINATE when rx rates are
+ *         too low for the check to be meaningful
+ */
+dhcp_mon_status_t dhcp_device_get_rate_status(dhcp_device_context_t *context,
+                                              const dhcp_mon_rate_thresholds_t *thresholds);
+
+/**
+ * @code dhcp_device_get_rate_thresholds(vlan, thresholds);
+ *
+ * @brief reads vlan rate based health check thresholds from CONFIG_DB. Fields missing from CONFIG_DB, or whose
+ *        values are not valid numbers or are out of range, are left unchanged
+ *
+ * @param vlan              vlan interface name
+ * @param thresholds(inout) rate based health check thresholds
+ *
+ * @return none
+ */
+void dhcp_device_get_rate_thresholds(const char *vlan, dhcp_mon_rate_thresholds_t *thresholds);
+
 /**
  * @code dhcp_device_update_snapshot(context);
  *
@@ -180,6 +284,60 @@ dhcp_mon_status_t dhcp_device_get_status(dhcp_mon_check_t check_type, dhcp_devic
  */
 void dhcp_device_update_snapshot(dhcp_device_context_t *context);
 
+/**
+ * @code dhcp_device_update_counters_db(context);
+ *
+ * @brief queues device/interface counters into COUNTERS_DB pipeline if they changed since last update
+ *
+ * @param context   Device (interface) context
+ *
+ * @return none
+ */
+void dhcp_device_update_counters_db(dhcp_device_context_t *context);
+
+/**
+ * @code dhcp_device_del_counters_db(context);
+ *
+ * @brief removes device/interface counters from COUNTERS_DB. Called when the device is shut down so that
+ *        removed interfaces do not leave stale keys behind
+ *
+ * @param context   Device (interface) context
+ *
+ * @return none
+ */
+void dhcp_device_del_counters_db(dhcp_device_context_t *context);
+
+/**
+ * @code dhcp_device_update_latency_db(vlan);
+ *
+ * @brief queues DHCP relay round trip latency histograms into COUNTERS_DB pipeline
+ *
+ * @param vlan      vlan interface name
+ *
+ * @return none
+ */
+void dhcp_device_update_latency_db(const char *vlan);
+
+/**
+ * @code dhcp_device_del_latency_db(vlan);
+ *
+ * @brief removes DHCP relay round trip latency histograms of a vlan from COUNTERS_DB
+ *
+ * @param vlan      vlan interface name
+ *
+ * @return none
+ */
+void dhcp_device_del_latency_db(const char *vlan);
+
+/**
+ * @code dhcp_device_flush_counters_db();
+ *
+ * @brief writes queued device/interface counters to COUNTERS_DB in one pipelined batch
+ *
+ * @return none
+ */
+void dhcp_device_flush_counters_db();
+
 /**
  * @code dhcp_device_print_status(context, type);
  *
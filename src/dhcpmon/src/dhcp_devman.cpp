@@ -7,10 +7,16 @@
 #include <errno.h>
 #include <string.h>
 #include <syslog.h>
-#include <sys/queue.h>
 #include <stdlib.h>
+#include <net/if.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "subscriberstatetable.h"
 
 #include "dhcp_devman.h"
+#include "dhcp_txn.h"
 
 /** Prefix appended to Aggregation device */
 #define AGG_DEV_PREFIX  "Agg-"
@@ -18,14 +24,17 @@
 /** struct for interface information */
 struct intf
 {
-    const char *name;                   /** interface name */
+    char name[IF_NAMESIZE];             /** interface name */
+    char intf_type;                     /** 'u' uplink, 'd' downlink, 'm' mgmt or 'v' downlink vlan member */
+    int ifindex;                        /** interface index, 0 if the interface does not exist */
     uint8_t is_uplink;                  /** is uplink (north) interface */
-    dhcp_device_context_t *dev_context; /** device (interface_ context */
-    LIST_ENTRY(intf) entry;             /** list link/pointers entries */
+    dhcp_device_context_t *dev_context; /** device (interface_ context, NULL for vlan members */
 };
 
-/** intfs list of interfaces */
-static LIST_HEAD(intf_list, intf) intfs;
+/** intfs interfaces indexed by name */
+static std::unordered_map<std::string, struct intf*> intfs;
+/** intfs_by_ifindex interfaces indexed by interface index, used to resolve the receive interface of packets */
+static std::unordered_map<int, struct intf*> intfs_by_ifindex;
 /** dhcp_num_south_intf number of south interfaces */
 static uint32_t dhcp_num_south_intf = 0;
 /** dhcp_num_north_intf number of north interfaces */
@@ -46,6 +55,62 @@ static int dual_tor_mode = 0;
 /** mgmt interface */
 static struct intf *mgmt_intf = NULL;
 
+/** downlink (south) vlan interface */
+static struct intf *south_intf = NULL;
+
+/** Dual tor vlan membership and mux state subscriptions, they keep the 'v' interfaces and standby_intfs in sync
+ *  with CONFIG_DB VLAN_MEMBER and STATE_DB HW_MUX_CABLE_TABLE so that the packet path does not query redis */
+static std::shared_ptr<swss::DBConnector> config_db;
+static std::shared_ptr<swss::SubscriberStateTable> vlan_member_table;
+static struct event *ev_vlan_member = NULL;
+static std::shared_ptr<swss::DBConnector> state_db;
+static std::shared_ptr<swss::SubscriberStateTable> mux_cable_table;
+static struct event *ev_mux_cable = NULL;
+
+/** standby_intfs vlan members in standby mux state */
+static std::unordered_set<std::string> standby_intfs;
+
+/**
+ * @code remove_intf(dev);
+ *
+ * @brief stops packet capture on an interface and removes it from the device manager
+ *
+ * @param dev               interface
+ *
+ * @return none
+ */
+static void remove_intf(struct intf *dev)
+{
+    switch (dev->intf_type)
+    {
+    case 'u':
+        dhcp_num_north_intf--;
+        break;
+    case 'd':
+        dhcp_num_south_intf--;
+        south_intf = NULL;
+        // aggregate device and latency histograms are named after the south interface
+        dhcp_device_del_counters_db(dhcp_device_get_aggregate_context());
+        dhcp_device_get_aggregate_context()->intf[0] = '\0';
+        dhcp_device_del_latency_db(dev->name);
+        break;
+    case 'm':
+        dhcp_num_mgmt_intf--;
+        mgmt_intf = NULL;
+        break;
+    default:
+        break;
+    }
+
+    intfs.erase(dev->name);
+    if (dev->ifindex != 0) {
+        intfs_by_ifindex.erase(dev->ifindex);
+    }
+
+    dhcp_device_shutdown(dev->dev_context);
+    free(dev);
+}
+
 /**
  * @code dhcp_devman_get_vlan_intf();
  *
@@ -74,7 +139,8 @@ dhcp_device_context_t* dhcp_devman_get_mgmt_dev()
  */
 void dhcp_devman_init()
 {
-    LIST_INIT(&intfs);
+    intfs.clear();
+    intfs_by_ifindex.clear();
 }
 
 /**
@@ -85,20 +151,20 @@ void dhcp_devman_init()
  */
 void dhcp_devman_shutdown()
 {
-    struct intf *int_ptr, *prev_intf = NULL;
-
-    LIST_FOREACH(int_ptr, &intfs, entry) {
-        dhcp_device_shutdown(int_ptr->dev_context);
-        if (prev_intf) {
-            LIST_REMOVE(prev_intf, entry);
-            free(prev_intf);
-            prev_intf = int_ptr;
-        }
+    if (ev_vlan_member != NULL) {
+        event_free(ev_vlan_member);
+        ev_vlan_member = NULL;
+    }
+    if (ev_mux_cable != NULL) {
+        event_free(ev_mux_cable);
+        ev_mux_cable = NULL;
     }
+    vlan_member_table = nullptr;
+    mux_cable_table = nullptr;
+    standby_intfs.clear();
 
-    if (prev_intf) {
-        LIST_REMOVE(prev_intf, entry);
-        free(prev_intf);
+    while (!intfs.empty()) {
+        remove_intf(intfs.begin()->second);
     }
 }
 
@@ -110,11 +176,42 @@ void dhcp_devman_shutdown()
 int dhcp_devman_add_intf(const char *name, char intf_type)
 {
     int rv = -1;
-    struct intf *dev = (struct intf*) malloc(sizeof(struct intf));
+    struct intf *dev;
+
+    if (name == NULL || strlen(name) >= IF_NAMESIZE) {
+        syslog(LOG_ALERT, "invalid interface name '%s'\n", name ? name : "");
+        return rv;
+    }
 
+    auto it = intfs.find(name);
+    if (it != intfs.end()) {
+        syslog(LOG_ERR, "interface '%s' type '%c' is already added with type '%c'\n",
+               name, intf_type, it->second->intf_type);
+        return rv;
+    }
+
+    dev = (struct intf*) malloc(sizeof(struct intf));
     if (dev != NULL) {
-        dev->name = name;
-        dev->is_uplink = intf_type != 'd';
+        strncpy(dev->name, name, sizeof(dev->name) - 1);
+        dev->name[sizeof(dev->name) - 1] = '\0';
+        dev->intf_type = intf_type;
+        dev->is_uplink = intf_type != 'd' && intf_type != 'v';
+        dev->ifindex = if_nametoindex(dev->name);
+        if (dev->ifindex == 0 && intf_type == 'v') {
+            // packets are matched to members by the receive interface index
+            syslog(LOG_WARNING, "vlan member '%s' does not exist, its packets are not counted\n", dev->name);
+        }
+        dev->dev_context = NULL;
+
+        // vlan members are only tracked for the dual tor member filter, their packets are captured on the vlan
+        if (intf_type != 'v') {
+            rv = dhcp_device_init(&dev->dev_context, dev->name, dev->is_uplink);
+            if (rv != 0) {
+                free(dev);
+                return rv;
+            }
+        }
+        rv = 0;
 
         switch (intf_type)
         {
@@ -124,6 +221,7 @@ int dhcp_devman_add_intf(const char *name, char intf_type)
         case 'd':
             dhcp_num_south_intf++;
             assert(dhcp_num_south_intf <= 1);
+            south_intf = dev;
             break;
         case 'm':
             dhcp_num_mgmt_intf++;
@@ -134,18 +232,21 @@ int dhcp_devman_add_intf(const char *name, char intf_type)
             break;
         }
 
-        rv = dhcp_device_init(&dev->dev_context, dev->name, dev->is_uplink);
-        if (rv == 0 && intf_type == 'd') {
+        if (intf_type == 'd') {
             rv = dhcp_device_get_ip(dev->dev_context, &vlan_ip);
 
             dhcp_device_context_t *agg_dev = dhcp_device_get_aggregate_context();
 
-            strncpy(agg_dev->intf, AGG_DEV_PREFIX, sizeof(AGG_DEV_PREFIX));
+            strncpy(agg_dev->intf, AGG_DEV_PREFIX, sizeof(agg_dev->intf) - 1);
             strncpy(agg_dev->intf + sizeof(AGG_DEV_PREFIX) - 1, name, sizeof(agg_dev->intf) - sizeof(AGG_DEV_PREFIX));
             agg_dev->intf[sizeof(agg_dev->intf) - 1] = '\0';
+            memset(agg_dev->db_counters, 0xff, sizeof(agg_dev->db_counters));
         }
 
-        LIST_INSERT_HEAD(&intfs, dev, entry);
+        intfs[dev->name] = dev;
+        if (dev->ifindex != 0) {
+            intfs_by_ifindex[dev->ifindex] = dev;
+        }
     }
     else {
         syslog(LOG_ALERT, "malloc: failed to allocate memory for intf '%s'\n", name);
@@ -154,6 +255,185 @@ int dhcp_devman_add_intf(const char *name, char intf_type)
     return rv;
 }
 
+/**
+ * @code dhcp_devman_del_intf(name);
+ *
+ * @brief removes interface from the device manager and stops packet capture on it.
+ */
+int dhcp_devman_del_intf(const char *name)
+{
+    int rv = -1;
+    auto it = intfs.find(name);
+
+    if (it != intfs.end()) {
+        remove_intf(it->second);
+        rv = 0;
+    }
+
+    return rv;
+}
+
+/**
+ * @code is_member_intf_active(vlan_intf, member_ifindex);
+ *
+ * @brief dual tor member filter backed by the vlan member and mux state subscriptions
+ *
+ * @param vlan_intf         vlan interface name
+ * @param member_ifindex    index of the interface the packet was received on
+ *
+ * @return true if member interface is a vlan member that is not in standby mux state, false otherwise
+ */
+static bool is_member_intf_active(const char *vlan_intf, int member_ifindex)
+{
+    auto it = intfs_by_ifindex.find(member_ifindex);
+
+    return it != intfs_by_ifindex.end() && it->second->intf_type == 'v' &&
+           standby_intfs.count(it->second->name) == 0;
+}
+
+/**
+ * @code sync_vlan_members();
+ *
+ * @brief applies pending CONFIG_DB VLAN_MEMBER changes of the downlink (south) vlan
+ *
+ * @return none
+ */
+static void sync_vlan_members()
+{
+    std::deque<swss::KeyOpFieldsValuesTuple> entries;
+
+    vlan_member_table->pops(entries);
+    for (auto &entry : entries) {
+        // key is <vlan>|<member>
+        const std::string &key = kfvKey(entry);
+        size_t pos = key.find('|');
+
+        if (south_intf == NULL || pos == std::string::npos || key.compare(0, pos, south_intf->name) != 0) {
+            continue;
+        }
+
+        std::string member = key.substr(pos + 1);
+        auto it = intfs.find(member);
+        if (kfvOp(entry) == SET_COMMAND && it == intfs.end()) {
+            if (dhcp_devman_add_intf(member.c_str(), 'v') == 0) {
+                syslog(LOG_INFO, "Added vlan member %s of %s\n", member.c_str(), south_intf->name);
+            }
+        } else if (kfvOp(entry) == DEL_COMMAND && it != intfs.end() && it->second->intf_type == 'v') {
+            dhcp_devman_del_intf(member.c_str());
+            syslog(LOG_INFO, "Removed vlan member %s of %s\n", member.c_str(), south_intf->name);
+        }
+    }
+}
+
+/**
+ * @code sync_mux_states();
+ *
+ * @brief applies pending STATE_DB HW_MUX_CABLE_TABLE changes
+ *
+ * @return none
+ */
+static void sync_mux_states()
+{
+    std::deque<swss::KeyOpFieldsValuesTuple> entries;
+
+    mux_cable_table->pops(entries);
+    for (auto &entry : entries) {
+        const std::string &member = kfvKey(entry);
+
+        if (kfvOp(entry) == DEL_COMMAND) {
+            standby_intfs.erase(member);
+            continue;
+        }
+
+        for (auto &fv : kfvFieldsValues(entry)) {
+            if (fvField(fv) == "state") {
+                if (fvValue(fv) == "standby") {
+                    standby_intfs.insert(member);
+                } else {
+                    standby_intfs.erase(member);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @code vlan_member_callback(fd, event, arg);
+ *
+ * @brief libevent callback of the CONFIG_DB VLAN_MEMBER subscription
+ *
+ * @param fd            subscription socket
+ * @param event         libevent triggered event
+ * @param arg           user provided argument for callback (unused)
+ *
+ * @return none
+ */
+static void vlan_member_callback(evutil_socket_t fd, short event, void *arg)
+{
+    vlan_member_table->readData();
+    sync_vlan_members();
+}
+
+/**
+ * @code mux_cable_callback(fd, event, arg);
+ *
+ * @brief libevent callback of the STATE_DB HW_MUX_CABLE_TABLE subscription
+ *
+ * @param fd            subscription socket
+ * @param event         libevent triggered event
+ * @param arg           user provided argument for callback (unused)
+ *
+ * @return none
+ */
+static void mux_cable_callback(evutil_socket_t fd, short event, void *arg)
+{
+    mux_cable_table->readData();
+    sync_mux_states();
+}
+
+/**
+ * @code subscribe_vlan_members(base);
+ *
+ * @brief subscribes to downlink vlan membership and mux state changes, and installs the dual tor member filter
+ *        that uses them
+ *
+ * @param base              libevent base
+ *
+ * @return 0 on success, nonzero otherwise
+ */
+static int subscribe_vlan_members(struct event_base *base)
+{
+    int rv = -1;
+
+    do {
+        config_db = std::make_shared<swss::DBConnector> ("CONFIG_DB", 0);
+        vlan_member_table = std::make_shared<swss::SubscriberStateTable> (config_db.get(), "VLAN_MEMBER");
+        state_db = std::make_shared<swss::DBConnector> ("STATE_DB", 0);
+        mux_cable_table = std::make_shared<swss::SubscriberStateTable> (state_db.get(), "HW_MUX_CABLE_TABLE");
+
+        ev_vlan_member = event_new(base, vlan_member_table->getFd(), EV_READ | EV_PERSIST,
+                                   vlan_member_callback, NULL);
+        ev_mux_cable = event_new(base, mux_cable_table->getFd(), EV_READ | EV_PERSIST,
+                                 mux_cable_callback, NULL);
+        if (ev_vlan_member == NULL || ev_mux_cable == NULL) {
+            syslog(LOG_ALERT, "event_new: failed to allocate memory for vlan member subscription\n");
+            break;
+        }
+        event_add(ev_vlan_member, NULL);
+        event_add(ev_mux_cable, NULL);
+
+        // subscriptions start with the existing table entries
+        sync_vlan_members();
+        sync_mux_states();
+
+        dhcp_device_set_member_filter(is_member_intf_active);
+
+        rv = 0;
+    } while (0);
+
+    return rv;
+}
+
 /**
  * @code dhcp_devman_setup_dual_tor_mode(name);
  *
@@ -193,10 +473,11 @@ int dhcp_devman_setup_dual_tor_mode(const char *name)
 int dhcp_devman_start_capture(size_t snaplen, struct event_base *base)
 {
     int rv = -1;
-    struct intf *int_ptr;
 
     if ((dhcp_num_south_intf == 1) && (dhcp_num_north_intf >= 1)) {
-        LIST_FOREACH(int_ptr, &intfs, entry) {
+        for (auto &it : intfs) {
+            struct intf *int_ptr = it.second;
+
             rv = dhcp_device_start_capture(int_ptr->dev_context, snaplen, base, dual_tor_mode ? loopback_ip : vlan_ip);
             if (rv == 0) {
                 syslog(LOG_INFO,
@@ -209,6 +490,11 @@ int dhcp_devman_start_capture(size_t snaplen, struct event_base *base)
                 break;
             }
         }
+
+        // vlan members are added by the subscription, after the captured interfaces are started
+        if (rv == 0 && dual_tor_mode) {
+            rv = subscribe_vlan_members(base);
+        }
     }
     else {
         syslog(LOG_ERR, "Invalid number of interfaces, downlink/south %d, uplink/north %d\n",
@@ -228,6 +514,55 @@ dhcp_mon_status_t dhcp_devman_get_status(dhcp_mon_check_t check_type, dhcp_devic
     return dhcp_device_get_status(check_type, context);
 }
 
+/**
+ * @code dhcp_devman_update_rates(interval_sec, alpha);
+ *
+ * @brief samples counters of all interfaces and updates their smoothed rates
+ */
+void dhcp_devman_update_rates(int interval_sec, double alpha)
+{
+    for (auto &it : intfs) {
+        dhcp_device_update_rates(it.second->dev_context, interval_sec, alpha);
+    }
+
+    dhcp_device_update_rates(dhcp_devman_get_agg_dev(), interval_sec, alpha);
+}
+
+/**
+ * @code dhcp_devman_get_rate_status(context, thresholds);
+ *
+ * @brief collects DHCP relay status info using smoothed rx/tx rates.
+ */
+dhcp_mon_status_t dhcp_devman_get_rate_status(dhcp_device_context_t *context,
+                                              const dhcp_mon_rate_thresholds_t *thresholds)
+{
+    return dhcp_device_get_rate_status(context, thresholds);
+}
+
+/**
+ * @code dhcp_devman_get_rate_thresholds(thresholds);
+ *
+ * @brief reads rate based health check thresholds of the downlink (south) vlan interface from CONFIG_DB
+ */
+void dhcp_devman_get_rate_thresholds(dhcp_mon_rate_thresholds_t *thresholds)
+{
+    if (south_intf != NULL) {
+        dhcp_device_get_rate_thresholds(south_intf->name, thresholds);
+    }
+}
+
+/**
+ * @code dhcp_devman_expire_transactions();
+ *
+ * @brief expires DHCP transactions that did not complete in time
+ */
+void dhcp_devman_expire_transactions()
+{
+    if (south_intf != NULL) {
+        dhcp_txn_expire(south_intf->name);
+    }
+}
+
 /**
  * @code dhcp_devman_update_snapshot(context);
  *
@@ -236,10 +571,8 @@ dhcp_mon_status_t dhcp_devman_get_status(dhcp_mon_check_t check_type, dhcp_devic
 void dhcp_devman_update_snapshot(dhcp_device_context_t *context)
 {
     if (context == NULL) {
-        struct intf *int_ptr;
-
-        LIST_FOREACH(int_ptr, &intfs, entry) {
-            dhcp_device_update_snapshot(int_ptr->dev_context);
+        for (auto &it : intfs) {
+            dhcp_device_update_snapshot(it.second->dev_context);
         }
 
         dhcp_device_update_snapshot(dhcp_devman_get_agg_dev());
@@ -248,6 +581,24 @@ void dhcp_devman_update_snapshot(dhcp_device_context_t *context)
     }
 }
 
+/**
+ * @code dhcp_devman_update_counters_db();
+ *
+ * @brief writes counters of all interfaces to COUNTERS_DB
+ */
+void dhcp_devman_update_counters_db()
+{
+    for (auto &it : intfs) {
+        dhcp_device_update_counters_db(it.second->dev_context);
+    }
+
+    dhcp_device_update_counters_db(dhcp_devman_get_agg_dev());
+    if (south_intf != NULL) {
+        dhcp_device_update_latency_db(south_intf->name);
+    }
+    dhcp_device_flush_counters_db();
+}
+
 /**
  * @code dhcp_devman_print_status(context, type);
  *
@@ -256,10 +607,8 @@ void dhcp_devman_update_snapshot(dhcp_device_context_t *context)
 void dhcp_devman_print_status(dhcp_device_context_t *context, dhcp_counters_type_t type)
 {
     if (context == NULL) {
-        struct intf *int_ptr;
-
-        LIST_FOREACH(int_ptr, &intfs, entry) {
-            dhcp_device_print_status(int_ptr->dev_context, type);
+        for (auto &it : intfs) {
+            dhcp_device_print_status(it.second->dev_context, type);
         }
 
         dhcp_device_print_status(dhcp_devman_get_agg_dev(), type);
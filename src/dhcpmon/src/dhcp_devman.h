@@ -58,11 +58,24 @@ dhcp_device_context_t* dhcp_devman_get_mgmt_dev();
  * @param intf_type         'u' for uplink (north) interface
  *                          'd' for downlink (south) interface
  *                          'm' for mgmt interface
+ *                          'v' for downlink vlan member interface, tracked for the dual tor member filter only
  *
- * @return 0 on success, nonzero otherwise
+ * @return 0 on success, nonzero otherwise or if an interface with the same name is already added
  */
 int dhcp_devman_add_intf(const char *name, char intf_type);
 
+/**
+ * @code dhcp_devman_del_intf(name);
+ *
+ * @brief removes interface from the device manager and stops packet capture on it. In dual tor mode, downlink
+ *        vlan members are added and removed at runtime as CONFIG_DB VLAN_MEMBER changes
+ *
+ * @param name              interface name
+ *
+ * @return 0 on success, nonzero if interface is not monitored
+ */
+int dhcp_devman_del_intf(const char *name);
+
 /**
  * @code dhcp_devman_setup_dual_tor_mode(name);
  *
@@ -98,6 +111,51 @@ int dhcp_devman_start_capture(size_t snaplen, struct event_base *base);
  */
 dhcp_mon_status_t dhcp_devman_get_status(dhcp_mon_check_t check_type, dhcp_device_context_t *context);
 
+/**
+ * @code dhcp_devman_update_rates(interval_sec, alpha);
+ *
+ * @brief samples counters of all interfaces and updates their smoothed rates
+ *
+ * @param interval_sec      time elapsed since previous sample
+ * @param alpha             EWMA smoothing factor
+ *
+ * @return none
+ */
+void dhcp_devman_update_rates(int interval_sec, double alpha);
+
+/**
+ * @code dhcp_devman_get_rate_status(context, thresholds);
+ *
+ * @brief collects DHCP relay status info using smoothed rx/tx rates.
+ *
+ * @param context           pointer to device (interface) context
+ * @param thresholds        rate based health check thresholds
+ *
+ * @return DHCP_MON_STATUS_HEALTHY, DHCP_MON_STATUS_UNHEALTHY, or DHCP_MON_STATUS_INDETERMINATE
+ */
+dhcp_mon_status_t dhcp_devman_get_rate_status(dhcp_device_context_t *context,
+                                              const dhcp_mon_rate_thresholds_t *thresholds);
+
+/**
+ * @code dhcp_devman_get_rate_thresholds(thresholds);
+ *
+ * @brief reads rate based health check thresholds of the downlink (south) vlan interface from CONFIG_DB
+ *
+ * @param thresholds(inout) rate based health check thresholds
+ *
+ * @return none
+ */
+void dhcp_devman_get_rate_thresholds(dhcp_mon_rate_thresholds_t *thresholds);
+
+/**
+ * @code dhcp_devman_expire_transactions();
+ *
+ * @brief expires DHCP transactions of the downlink (south) vlan interface that did not complete in time
+ *
+ * @return none
+ */
+void dhcp_devman_expire_transactions();
+
 /**
  * @code dhcp_devman_update_snapshot(context);
  *
@@ -107,6 +165,15 @@ dhcp_mon_status_t dhcp_devman_get_status(dhcp_mon_check_t check_type, dhcp_devic
  */
 void dhcp_devman_update_snapshot(dhcp_device_context_t *context);
 
+/**
+ * @code dhcp_devman_update_counters_db();
+ *
+ * @brief writes counters of all interfaces and relay round trip latency histograms to COUNTERS_DB
+ *
+ * @return none
+ */
+void dhcp_devman_update_counters_db();
+
 /**
  * @code dhcp_devman_print_status(context, type);
  *
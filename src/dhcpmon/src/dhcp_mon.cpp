@@ -23,6 +23,8 @@ typedef struct
     dhcp_mon_check_t check_type;                /** check type */
     dhcp_device_context_t* (*get_context)();    /** functor to a device context accessor function */
     int count;                                  /** count in the number of unhealthy checks */
+    int rate_count;                             /** count in seconds of consecutive unhealthy rate checks */
+    bool reported;                              /** unhealthy state was reported in current health check window */
     const char *msg;                            /** message to be printed if unhealthy state is determined */
 } dhcp_mon_state_t;
 
@@ -30,10 +32,27 @@ typedef struct
 static int window_interval_sec = 18;
 /** dhcp_unhealthy_max_count max count of consecutive unhealthy statuses before reporting to syslog */
 static int dhcp_unhealthy_max_count = 10;
+/** db_update_interval_sec interval between COUNTERS_DB updates, 0 disables the export */
+static int db_update_interval_sec = 1;
+/** rate_interval_sec interval between DHCP packet rates samples */
+static const int rate_interval_sec = 1;
+/** default_rate_thresholds rate based health check thresholds used for fields missing from CONFIG_DB */
+static const dhcp_mon_rate_thresholds_t default_rate_thresholds = {
+    .alpha = 0.2,
+    .min_rx_rate = 1.0,
+    .min_relay_ratio = 0.5,
+    .max_unhealthy_sec = 10
+};
+/** rate_thresholds rate based health check thresholds, overridden per vlan from CONFIG_DB */
+static dhcp_mon_rate_thresholds_t rate_thresholds = default_rate_thresholds;
 /** libevent base struct */
 static struct event_base *base;
 /** libevent timeout event struct */
 static struct event *ev_timeout = NULL;
+/** libevent rate sampling timeout event struct */
+static struct event *ev_rate = NULL;
+/** libevent COUNTERS_DB update timeout event struct */
+static struct event *ev_db_update = NULL;
 /** libevent SIGINT signal event struct */
 static struct event *ev_sigint;
 /** libevent SIGTERM signal event struct */
@@ -49,12 +68,16 @@ static dhcp_mon_state_t state_data[] = {
         .check_type = DHCP_MON_CHECK_POSITIVE,
         .get_context = dhcp_devman_get_agg_dev,
         .count = 0,
+        .rate_count = 0,
+        .reported = false,
         .msg = "dhcpmon detected disparity in DHCP Relay behavior. Duration: %d (sec) for vlan: '%s'\n"
     },
     [1] = {
         .check_type = DHCP_MON_CHECK_NEGATIVE,
         .get_context = dhcp_devman_get_mgmt_dev,
         .count = 0,
+        .rate_count = 0,
+        .reported = false,
         .msg = "dhcpmon detected DHCP packets traveling through mgmt interface (please check BGP routes.)"
                " Duration: %d (sec) for intf: '%s'\n"
     }
@@ -97,7 +120,9 @@ static void check_dhcp_relay_health(dhcp_mon_state_t *state_data)
     switch (dhcp_mon_status)
     {
     case DHCP_MON_STATUS_UNHEALTHY:
-        if (++state_data->count > dhcp_unhealthy_max_count) {
+        // skip the report if the rate based check already reported this window
+        if (++state_data->count > dhcp_unhealthy_max_count && !state_data->reported) {
+            state_data->reported = true;
             auto duration = state_data->count * window_interval_sec;
 	    std::string vlan(context->intf);
             syslog(LOG_ALERT, state_data->msg, duration, vlan);
@@ -125,6 +150,89 @@ static void check_dhcp_relay_health(dhcp_mon_state_t *state_data)
     }
 }
 
+/**
+ * @code check_dhcp_relay_rate_health(state_data);
+ *
+ * @brief check DHCP relay health using smoothed packet rates. On busy vlans this detects relay failures within
+ *        seconds while quiet vlans are left to the window based check
+ *
+ * @param state_data        pointer to dhcpmon state data
+ *
+ * @return none
+ */
+static void check_dhcp_relay_rate_health(dhcp_mon_state_t *state_data)
+{
+    dhcp_device_context_t *context = state_data->get_context();
+    dhcp_mon_status_t dhcp_mon_status = dhcp_devman_get_rate_status(context, &rate_thresholds);
+
+    if (dhcp_mon_status == DHCP_MON_STATUS_UNHEALTHY) {
+        state_data->rate_count += rate_interval_sec;
+        // report once the threshold is crossed and then at most once every health check window
+        if (state_data->rate_count >= rate_thresholds.max_unhealthy_sec && !state_data->reported) {
+            state_data->reported = true;
+            std::string vlan(context->intf);
+            syslog(LOG_ALERT, state_data->msg, state_data->rate_count, vlan.c_str());
+            event_params_t params = {
+                { "vlan", vlan },
+                { "duration", std::to_string(state_data->rate_count) }};
+            event_publish(g_events_handle, "dhcp-relay-disparity", &params);
+            dhcp_devman_print_status(context, DHCP_COUNTERS_CURRENT);
+        }
+    } else {
+        state_data->rate_count = 0;
+    }
+}
+
+/**
+ * @code rate_callback(fd, event, arg);
+ *
+ * @brief periodic timer call back that samples DHCP packet rates and expires incomplete DHCP transactions
+ *
+ * @param fd        libevent socket
+ * @param event     event triggered
+ * @param arg       pointer user provided context (libevent base)
+ *
+ * @return none
+ */
+static void rate_callback(evutil_socket_t fd, short event, void *arg)
+{
+    dhcp_devman_update_rates(rate_interval_sec, rate_thresholds.alpha);
+    dhcp_devman_expire_transactions();
+
+    for (uint8_t i = 0; i < sizeof(state_data) / sizeof(*state_data); i++) {
+        if (state_data[i].check_type == DHCP_MON_CHECK_POSITIVE) {
+            check_dhcp_relay_rate_health(&state_data[i]);
+        }
+    }
+}
+
+/**
+ * @code update_rate_thresholds(force_log);
+ *
+ * @brief re-reads rate based health check thresholds from CONFIG_DB so runtime changes take effect. Fields removed
+ *        from CONFIG_DB fall back to their defaults
+ *
+ * @param force_log         log the thresholds even if they did not change
+ *
+ * @return none
+ */
+static void update_rate_thresholds(bool force_log)
+{
+    dhcp_mon_rate_thresholds_t thresholds = default_rate_thresholds;
+
+    dhcp_devman_get_rate_thresholds(&thresholds);
+    if (force_log ||
+        thresholds.alpha != rate_thresholds.alpha ||
+        thresholds.min_rx_rate != rate_thresholds.min_rx_rate ||
+        thresholds.min_relay_ratio != rate_thresholds.min_relay_ratio ||
+        thresholds.max_unhealthy_sec != rate_thresholds.max_unhealthy_sec) {
+        rate_thresholds = thresholds;
+        syslog(LOG_INFO, "Rate based health check thresholds: alpha %.2f, min rx rate %.2f, min relay ratio %.2f, "
+               "max unhealthy %d (sec)\n", rate_thresholds.alpha, rate_thresholds.min_rx_rate,
+               rate_thresholds.min_relay_ratio, rate_thresholds.max_unhealthy_sec);
+    }
+}
+
 /**
  * @code timeout_callback(fd, event, arg);
  *
@@ -138,27 +246,47 @@ static void check_dhcp_relay_health(dhcp_mon_state_t *state_data)
  */
 static void timeout_callback(evutil_socket_t fd, short event, void *arg)
 {
+    update_rate_thresholds(false);
+
     for (uint8_t i = 0; i < sizeof(state_data) / sizeof(*state_data); i++) {
         check_dhcp_relay_health(&state_data[i]);
+        state_data[i].reported = false;
     }
 
     dhcp_devman_update_snapshot(NULL);
 }
 
 /**
- * @code dhcp_mon_init(window_sec, max_count);
+ * @code db_update_callback(fd, event, arg);
+ *
+ * @brief periodic timer call back that exports DHCP counters to COUNTERS_DB
+ *
+ * @param fd        libevent socket
+ * @param event     event triggered
+ * @param arg       pointer user provided context (libevent base)
+ *
+ * @return none
+ */
+static void db_update_callback(evutil_socket_t fd, short event, void *arg)
+{
+    dhcp_devman_update_counters_db();
+}
+
+/**
+ * @code dhcp_mon_init(window_sec, max_count, db_update_sec);
  *
  * initializes event base and periodic timer event that continuously collects dhcp relay health status every window_sec
  * seconds. It also writes to syslog when dhcp relay has been unhealthy for consecutive max_count checks.
  *
  */
-int dhcp_mon_init(int window_sec, int max_count)
+int dhcp_mon_init(int window_sec, int max_count, int db_update_sec)
 {
     int rv = -1;
 
     do {
         window_interval_sec = window_sec;
         dhcp_unhealthy_max_count = max_count;
+        db_update_interval_sec = db_update_sec;
 
         base = event_base_new();
         if (base == NULL) {
@@ -190,6 +318,18 @@ int dhcp_mon_init(int window_sec, int max_count)
             break;
         }
 
+        ev_rate = event_new(base, -1, EV_PERSIST, rate_callback, base);
+        if (ev_rate == NULL) {
+            syslog(LOG_ERR, "Could not create libevent rate timer!\n");
+            break;
+        }
+
+        ev_db_update = event_new(base, -1, EV_PERSIST, db_update_callback, base);
+        if (ev_db_update == NULL) {
+            syslog(LOG_ERR, "Could not create libevent COUNTERS_DB update timer!\n");
+            break;
+        }
+
         g_events_handle = events_init_publisher("sonic-events-dhcp-relay");
 
         rv = 0;
@@ -206,15 +346,22 @@ int dhcp_mon_init(int window_sec, int max_count)
 void dhcp_mon_shutdown()
 {
     event_del(ev_timeout);
+    event_del(ev_rate);
+    event_del(ev_db_update);
     event_del(ev_sigint);
     event_del(ev_sigterm);
     event_del(ev_sigusr1);
 
     event_free(ev_timeout);
+    event_free(ev_rate);
+    event_free(ev_db_update);
     event_free(ev_sigint);
     event_free(ev_sigterm);
     event_free(ev_sigusr1);
 
+    // device capture and subscription events must be freed before the event base they belong to
+    dhcp_devman_shutdown();
+
     event_base_free(base);
 
     events_deinit_publisher(g_events_handle);
@@ -256,6 +403,22 @@ int dhcp_mon_start(size_t snaplen)
             break;
         }
 
+        update_rate_thresholds(true);
+
+        struct timeval rate_time = {.tv_sec = rate_interval_sec, .tv_usec = 0};
+        if (evtimer_add(ev_rate, &rate_time) != 0) {
+            syslog(LOG_ERR, "Could not add rate timer to libevent!\n");
+            break;
+        }
+
+        if (db_update_interval_sec > 0) {
+            struct timeval db_update_time = {.tv_sec = db_update_interval_sec, .tv_usec = 0};
+            if (evtimer_add(ev_db_update, &db_update_time) != 0) {
+                syslog(LOG_ERR, "Could not add COUNTERS_DB update timer to libevent!\n");
+                break;
+            }
+        }
+
         if (event_base_dispatch(base) != 0) {
             syslog(LOG_ERR, "Could not start libevent dispatching loop!\n");
             break;
@@ -9,23 +9,24 @@
 #define DHCP_MON_H_
 
 /**
- * @code dhcp_mon_init(window_ssec, max_count);
+ * @code dhcp_mon_init(window_ssec, max_count, db_update_sec);
  *
  * @brief initializes event base and periodic timer event that continuously collects dhcp relay health status every
  *        window_sec seconds. It also writes to syslog when dhcp relay has been unhealthy for consecutive max_count
- *        checks.
+ *        checks. Counters are exported to COUNTERS_DB every db_update_sec seconds.
  *
  * @param window_sec time interval between health checks
  * @param max_count max count of consecutive unhealthy statuses before reporting to syslog
+ * @param db_update_sec time interval between COUNTERS_DB updates, 0 disables the export
  *
  * @return 0 upon success, otherwise upon failure
  */
-int dhcp_mon_init(int window_sec, int max_count);
+int dhcp_mon_init(int window_sec, int max_count, int db_update_sec);
 
 /**
  * @code dhcp_mon_shutdown();
  *
- * @brief shuts down libevent loop
+ * @brief shuts down libevent loop and the device manager whose events are registered with it
  *
  * @return none
  */
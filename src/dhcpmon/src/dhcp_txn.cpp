@@ -0,0 +1,289 @@
+/**
+ * @file dhcp_txn.cpp
+ *
+ *  DHCP transaction (DISCOVER->OFFER, REQUEST->ACK) latency tracking module
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <syslog.h>
+#include <time.h>
+
+#include "dhcp_txn.h"
+
+/** In-flight DHCP transaction */
+typedef struct
+{
+    uint64_t start_usec;            /** time client message was received, 0 for a free slot */
+    uint32_t xid;                   /** DHCP transaction id */
+    uint8_t chaddr[ETHER_ADDR_LEN]; /** client hardware address */
+    uint8_t type;                   /** transaction type */
+} dhcp_txn_t;
+
+/** Upper limits (msec) of latency histogram buckets, last bucket is unbounded */
+static const uint32_t bucket_limits_msec[DHCP_TXN_HISTOGRAM_BUCKETS] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 0
+};
+
+/** Open addressing transaction table, size is a power of 2 */
+static dhcp_txn_t *txn_table = NULL;
+/** txn_table size - 1 */
+static size_t txn_mask = 0;
+/** max number of in-flight transactions */
+static size_t txn_max_count = 0;
+/** number of in-flight transactions */
+static size_t txn_count = 0;
+/** in-flight transaction timeout */
+static uint64_t txn_timeout_usec = 0;
+/** per transaction type latency statistics */
+static dhcp_txn_stats_t txn_stats[DHCP_TXN_TYPE_COUNT];
+
+/**
+ * @code now_usec();
+ *
+ * @brief monotonic clock accessor
+ *
+ * @return current monotonic time in usec, never 0
+ */
+static uint64_t now_usec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + 1;
+}
+
+/**
+ * @code txn_hash(type, xid, chaddr);
+ *
+ * @brief FNV-1a hash of transaction key
+ *
+ * @return hash value
+ */
+static size_t txn_hash(dhcp_txn_type_t type, uint32_t xid, const uint8_t *chaddr)
+{
+    uint32_t hash = 2166136261u;
+
+    hash = (hash ^ type) * 16777619u;
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ ((xid >> (i * 8)) & 0xff)) * 16777619u;
+    }
+    for (int i = 0; i < ETHER_ADDR_LEN; i++) {
+        hash = (hash ^ chaddr[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * @code txn_find(type, xid, chaddr);
+ *
+ * @brief finds in-flight transaction slot, or the free slot where it would be inserted
+ *
+ * @return transaction table slot
+ */
+static dhcp_txn_t* txn_find(dhcp_txn_type_t type, uint32_t xid, const uint8_t *chaddr)
+{
+    size_t i = txn_hash(type, xid, chaddr) & txn_mask;
+
+    // table is never full as txn_max_count is at most half of table size
+    while (txn_table[i].start_usec != 0) {
+        if (txn_table[i].xid == xid && txn_table[i].type == type &&
+            memcmp(txn_table[i].chaddr, chaddr, ETHER_ADDR_LEN) == 0) {
+            break;
+        }
+        i = (i + 1) & txn_mask;
+    }
+
+    return &txn_table[i];
+}
+
+/**
+ * @code txn_remove(txn);
+ *
+ * @brief removes transaction from table, shifting back entries of the same probe sequence
+ *
+ * @return none
+ */
+static void txn_remove(dhcp_txn_t *txn)
+{
+    size_t i = txn - txn_table;
+    size_t j = i;
+
+    txn_table[i].start_usec = 0;
+    txn_count--;
+
+    while (true) {
+        j = (j + 1) & txn_mask;
+        if (txn_table[j].start_usec == 0) {
+            break;
+        }
+
+        size_t home = txn_hash((dhcp_txn_type_t) txn_table[j].type, txn_table[j].xid, txn_table[j].chaddr) & txn_mask;
+        // move entry j into hole i unless its home slot lies cyclically in (i, j]
+        if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j)) {
+            continue;
+        }
+
+        txn_table[i] = txn_table[j];
+        txn_table[j].start_usec = 0;
+        i = j;
+    }
+}
+
+/**
+ * @code dhcp_txn_init(max_count, timeout_sec);
+ *
+ * @brief initializes DHCP transaction table
+ */
+int dhcp_txn_init(size_t max_count, int timeout_sec)
+{
+    int rv = -1;
+    size_t size = 2;
+
+    while (size < max_count * 2) {
+        size <<= 1;
+    }
+
+    txn_table = (dhcp_txn_t *) calloc(size, sizeof(dhcp_txn_t));
+    if (txn_table != NULL) {
+        txn_mask = size - 1;
+        txn_max_count = max_count;
+        txn_count = 0;
+        txn_timeout_usec = (uint64_t) timeout_sec * 1000000;
+        memset(txn_stats, 0, sizeof(txn_stats));
+        rv = 0;
+    } else {
+        syslog(LOG_ALERT, "calloc: failed to allocate DHCP transaction table of %zu entries", size);
+    }
+
+    return rv;
+}
+
+/**
+ * @code dhcp_txn_shutdown();
+ *
+ * @brief releases DHCP transaction table
+ */
+void dhcp_txn_shutdown()
+{
+    free(txn_table);
+    txn_table = NULL;
+    txn_count = 0;
+}
+
+/**
+ * @code dhcp_txn_start(type, xid, chaddr);
+ *
+ * @brief starts tracking a transaction when client message is received by the relay
+ */
+void dhcp_txn_start(dhcp_txn_type_t type, uint32_t xid, const uint8_t *chaddr)
+{
+    if (txn_table != NULL) {
+        dhcp_txn_t *txn = txn_find(type, xid, chaddr);
+
+        if (txn->start_usec == 0) {
+            if (txn_count < txn_max_count) {
+                txn->start_usec = now_usec();
+                txn->xid = xid;
+                txn->type = type;
+                memcpy(txn->chaddr, chaddr, ETHER_ADDR_LEN);
+                txn_count++;
+            } else {
+                txn_stats[type].dropped++;
+            }
+        }
+    }
+}
+
+/**
+ * @code dhcp_txn_complete(type, xid, chaddr);
+ *
+ * @brief completes a transaction when server reply is relayed back to the client and records its latency
+ */
+void dhcp_txn_complete(dhcp_txn_type_t type, uint32_t xid, const uint8_t *chaddr)
+{
+    if (txn_table != NULL) {
+        dhcp_txn_t *txn = txn_find(type, xid, chaddr);
+
+        if (txn->start_usec != 0) {
+            uint64_t latency_usec = now_usec() - txn->start_usec;
+            int bucket = 0;
+
+            while (bucket < DHCP_TXN_HISTOGRAM_BUCKETS - 1 &&
+                   latency_usec >= (uint64_t) bucket_limits_msec[bucket] * 1000) {
+                bucket++;
+            }
+
+            txn_stats[type].buckets[bucket]++;
+            txn_stats[type].completed++;
+            txn_stats[type].latency_sum_usec += latency_usec;
+
+            txn_remove(txn);
+        }
+    }
+}
+
+/**
+ * @code dhcp_txn_expire(vlan);
+ *
+ * @brief removes transactions older than timeout and counts them as incomplete
+ */
+size_t dhcp_txn_expire(const char *vlan)
+{
+    static const char *txn_desc[DHCP_TXN_TYPE_COUNT] = {
+        [DHCP_TXN_DISCOVER_OFFER] = "Discover/Offer",
+        [DHCP_TXN_REQUEST_ACK] = "Request/Ack"
+    };
+    size_t expired[DHCP_TXN_TYPE_COUNT] = {0};
+    size_t rv = 0;
+
+    if (txn_table == NULL || txn_count == 0) {
+        return rv;
+    }
+
+    uint64_t now = now_usec();
+    size_t i = 0;
+    while (i <= txn_mask) {
+        dhcp_txn_t *txn = &txn_table[i];
+        if (txn->start_usec != 0 && now - txn->start_usec > txn_timeout_usec) {
+            expired[txn->type]++;
+            txn_stats[txn->type].incomplete++;
+            // backward shift may move a not yet visited entry into this slot, so revisit it
+            txn_remove(txn);
+        } else {
+            i++;
+        }
+    }
+
+    for (int type = 0; type < DHCP_TXN_TYPE_COUNT; type++) {
+        if (expired[type]) {
+            syslog(LOG_WARNING, "dhcpmon detected %zu incomplete %s transaction(s) for vlan: '%s'\n",
+                   expired[type], txn_desc[type], vlan);
+            rv += expired[type];
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * @code dhcp_txn_get_stats(type);
+ *
+ * @brief Accessor method
+ */
+const dhcp_txn_stats_t* dhcp_txn_get_stats(dhcp_txn_type_t type)
+{
+    return &txn_stats[type];
+}
+
+/**
+ * @code dhcp_txn_get_bucket_limit(bucket);
+ *
+ * @brief Accessor method
+ */
+uint32_t dhcp_txn_get_bucket_limit(int bucket)
+{
+    return bucket_limits_msec[bucket];
+}
@@ -0,0 +1,118 @@
+/**
+ * @file dhcp_txn.h
+ *
+ *  DHCP transaction (DISCOVER->OFFER, REQUEST->ACK) latency tracking module
+ */
+
+#ifndef DHCP_TXN_H_
+#define DHCP_TXN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <net/ethernet.h>
+
+/** DHCP transaction types */
+typedef enum
+{
+    DHCP_TXN_DISCOVER_OFFER,    /** DISCOVER relayed to client as OFFER */
+    DHCP_TXN_REQUEST_ACK,       /** REQUEST relayed to client as ACK/NAK */
+
+    DHCP_TXN_TYPE_COUNT
+} dhcp_txn_type_t;
+
+/** Number of relay round trip latency histogram buckets */
+#define DHCP_TXN_HISTOGRAM_BUCKETS  12
+
+/** DHCP transaction latency statistics */
+typedef struct
+{
+    uint64_t buckets[DHCP_TXN_HISTOGRAM_BUCKETS];
+                                /** completed transactions per latency bucket */
+    uint64_t completed;         /** number of completed transactions */
+    uint64_t latency_sum_usec;  /** sum of completed transactions latency */
+    uint64_t incomplete;        /** number of transactions expired without completion */
+    uint64_t dropped;           /** number of transactions not tracked because table was full */
+} dhcp_txn_stats_t;
+
+/**
+ * @code dhcp_txn_init(max_count, timeout_sec);
+ *
+ * @brief initializes DHCP transaction table
+ *
+ * @param max_count     max number of in-flight transactions tracked
+ * @param timeout_sec   time after which an in-flight transaction is considered incomplete
+ *
+ * @return 0 on success, otherwise for failure
+ */
+int dhcp_txn_init(size_t max_count, int timeout_sec);
+
+/**
+ * @code dhcp_txn_shutdown();
+ *
+ * @brief releases DHCP transaction table
+ *
+ * @return none
+ */
+void dhcp_txn_shutdown();
+
+/**
+ * @code dhcp_txn_start(type, xid, chaddr);
+ *
+ * @brief starts tracking a transaction when client message is received by the relay. Retransmissions keep the
+ *        original start time
+ *
+ * @param type          transaction type
+ * @param xid           DHCP transaction id
+ * @param chaddr        client hardware address
+ *
+ * @return none
+ */
+void dhcp_txn_start(dhcp_txn_type_t type, uint32_t xid, const uint8_t *chaddr);
+
+/**
+ * @code dhcp_txn_complete(type, xid, chaddr);
+ *
+ * @brief completes a transaction when server reply is relayed back to the client and records its latency
+ *
+ * @param type          transaction type
+ * @param xid           DHCP transaction id
+ * @param chaddr        client hardware address
+ *
+ * @return none
+ */
+void dhcp_txn_complete(dhcp_txn_type_t type, uint32_t xid, const uint8_t *chaddr);
+
+/**
+ * @code dhcp_txn_expire(vlan);
+ *
+ * @brief removes transactions older than timeout and counts them as incomplete
+ *
+ * @param vlan          vlan interface name, used for logging
+ *
+ * @return number of transactions expired
+ */
+size_t dhcp_txn_expire(const char *vlan);
+
+/**
+ * @code dhcp_txn_get_stats(type);
+ *
+ * @brief Accessor method
+ *
+ * @param type          transaction type
+ *
+ * @return pointer to transaction type latency statistics
+ */
+const dhcp_txn_stats_t* dhcp_txn_get_stats(dhcp_txn_type_t type);
+
+/**
+ * @code dhcp_txn_get_bucket_limit(bucket);
+ *
+ * @brief Accessor method
+ *
+ * @param bucket        histogram bucket index
+ *
+ * @return upper latency limit of histogram bucket in msec, 0 for the last (unbounded) bucket
+ */
+uint32_t dhcp_txn_get_bucket_limit(int bucket);
+
+#endif /* DHCP_TXN_H_ */
@@ -22,6 +22,7 @@
 #include "dhcp_mon.h"
 #include "dhcp_devman.h"
 #include "dhcp_device.h"
+#include "dhcp_txn.h"
 
 /** dhcpmon_default_snaplen: default snap length of packet being captured */
 static const size_t dhcpmon_default_snaplen = 65535;
@@ -31,6 +32,13 @@ static const uint32_t dhcpmon_default_health_check_window = 18;
 /** dhcpmon_default_unhealthy_max_count: default max consecutive unhealthy status reported before reporting an issue
  *  with DHCP relay */
 static const uint32_t dhcpmon_default_unhealthy_max_count = 10;
+/** dhcpmon_default_db_update_interval: default interval between DHCP counters updates to COUNTERS_DB */
+static const uint32_t dhcpmon_default_db_update_interval = 1;
+
+/** dhcpmon_default_txn_max_count: max number of in-flight DHCP transactions tracked for relay latency */
+static const size_t dhcpmon_default_txn_max_count = 8192;
+/** dhcpmon_default_txn_timeout: time after which an in-flight DHCP transaction is reported as incomplete */
+static const int dhcpmon_default_txn_timeout = 10;
 
 bool dual_tor_sock = false;
 
@@ -46,7 +54,8 @@ bool dual_tor_sock = false;
 static void usage(const char *prog)
 {
     printf("Usage: %s -id <south interface> {-iu <north interface>}+ -im <mgmt interface> [-u <loopback interface>]"
-            "[-w <snapshot window in sec>] [-c <unhealthy status count>] [-s <snap length>] [-d]\n", prog);
+            "[-w <snapshot window in sec>] [-c <unhealthy status count>] [-s <snap length>] "
+            "[-p <counters db update interval in sec>] [-d]\n", prog);
     printf("where\n");
     printf("\tsouth interface: is a vlan interface,\n");
     printf("\tnorth interface: is a TOR-T1 interface,\n");
@@ -57,6 +66,9 @@ static void usage(const char *prog)
            "(default %d),\n",
            dhcpmon_default_unhealthy_max_count);
     printf("\tsnap length: snap length of packet capture (default %ld),\n", dhcpmon_default_snaplen);
+    printf("\tcounters db update interval: interval between DHCP counters updates to COUNTERS_DB, 0 disables "
+           "the update (default %d),\n",
+           dhcpmon_default_db_update_interval);
     printf("\t-d: daemonize %s.\n", prog);
 
     exit(EXIT_SUCCESS);
@@ -115,6 +127,7 @@ int main(int argc, char **argv)
     int i;
     int window_interval = dhcpmon_default_health_check_window;
     int max_unhealthy_count = dhcpmon_default_unhealthy_max_count;
+    int db_update_interval = dhcpmon_default_db_update_interval;
     size_t snaplen = dhcpmon_default_snaplen;
     int make_daemon = 0;
 
@@ -161,6 +174,10 @@ int main(int argc, char **argv)
             max_unhealthy_count = atoi(argv[i + 1]);
             i += 2;
             break;
+        case 'p':
+            db_update_interval = atoi(argv[i + 1]);
+            i += 2;
+            break;
         default:
             fprintf(stderr, "%s: %c: Unknown option\n", basename(argv[0]), argv[i][1]);
             usage(basename(argv[0]));
@@ -171,7 +188,8 @@ int main(int argc, char **argv)
         dhcpmon_daemonize();
     }
 
-    if ((dhcp_mon_init(window_interval, max_unhealthy_count) == 0) &&
+    if ((dhcp_txn_init(dhcpmon_default_txn_max_count, dhcpmon_default_txn_timeout) == 0) &&
+        (dhcp_mon_init(window_interval, max_unhealthy_count, db_update_interval) == 0) &&
         (dhcp_mon_start(snaplen) == 0)) {
 
         rv = EXIT_SUCCESS;
@@ -180,6 +198,7 @@ int main(int argc, char **argv)
     }
 
     dhcp_devman_shutdown();
+    dhcp_txn_shutdown();
 
     closelog();
 
@@ -5,18 +5,21 @@ C_SRCS += \
 ../src/dhcp_device.cpp \
 ../src/dhcp_devman.cpp \
 ../src/dhcp_mon.cpp \
+../src/dhcp_txn.cpp \
 ../src/main.cpp 
 
 OBJS += \
 ./src/dhcp_device.o \
 ./src/dhcp_devman.o \
 ./src/dhcp_mon.o \
+./src/dhcp_txn.o \
 ./src/main.o 
 
 C_DEPS += \
 ./src/dhcp_device.d \
 ./src/dhcp_devman.d \
 ./src/dhcp_mon.d \
+./src/dhcp_txn.d \
 ./src/main.d 
 
 
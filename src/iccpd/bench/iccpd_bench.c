@@ -0,0 +1,1405 @@
+/*
+ * iccpd_bench.c
+ *
+ * Copyright(c) 2016-2019 Nephos/Estinet.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ *
+ *  Maintainer: jianjun, grace Li from nephos
+ */
+
+/*
+ * Scaling benchmark of one iccpd instance. The benchmark plays the
+ * mclagsyncd side (127.0.0.6:2626) and the active ICCP peer (127.0.0.1,
+ * connecting to iccpd at 127.0.0.2), injects MACs through FDB operations
+ * and neighbors through rtnetlink, and measures load time, initial sync
+ * time, update throughput, failover flush time and memory. Results are
+ * printed as one JSON object per phase.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <poll.h>
+#include <signal.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <linux/neighbour.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "../include/msg_format.h"
+#include "../include/mlacp_tlv.h"
+#include "../include/mlacp_link_handler.h"
+#include "../src/mclagdctl/mclagdctl.h"
+
+#define BENCH_SYNCD_ADDR        0x7f000006
+#define BENCH_SYNCD_PORT        2626
+#define BENCH_ICCP_PORT         8888
+#define BENCH_LOCAL_IP          "127.0.0.2"     /* iccpd, standby and server */
+#define BENCH_PEER_IP           "127.0.0.1"     /* simulated peer, active */
+#define BENCH_CTL_PATH          "/var/run/iccpd/mclagdctl.sock"
+
+#define BENCH_FDB_BATCH         64      /* fdb entries per mclagsyncd msg, fits MCLAG_MAX_MSG_LEN */
+#define BENCH_MAC_TLV_BATCH     64      /* MAC entries per MAC info TLV from the peer */
+#define BENCH_NEIGH_BATCH       64      /* RTM_NEWNEIGH msgs per sendmsg */
+#define BENCH_POLL_MS           10
+#define BENCH_CTL_POLL_MS       100
+#define BENCH_HEARTBEAT_MS      1000
+#define BENCH_MSG_MAX           65536
+
+struct bench_conn
+{
+    int fd;
+    char *rx_buf;
+    size_t rx_len;
+    size_t rx_size;
+    char *tx_buf;
+    size_t tx_head;
+    size_t tx_tail;
+    size_t tx_size;
+};
+
+struct bench_config
+{
+    int mac_count;
+    int arp_count;
+    int remote_count;
+    int update_count;
+    int mlag_id;
+    int vid;
+    int timeout_ms;
+    char po_name[MAX_L_PORT_NAME];
+    uint32_t neigh_base;    /* host order */
+    char *iccpd_path;
+    char **iccpd_argv;
+    pid_t pid;
+    char ctl_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+};
+
+struct bench_stats
+{
+    /* Seen by the simulated peer */
+    unsigned long peer_rx_msgs;
+    unsigned long peer_rx_bytes;
+    unsigned long peer_mac_add;
+    unsigned long peer_mac_del;
+    unsigned long peer_arp_add;
+    unsigned long peer_arp_del;
+    int peer_rg_connect;
+    int peer_sync_done;
+
+    /* Seen by the simulated mclagsyncd */
+    unsigned long syncd_rx_msgs;
+    unsigned long fdb_add;
+    unsigned long fdb_del;
+    unsigned long fdb_local_add;
+    unsigned long iccp_state;
+};
+
+static struct bench_config bench_cfg = {
+    .mac_count = 1000,
+    .arp_count = -1,
+    .remote_count = -1,
+    .update_count = -1,
+    .mlag_id = 1,
+    .vid = 10,
+    .timeout_ms = 60000,
+    .po_name = "PortChannel0001",
+    .neigh_base = 0x0a800001,   /* 10.128.0.1 */
+    .ctl_path = BENCH_CTL_PATH,
+};
+
+static struct bench_stats bench_stats;
+static struct bench_conn syncd_conn = { .fd = -1 };
+static struct bench_conn peer_conn = { .fd = -1 };
+static int syncd_listen_fd = -1;
+static int peer_sync_req_sent = 0;
+static uint32_t peer_msg_id = 1;
+static double peer_last_heartbeat = 0;
+static uint8_t peer_system_id[ETHER_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+static uint8_t local_system_id[ETHER_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+/* MAC address spaces of the generated entries */
+enum bench_mac_space
+{
+    BENCH_MAC_LOCAL = 0x10,
+    BENCH_MAC_REMOTE = 0x20,
+    BENCH_MAC_UPDATE = 0x30,
+    BENCH_MAC_NEIGH = 0x40
+};
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n <macs>] [-a <neighbors>] [-r <remote macs>] [-u <updates>] [-i <mclag id>] "
+           "[-o <portchannel>] [-v <vlan>] [-b <neighbor base ip>] [-t <timeout>] [-s <ctl socket>] "
+           "(-x <iccpd> [-- <iccpd args>] | -p <pid>)\n", prog);
+    printf("where\n");
+    printf("\tmacs: local MACs injected through mclagsyncd FDB operations (default 1000),\n");
+    printf("\tneighbors: ARP entries added to the kernel on the portchannel (default: macs),\n");
+    printf("\tremote macs: MACs sent by the simulated peer (default: macs),\n");
+    printf("\tupdates: local MACs added and withdrawn in steady state (default: macs),\n");
+    printf("\tmclag id: domain id configured in iccpd (default 1),\n");
+    printf("\tportchannel: MCLAG interface carrying all entries (default PortChannel0001),\n");
+    printf("\tvlan: vlan of the generated MACs (default 10),\n");
+    printf("\tneighbor base ip: first neighbor address, incremented per entry (default 10.128.0.1),\n");
+    printf("\ttimeout: seconds allowed per phase (default 60),\n");
+    printf("\tctl socket: mclagdctl socket of iccpd (default %s),\n", BENCH_CTL_PATH);
+    printf("\ticcpd: iccpd binary started by the benchmark, or\n");
+    printf("\tpid: pid of an already running iccpd, used for memory figures.\n");
+    printf("The benchmark acts as mclagsyncd and as the active peer, so no mclagsyncd may run.\n");
+    printf("Load times are sampled from mclagdctl dumps every %d ms.\n", BENCH_CTL_POLL_MS);
+    printf("It requires root and is meant to run in its own network namespace, e.g.:\n");
+    printf("\tip netns add iccpbench && ip netns exec iccpbench bash\n");
+    printf("\tip link set lo up\n");
+    printf("\tip link add PortChannel0001 type veth peer name Bench0001\n");
+    printf("\tip link set PortChannel0001 up && ip link set Bench0001 up\n");
+    printf("\tip addr add 10.128.255.254/9 dev PortChannel0001\n");
+    printf("\tsysctl -w net.ipv4.neigh.default.gc_thresh3=<above neighbors> (in the initial namespace)\n");
+    printf("\ticcpd-bench -n 10000 -x /usr/bin/iccpd\n");
+}
+
+static double bench_now_ms()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void bench_mac(uint8_t *mac, int space, int index)
+{
+    mac[0] = 0x02;
+    mac[1] = space;
+    mac[2] = (index >> 24) & 0xff;
+    mac[3] = (index >> 16) & 0xff;
+    mac[4] = (index >> 8) & 0xff;
+    mac[5] = index & 0xff;
+}
+
+/* Memory of iccpd from /proc, in kB, -1 if unknown */
+static long bench_proc_status_kb(const char *field)
+{
+    char path[64];
+    char line[256];
+    FILE *fp;
+    long kb = -1;
+    size_t len = strlen(field);
+
+    if (bench_cfg.pid <= 0)
+        return -1;
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)bench_cfg.pid);
+    fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strncmp(line, field, len) == 0 && line[len] == ':')
+        {
+            kb = strtol(line + len + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(fp);
+
+    return kb;
+}
+
+/*****************************************
+* Non blocking connections with tx queue
+*
+* ***************************************/
+static void bench_conn_close(struct bench_conn *conn)
+{
+    if (conn->fd >= 0)
+        close(conn->fd);
+    conn->fd = -1;
+    conn->rx_len = 0;
+    conn->tx_head = 0;
+    conn->tx_tail = 0;
+}
+
+static void bench_conn_attach(struct bench_conn *conn, int fd)
+{
+    bench_conn_close(conn);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    conn->fd = fd;
+}
+
+static int bench_conn_flush(struct bench_conn *conn)
+{
+    ssize_t len;
+
+    while (conn->fd >= 0 && conn->tx_head < conn->tx_tail)
+    {
+        len = send(conn->fd, conn->tx_buf + conn->tx_head, conn->tx_tail - conn->tx_head,
+                   MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (len < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                return 0;
+            return -1;
+        }
+        conn->tx_head += len;
+    }
+
+    if (conn->tx_head == conn->tx_tail)
+    {
+        conn->tx_head = 0;
+        conn->tx_tail = 0;
+    }
+
+    return 0;
+}
+
+static int bench_conn_send(struct bench_conn *conn, const void *buf, size_t len)
+{
+    char *tx_buf;
+
+    if (conn->fd < 0)
+        return -1;
+
+    if (conn->tx_tail + len > conn->tx_size)
+    {
+        if (conn->tx_head > 0)
+        {
+            memmove(conn->tx_buf, conn->tx_buf + conn->tx_head, conn->tx_tail - conn->tx_head);
+            conn->tx_tail -= conn->tx_head;
+            conn->tx_head = 0;
+        }
+
+        if (conn->tx_tail + len > conn->tx_size)
+        {
+            tx_buf = realloc(conn->tx_buf, (conn->tx_tail + len) * 2);
+            if (!tx_buf)
+                return -1;
+            conn->tx_buf = tx_buf;
+            conn->tx_size = (conn->tx_tail + len) * 2;
+        }
+    }
+
+    memcpy(conn->tx_buf + conn->tx_tail, buf, len);
+    conn->tx_tail += len;
+
+    return bench_conn_flush(conn);
+}
+
+/* Read what is available, -1 if the connection is gone */
+static int bench_conn_recv(struct bench_conn *conn)
+{
+    ssize_t len;
+    char *rx_buf;
+
+    while (1)
+    {
+        if (conn->rx_len == conn->rx_size)
+        {
+            rx_buf = realloc(conn->rx_buf, conn->rx_size ? conn->rx_size * 2 : BENCH_MSG_MAX);
+            if (!rx_buf)
+                return -1;
+            conn->rx_buf = rx_buf;
+            conn->rx_size = conn->rx_size ? conn->rx_size * 2 : BENCH_MSG_MAX;
+        }
+
+        len = recv(conn->fd, conn->rx_buf + conn->rx_len, conn->rx_size - conn->rx_len, MSG_DONTWAIT);
+        if (len == 0)
+            return -1;
+        if (len < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                return 0;
+            return -1;
+        }
+        conn->rx_len += len;
+    }
+}
+
+static void bench_conn_consume(struct bench_conn *conn, size_t len)
+{
+    memmove(conn->rx_buf, conn->rx_buf + len, conn->rx_len - len);
+    conn->rx_len -= len;
+}
+
+/*****************************************
+* Simulated mclagsyncd
+*
+* ***************************************/
+static int bench_syncd_listen()
+{
+    struct sockaddr_in addr;
+    int fd;
+    int on = 1;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(BENCH_SYNCD_PORT);
+    addr.sin_addr.s_addr = htonl(BENCH_SYNCD_ADDR);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 1) < 0)
+    {
+        fprintf(stderr, "mclagsyncd socket: %s, is mclagsyncd running?\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int bench_syncd_send(uint8_t type, const void *data, size_t data_len)
+{
+    char buf[MCLAG_MAX_MSG_LEN];
+    struct IccpSyncdHDr *hdr = (struct IccpSyncdHDr *)buf;
+
+    hdr->ver = 1;
+    hdr->type = type;
+    hdr->len = sizeof(struct IccpSyncdHDr) + data_len;
+    memcpy(buf + sizeof(struct IccpSyncdHDr), data, data_len);
+
+    return bench_conn_send(&syncd_conn, buf, hdr->len);
+}
+
+static int bench_syncd_send_config()
+{
+    struct mclag_domain_cfg_info domain;
+    struct mclag_iface_cfg_info iface;
+
+    memset(&domain, 0, sizeof(domain));
+    domain.op_type = MCLAG_CFG_OPER_ADD;
+    domain.domain_id = bench_cfg.mlag_id;
+    domain.keepalive_time = 1;
+    domain.session_timeout = 15;
+    snprintf(domain.local_ip, sizeof(domain.local_ip), "%s", BENCH_LOCAL_IP);
+    snprintf(domain.peer_ip, sizeof(domain.peer_ip), "%s", BENCH_PEER_IP);
+    memcpy(domain.system_mac, local_system_id, ETHER_ADDR_LEN);
+    domain.attr_bmap = MCLAG_CFG_ATTR_SRC_ADDR | MCLAG_CFG_ATTR_PEER_ADDR
+                       | MCLAG_CFG_ATTR_KEEPALIVE_INTERVAL | MCLAG_CFG_ATTR_SESSION_TIMEOUT;
+    if (bench_syncd_send(MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_DOMAIN, &domain, sizeof(domain)) < 0)
+        return -1;
+
+    memset(&iface, 0, sizeof(iface));
+    iface.op_type = MCLAG_CFG_OPER_ADD;
+    iface.domain_id = bench_cfg.mlag_id;
+    snprintf(iface.mclag_iface, sizeof(iface.mclag_iface), "%s", bench_cfg.po_name);
+
+    return bench_syncd_send(MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_IFACE, &iface, sizeof(iface));
+}
+
+/* Local MAC add/del for count entries of a MAC space, in batches */
+static int bench_syncd_send_fdb(int space, int count, short op_type)
+{
+    struct mclag_fdb_info fdb[BENCH_FDB_BATCH];
+    int i, n = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        memset(&fdb[n], 0, sizeof(fdb[n]));
+        bench_mac(fdb[n].mac, space, i);
+        fdb[n].vid = bench_cfg.vid;
+        snprintf(fdb[n].port_name, sizeof(fdb[n].port_name), "%s", bench_cfg.po_name);
+        fdb[n].type = MAC_TYPE_DYNAMIC;
+        fdb[n].op_type = op_type;
+
+        if (++n == BENCH_FDB_BATCH || i == count - 1)
+        {
+            if (bench_syncd_send(MCLAG_SYNCD_MSG_TYPE_FDB_OPERATION, fdb, n * sizeof(fdb[0])) < 0)
+                return -1;
+            n = 0;
+        }
+    }
+
+    return 0;
+}
+
+static void bench_syncd_handle_msg(char *buf)
+{
+    struct IccpSyncdHDr *hdr = (struct IccpSyncdHDr *)buf;
+    struct mclag_fdb_info *fdb;
+    int count, i;
+
+    ++bench_stats.syncd_rx_msgs;
+
+    if (hdr->type == MCLAG_MSG_TYPE_SET_FDB)
+    {
+        /* SET_FDB msgs queued in iccpd may be coalesced */
+        count = (hdr->len - sizeof(struct IccpSyncdHDr)) / sizeof(struct mclag_fdb_info);
+        for (i = 0; i < count; ++i)
+        {
+            fdb = (struct mclag_fdb_info *)(buf + sizeof(struct IccpSyncdHDr) + i * sizeof(struct mclag_fdb_info));
+            if (fdb->op_type == MAC_SYNC_DEL)
+                ++bench_stats.fdb_del;
+            else if (fdb->type == MAC_TYPE_DYNAMIC_LOCAL)
+                ++bench_stats.fdb_local_add;
+            else
+                ++bench_stats.fdb_add;
+        }
+    }
+    else if (hdr->type == MCLAG_MSG_TYPE_SET_ICCP_STATE)
+    {
+        ++bench_stats.iccp_state;
+    }
+}
+
+static int bench_syncd_rx()
+{
+    struct IccpSyncdHDr *hdr;
+    size_t pos = 0;
+
+    if (bench_conn_recv(&syncd_conn) < 0)
+        return -1;
+
+    while (syncd_conn.rx_len - pos >= sizeof(struct IccpSyncdHDr))
+    {
+        hdr = (struct IccpSyncdHDr *)(syncd_conn.rx_buf + pos);
+        if (hdr->len < sizeof(struct IccpSyncdHDr))
+            return -1;
+        if (syncd_conn.rx_len - pos < hdr->len)
+            break;
+        bench_syncd_handle_msg(syncd_conn.rx_buf + pos);
+        pos += hdr->len;
+    }
+    bench_conn_consume(&syncd_conn, pos);
+
+    return 0;
+}
+
+/*****************************************
+* Simulated ICCP peer
+*
+* ***************************************/
+static size_t bench_peer_fill_icc_header(char *buf, size_t msg_len)
+{
+    ICCHdr *icc_hdr = (ICCHdr *)buf;
+
+    *(uint16_t *)buf = htons(MSG_T_RG_APP_DATA);
+    icc_hdr->ldp_hdr.msg_len = htons(msg_len - MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS);
+    icc_hdr->ldp_hdr.msg_id = htonl(peer_msg_id++);
+    icc_hdr->icc_rg_id_tlv.type = htons(TLV_T_ICC_RG_ID);
+    icc_hdr->icc_rg_id_tlv.len = htons(TLV_L_ICC_RG_ID);
+    icc_hdr->icc_rg_id_tlv.icc_rg_id = htonl(bench_cfg.mlag_id);
+
+    return msg_len;
+}
+
+static void bench_peer_fill_param(void *tlv, uint16_t type, size_t tlv_len)
+{
+    ICCParameter *param = (ICCParameter *)tlv;
+
+    *(uint16_t *)param = htons(type);
+    param->len = htons(tlv_len - sizeof(ICCParameter));
+}
+
+static int bench_peer_send_connect()
+{
+    char buf[128];
+    LDPHdr *ldp_hdr = (LDPHdr *)buf;
+    LDPICCPCapabilityTLV *cap = (LDPICCPCapabilityTLV *)&buf[sizeof(LDPHdr)];
+    ICCSenderNameTLV *sender = (ICCSenderNameTLV *)&buf[sizeof(ICCHdr)];
+    const char *name = "iccpd-bench";
+    size_t msg_len = sizeof(LDPHdr) + sizeof(LDPICCPCapabilityTLV);
+
+    /* Capability, U bit set and S bit set */
+    memset(buf, 0, sizeof(buf));
+    *(uint16_t *)buf = htons(MSG_T_CAPABILITY);
+    ldp_hdr->msg_len = htons(msg_len - MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS);
+    ldp_hdr->msg_id = htonl(peer_msg_id++);
+    *(uint16_t *)cap = htons(0x8000 | TLV_T_ICCP_CAPABILITY);
+    cap->icc_parameter.len = htons(TLV_L_ICCP_CAPABILITY);
+    *(uint16_t *)((uint8_t *)cap + sizeof(ICCParameter)) = htons(0x8000);
+    cap->major_ver = 0x1;
+    cap->minior_ver = 0x0;
+    if (bench_conn_send(&peer_conn, buf, msg_len) < 0)
+        return -1;
+
+    /* RG connect with sender name */
+    memset(buf, 0, sizeof(buf));
+    msg_len = sizeof(ICCHdr) + sizeof(ICCParameter) + strlen(name);
+    bench_peer_fill_icc_header(buf, msg_len);
+    *(uint16_t *)buf = htons(MSG_T_RG_CONNECT);
+    *(uint16_t *)sender = htons(TLV_T_ICC_SENDER_NAME);
+    sender->icc_parameter.len = htons(strlen(name));
+    memcpy(sender->sender_name, name, strlen(name));
+
+    return bench_conn_send(&peer_conn, buf, msg_len);
+}
+
+static int bench_peer_send_sync_data(uint16_t req_num, int end)
+{
+    char buf[sizeof(ICCHdr) + sizeof(mLACPSyncDataTLV)];
+    mLACPSyncDataTLV *tlv = (mLACPSyncDataTLV *)&buf[sizeof(ICCHdr)];
+
+    memset(buf, 0, sizeof(buf));
+    bench_peer_fill_icc_header(buf, sizeof(buf));
+    bench_peer_fill_param(tlv, TLV_T_MLACP_SYNC_DATA, sizeof(*tlv));
+    tlv->req_num = htons(req_num);
+    tlv->flags = end ? htons(0x01) : 0;
+
+    return bench_conn_send(&peer_conn, buf, sizeof(buf));
+}
+
+/* Reply a sync request of iccpd: the peer has no aggregator or
+ * neighbor of its own, its remote MACs come later */
+static int bench_peer_send_sync_reply(uint16_t req_num)
+{
+    char buf[sizeof(ICCHdr) + sizeof(mLACPSysConfigTLV)];
+    mLACPSysConfigTLV *tlv = (mLACPSysConfigTLV *)&buf[sizeof(ICCHdr)];
+
+    if (bench_peer_send_sync_data(req_num, 0) < 0)
+        return -1;
+
+    memset(buf, 0, sizeof(buf));
+    bench_peer_fill_icc_header(buf, sizeof(buf));
+    bench_peer_fill_param(tlv, TLV_T_MLACP_SYSTEM_CONFIG, sizeof(*tlv));
+    memcpy(tlv->sys_id, peer_system_id, ETHER_ADDR_LEN);
+    tlv->sys_priority = htons(32768);
+    tlv->node_id = 0x02;
+    if (bench_conn_send(&peer_conn, buf, sizeof(buf)) < 0)
+        return -1;
+
+    return bench_peer_send_sync_data(req_num, 1);
+}
+
+static int bench_peer_send_sync_request()
+{
+    char buf[sizeof(ICCHdr) + sizeof(mLACPSyncReqTLV)];
+    mLACPSyncReqTLV *tlv = (mLACPSyncReqTLV *)&buf[sizeof(ICCHdr)];
+
+    memset(buf, 0, sizeof(buf));
+    bench_peer_fill_icc_header(buf, sizeof(buf));
+    bench_peer_fill_param(tlv, TLV_T_MLACP_SYNC_REQUEST, sizeof(*tlv));
+    /* C bit, S bit and request type 0x3FFF: all info */
+    *(uint16_t *)((uint8_t *)tlv + sizeof(ICCParameter) + sizeof(uint16_t)) = htons(0xFFFF);
+
+    return bench_conn_send(&peer_conn, buf, sizeof(buf));
+}
+
+static int bench_peer_send_heartbeat()
+{
+    char buf[sizeof(ICCHdr) + sizeof(struct mLACPHeartbeatTLV)];
+    struct mLACPHeartbeatTLV *tlv = (struct mLACPHeartbeatTLV *)&buf[sizeof(ICCHdr)];
+
+    memset(buf, 0, sizeof(buf));
+    bench_peer_fill_icc_header(buf, sizeof(buf));
+    bench_peer_fill_param(tlv, TLV_T_MLACP_HEARTBEAT, sizeof(*tlv));
+    tlv->heartbeat = 0xFF;
+
+    return bench_conn_send(&peer_conn, buf, sizeof(buf));
+}
+
+/* Remote MAC add/del for count entries of a MAC space, in batches */
+static int bench_peer_send_mac(int space, int count, uint8_t op_type)
+{
+    static char buf[sizeof(ICCHdr) + sizeof(struct mLACPMACInfoTLV)
+                    + BENCH_MAC_TLV_BATCH * sizeof(struct mLACPMACData)];
+    struct mLACPMACInfoTLV *tlv = (struct mLACPMACInfoTLV *)&buf[sizeof(ICCHdr)];
+    struct mLACPMACData *data;
+    size_t msg_len;
+    int i, n = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        data = &tlv->MacEntry[n];
+        memset(data, 0, sizeof(*data));
+        data->type = op_type;
+        data->mac_type = MAC_TYPE_DYNAMIC;
+        bench_mac(data->mac_addr, space, i);
+        data->vid = htons(bench_cfg.vid);
+        snprintf(data->ifname, sizeof(data->ifname), "%s", bench_cfg.po_name);
+
+        if (++n == BENCH_MAC_TLV_BATCH || i == count - 1)
+        {
+            msg_len = sizeof(ICCHdr) + sizeof(struct mLACPMACInfoTLV) + n * sizeof(struct mLACPMACData);
+            bench_peer_fill_icc_header(buf, msg_len);
+            bench_peer_fill_param(tlv, TLV_T_MLACP_MAC_INFO, msg_len - sizeof(ICCHdr));
+            tlv->num_of_entry = htons(n);
+            if (bench_conn_send(&peer_conn, buf, msg_len) < 0)
+                return -1;
+            n = 0;
+        }
+    }
+
+    return 0;
+}
+
+static int bench_peer_connect()
+{
+    struct sockaddr_in addr;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    inet_pton(AF_INET, BENCH_PEER_IP, &addr.sin_addr);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    addr.sin_port = htons(BENCH_ICCP_PORT);
+    inet_pton(AF_INET, BENCH_LOCAL_IP, &addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    bench_conn_attach(&peer_conn, fd);
+    peer_sync_req_sent = 0;
+    peer_last_heartbeat = bench_now_ms();
+
+    return bench_peer_send_connect();
+}
+
+static void bench_peer_handle_app_data(char *buf, size_t len)
+{
+    ICCParameter *param = (ICCParameter *)&buf[sizeof(ICCHdr)];
+    struct mLACPMACInfoTLV *mac_tlv;
+    struct mLACPARPInfoTLV *arp_tlv;
+    size_t num, i;
+
+    if (len < sizeof(ICCHdr) + sizeof(ICCParameter))
+        return;
+
+    switch (ntohs(*(uint16_t *)param) & 0x3FFF)
+    {
+        case TLV_T_MLACP_SYNC_REQUEST:
+            /* Stage 1, iccpd is standby and requests first */
+            bench_peer_send_sync_reply(ntohs(((mLACPSyncReqTLV *)param)->req_num));
+            if (!peer_sync_req_sent)
+            {
+                bench_peer_send_sync_request();
+                peer_sync_req_sent = 1;
+            }
+            break;
+
+        case TLV_T_MLACP_SYNC_DATA:
+            if (ntohs(((mLACPSyncDataTLV *)param)->flags) == 1)
+                ++bench_stats.peer_sync_done;
+            break;
+
+        case TLV_T_MLACP_MAC_INFO:
+            mac_tlv = (struct mLACPMACInfoTLV *)param;
+            num = ntohs(mac_tlv->num_of_entry);
+            for (i = 0; i < num
+                 && sizeof(ICCHdr) + sizeof(*mac_tlv) + (i + 1) * sizeof(struct mLACPMACData) <= len; ++i)
+            {
+                if (mac_tlv->MacEntry[i].type == MAC_SYNC_DEL)
+                    ++bench_stats.peer_mac_del;
+                else
+                    ++bench_stats.peer_mac_add;
+            }
+            break;
+
+        case TLV_T_MLACP_ARP_INFO:
+            arp_tlv = (struct mLACPARPInfoTLV *)param;
+            num = ntohs(arp_tlv->num_of_entry);
+            for (i = 0; i < num
+                 && sizeof(ICCHdr) + sizeof(*arp_tlv) + (i + 1) * sizeof(struct ARPMsg) <= len; ++i)
+            {
+                if (arp_tlv->ArpEntry[i].op_type == NEIGH_SYNC_DEL)
+                    ++bench_stats.peer_arp_del;
+                else
+                    ++bench_stats.peer_arp_add;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static int bench_peer_rx()
+{
+    size_t pos = 0, msg_len;
+    uint16_t msg_type;
+
+    if (bench_conn_recv(&peer_conn) < 0)
+        return -1;
+
+    while (peer_conn.rx_len - pos >= sizeof(LDPHdr))
+    {
+        msg_type = ntohs(*(uint16_t *)(peer_conn.rx_buf + pos)) & 0x7FFF;
+        msg_len = ntohs(((LDPHdr *)(peer_conn.rx_buf + pos))->msg_len) + MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS;
+        if (peer_conn.rx_len - pos < msg_len)
+            break;
+
+        ++bench_stats.peer_rx_msgs;
+        bench_stats.peer_rx_bytes += msg_len;
+        if (msg_type == MSG_T_RG_CONNECT)
+            bench_stats.peer_rg_connect = 1;
+        else if (msg_type == MSG_T_RG_APP_DATA)
+            bench_peer_handle_app_data(peer_conn.rx_buf + pos, msg_len);
+        pos += msg_len;
+    }
+    bench_conn_consume(&peer_conn, pos);
+
+    return 0;
+}
+
+/*****************************************
+* Kernel neighbors and mclagdctl queries
+*
+* ***************************************/
+static int bench_neigh_update(int ifindex, int count, int add)
+{
+    struct
+    {
+        struct nlmsghdr n;
+        struct ndmsg ndm;
+        char attrs[64];
+    } *req;
+    static char buf[BENCH_NEIGH_BATCH * NLMSG_ALIGN(sizeof(*req))];
+    char rx[8192];
+    struct sockaddr_nl nladdr = { .nl_family = AF_NETLINK };
+    struct rtattr *rta;
+    struct nlmsghdr *nlh;
+    uint32_t ip;
+    uint8_t mac[ETHER_ADDR_LEN];
+    size_t len = 0;
+    ssize_t rx_len;
+    int fd, i, errors = 0, last_err = 0;
+
+    fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (fd < 0)
+        return -1;
+
+    for (i = 0; i < count; ++i)
+    {
+        req = (void *)(buf + len);
+        memset(req, 0, sizeof(*req));
+        req->n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+        req->n.nlmsg_type = add ? RTM_NEWNEIGH : RTM_DELNEIGH;
+        req->n.nlmsg_flags = NLM_F_REQUEST | (add ? NLM_F_CREATE | NLM_F_REPLACE : 0);
+        req->n.nlmsg_seq = i + 1;
+        req->ndm.ndm_family = AF_INET;
+        req->ndm.ndm_ifindex = ifindex;
+        req->ndm.ndm_type = RTN_UNICAST;
+        /* Externally learned entries are not garbage collected */
+        req->ndm.ndm_state = NUD_REACHABLE;
+        req->ndm.ndm_flags = NTF_EXT_LEARNED;
+
+        ip = htonl(bench_cfg.neigh_base + i);
+        rta = (struct rtattr *)((char *)&req->n + NLMSG_ALIGN(req->n.nlmsg_len));
+        rta->rta_type = NDA_DST;
+        rta->rta_len = RTA_LENGTH(sizeof(ip));
+        memcpy(RTA_DATA(rta), &ip, sizeof(ip));
+        req->n.nlmsg_len = NLMSG_ALIGN(req->n.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+        if (add)
+        {
+            bench_mac(mac, BENCH_MAC_NEIGH, i);
+            rta = (struct rtattr *)((char *)&req->n + NLMSG_ALIGN(req->n.nlmsg_len));
+            rta->rta_type = NDA_LLADDR;
+            rta->rta_len = RTA_LENGTH(ETHER_ADDR_LEN);
+            memcpy(RTA_DATA(rta), mac, ETHER_ADDR_LEN);
+            req->n.nlmsg_len = NLMSG_ALIGN(req->n.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+        }
+        len += NLMSG_ALIGN(req->n.nlmsg_len);
+
+        if ((i + 1) % BENCH_NEIGH_BATCH != 0 && i != count - 1)
+            continue;
+
+        if (sendto(fd, buf, len, 0, (struct sockaddr *)&nladdr, sizeof(nladdr)) < 0)
+        {
+            fprintf(stderr, "neighbor update: %s\n", strerror(errno));
+            close(fd);
+            return -1;
+        }
+        len = 0;
+
+        /* Only errors are reported back */
+        while ((rx_len = recv(fd, rx, sizeof(rx), MSG_DONTWAIT)) > 0)
+        {
+            for (nlh = (struct nlmsghdr *)rx; NLMSG_OK(nlh, rx_len); nlh = NLMSG_NEXT(nlh, rx_len))
+            {
+                /* iccpd may have removed neighbors already */
+                if (nlh->nlmsg_type == NLMSG_ERROR && ((struct nlmsgerr *)NLMSG_DATA(nlh))->error
+                    && (add || ((struct nlmsgerr *)NLMSG_DATA(nlh))->error != -ENOENT))
+                {
+                    ++errors;
+                    last_err = -((struct nlmsgerr *)NLMSG_DATA(nlh))->error;
+                }
+            }
+        }
+    }
+    close(fd);
+
+    if (errors)
+    {
+        fprintf(stderr, "neighbor %s failed for %d entries: %s\n", add ? "add" : "del", errors, strerror(last_err));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Number of entries of a mclagdctl dump, -1 if iccpd can't be queried */
+static int bench_ctl_count(int info_type, size_t entry_size)
+{
+    struct sockaddr_un addr;
+    struct mclagdctl_req_hdr req;
+    struct mclagd_reply_hdr *reply;
+    struct timeval tv = { .tv_sec = 5 };
+    char *buf;
+    ssize_t ret;
+    int fd, total_len, len = 0, count = -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", bench_cfg.ctl_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.info_type = info_type;
+    req.mclag_id = bench_cfg.mlag_id;
+    if (write(fd, &req, sizeof(req)) != sizeof(req)
+        || recv(fd, &total_len, sizeof(total_len), MSG_WAITALL) != sizeof(total_len)
+        || total_len < (int)sizeof(struct mclagd_reply_hdr))
+    {
+        close(fd);
+        return -1;
+    }
+
+    buf = malloc(total_len);
+    while (buf && len < total_len)
+    {
+        ret = recv(fd, buf + len, total_len - len, 0);
+        if (ret <= 0)
+            break;
+        len += ret;
+    }
+
+    if (buf && len == total_len)
+    {
+        reply = (struct mclagd_reply_hdr *)buf;
+        if (reply->exec_result == EXEC_TYPE_SUCCESS)
+            count = reply->data_len / entry_size;
+        else
+            count = 0;
+    }
+    free(buf);
+    close(fd);
+
+    return count;
+}
+
+/*****************************************
+* Event loop
+*
+* ***************************************/
+static int bench_iccpd_alive()
+{
+    int status;
+
+    if (bench_cfg.pid <= 0)
+        return 1;
+
+    if (bench_cfg.iccpd_path)
+        return waitpid(bench_cfg.pid, &status, WNOHANG) == 0;
+
+    return kill(bench_cfg.pid, 0) == 0;
+}
+
+/* Serve both simulated ends until done() or the phase timeout,
+ * returns 0 if done */
+static int bench_run_until(int (*done)(void))
+{
+    struct pollfd fds[3];
+    double start = bench_now_ms(), now;
+    int nfds, fd;
+
+    while (1)
+    {
+        if (done())
+            return 0;
+
+        now = bench_now_ms();
+        if (now - start > bench_cfg.timeout_ms)
+            return -1;
+
+        if (!bench_iccpd_alive())
+        {
+            fprintf(stderr, "iccpd exited\n");
+            return -1;
+        }
+
+        if (peer_conn.fd >= 0 && now - peer_last_heartbeat >= BENCH_HEARTBEAT_MS)
+        {
+            bench_peer_send_heartbeat();
+            peer_last_heartbeat = now;
+        }
+
+        nfds = 0;
+        if (syncd_listen_fd >= 0 && syncd_conn.fd < 0)
+        {
+            fds[nfds].fd = syncd_listen_fd;
+            fds[nfds++].events = POLLIN;
+        }
+        if (syncd_conn.fd >= 0)
+        {
+            fds[nfds].fd = syncd_conn.fd;
+            fds[nfds++].events = POLLIN | (syncd_conn.tx_tail > syncd_conn.tx_head ? POLLOUT : 0);
+        }
+        if (peer_conn.fd >= 0)
+        {
+            fds[nfds].fd = peer_conn.fd;
+            fds[nfds++].events = POLLIN | (peer_conn.tx_tail > peer_conn.tx_head ? POLLOUT : 0);
+        }
+
+        if (poll(fds, nfds, BENCH_POLL_MS) <= 0)
+            continue;
+
+        while (nfds-- > 0)
+        {
+            if (!fds[nfds].revents)
+                continue;
+
+            if (fds[nfds].fd == syncd_listen_fd)
+            {
+                fd = accept(syncd_listen_fd, NULL, NULL);
+                if (fd >= 0)
+                    bench_conn_attach(&syncd_conn, fd);
+            }
+            else if (fds[nfds].fd == syncd_conn.fd)
+            {
+                if (bench_conn_flush(&syncd_conn) < 0 || bench_syncd_rx() < 0)
+                {
+                    fprintf(stderr, "iccpd closed the mclagsyncd connection\n");
+                    bench_conn_close(&syncd_conn);
+                }
+            }
+            else if (fds[nfds].fd == peer_conn.fd)
+            {
+                if (bench_conn_flush(&peer_conn) < 0 || bench_peer_rx() < 0)
+                    bench_conn_close(&peer_conn);
+            }
+        }
+    }
+}
+
+/* Poll a mclagdctl table while serving connections */
+static int ctl_info_type;
+static size_t ctl_entry_size;
+static int ctl_expected;
+static double ctl_next_poll;
+
+static int bench_ctl_count_reached()
+{
+    if (bench_now_ms() < ctl_next_poll)
+        return 0;
+    ctl_next_poll = bench_now_ms() + BENCH_CTL_POLL_MS;
+
+    return bench_ctl_count(ctl_info_type, ctl_entry_size) >= ctl_expected;
+}
+
+static int bench_wait_ctl_count(int info_type, size_t entry_size, int expected)
+{
+    ctl_info_type = info_type;
+    ctl_entry_size = entry_size;
+    ctl_expected = expected;
+    ctl_next_poll = 0;
+
+    return bench_run_until(bench_ctl_count_reached);
+}
+
+static int bench_syncd_connected()
+{
+    return syncd_conn.fd >= 0;
+}
+
+static int bench_peer_session_up()
+{
+    return bench_stats.peer_rg_connect;
+}
+
+static int bench_peer_sync_done()
+{
+    return bench_stats.peer_sync_done > 0;
+}
+
+static int bench_peer_macs_synced()
+{
+    return bench_stats.peer_mac_add >= (unsigned long)bench_cfg.mac_count;
+}
+
+static int bench_peer_arps_synced()
+{
+    return bench_stats.peer_arp_add >= (unsigned long)bench_cfg.arp_count;
+}
+
+static int bench_fdb_added()
+{
+    return bench_stats.fdb_add >= (unsigned long)bench_cfg.remote_count;
+}
+
+static int bench_peer_updates_added()
+{
+    return bench_stats.peer_mac_add >= (unsigned long)bench_cfg.update_count;
+}
+
+static int bench_peer_updates_deleted()
+{
+    return bench_stats.peer_mac_del >= (unsigned long)bench_cfg.update_count;
+}
+
+static int bench_iccp_state_sent()
+{
+    return bench_stats.iccp_state > 0;
+}
+
+static int bench_fdb_flushed()
+{
+    return bench_stats.fdb_local_add >= (unsigned long)bench_cfg.remote_count;
+}
+
+/*****************************************
+* Phases
+*
+* ***************************************/
+static double bench_elapsed(double start, int ret)
+{
+    return ret == 0 ? bench_now_ms() - start : -1;
+}
+
+static void bench_print_memory()
+{
+    printf(", \"rss_kb\": %ld, \"hwm_kb\": %ld}\n", bench_proc_status_kb("VmRSS"), bench_proc_status_kb("VmHWM"));
+    fflush(stdout);
+}
+
+static int bench_phase_load(int ifindex)
+{
+    double start, mac_ms, arp_ms = 0;
+    int ret;
+
+    start = bench_now_ms();
+    ret = bench_syncd_send_fdb(BENCH_MAC_LOCAL, bench_cfg.mac_count, MAC_SYNC_ADD);
+    if (ret == 0)
+        ret = bench_wait_ctl_count(INFO_TYPE_DUMP_MAC, sizeof(struct mclagd_mac_msg), bench_cfg.mac_count);
+    mac_ms = bench_elapsed(start, ret);
+
+    if (ret == 0 && bench_cfg.arp_count > 0)
+    {
+        start = bench_now_ms();
+        ret = bench_neigh_update(ifindex, bench_cfg.arp_count, 1);
+        if (ret == 0)
+            ret = bench_wait_ctl_count(INFO_TYPE_DUMP_ARP, sizeof(struct mclagd_arp_msg), bench_cfg.arp_count);
+        arp_ms = bench_elapsed(start, ret);
+    }
+
+    printf("{\"phase\": \"load\", \"macs\": %d, \"mac_ms\": %.3f, \"arps\": %d, \"arp_ms\": %.3f",
+           bench_cfg.mac_count, mac_ms, bench_cfg.arp_count, arp_ms);
+    bench_print_memory();
+
+    return ret;
+}
+
+static int bench_phase_initial_sync()
+{
+    double start, session_ms, sync_ms = -1, mac_ms = -1, arp_ms = -1;
+    int ret;
+
+    memset(&bench_stats, 0, sizeof(bench_stats));
+    start = bench_now_ms();
+    while ((ret = bench_peer_connect()) < 0 && bench_now_ms() - start < bench_cfg.timeout_ms)
+        usleep(100000);
+
+    if (ret == 0)
+        ret = bench_run_until(bench_peer_session_up);
+    session_ms = bench_elapsed(start, ret);
+
+    if (ret == 0)
+    {
+        ret = bench_run_until(bench_peer_sync_done);
+        sync_ms = bench_elapsed(start, ret);
+    }
+    if (ret == 0)
+    {
+        ret = bench_run_until(bench_peer_macs_synced);
+        mac_ms = bench_elapsed(start, ret);
+    }
+    if (ret == 0)
+    {
+        ret = bench_run_until(bench_peer_arps_synced);
+        arp_ms = bench_elapsed(start, ret);
+    }
+
+    printf("{\"phase\": \"initial_sync\", \"session_ms\": %.3f, \"sync_done_ms\": %.3f, "
+           "\"macs_ms\": %.3f, \"arps_ms\": %.3f, \"macs_rx\": %lu, \"arps_rx\": %lu, "
+           "\"msgs_rx\": %lu, \"bytes_rx\": %lu",
+           session_ms, sync_ms, mac_ms, arp_ms, bench_stats.peer_mac_add, bench_stats.peer_arp_add,
+           bench_stats.peer_rx_msgs, bench_stats.peer_rx_bytes);
+    bench_print_memory();
+
+    return ret;
+}
+
+static int bench_phase_remote_update()
+{
+    double start, ms;
+    int ret;
+
+    bench_stats.fdb_add = 0;
+    start = bench_now_ms();
+    ret = bench_peer_send_mac(BENCH_MAC_REMOTE, bench_cfg.remote_count, MAC_SYNC_ADD);
+    if (ret == 0)
+        ret = bench_run_until(bench_fdb_added);
+    ms = bench_elapsed(start, ret);
+
+    printf("{\"phase\": \"remote_update\", \"macs\": %d, \"ms\": %.3f, \"per_sec\": %.0f, \"fdb_rx\": %lu",
+           bench_cfg.remote_count, ms, ms > 0 ? bench_cfg.remote_count * 1000.0 / ms : 0, bench_stats.fdb_add);
+    bench_print_memory();
+
+    return ret;
+}
+
+static int bench_phase_local_update()
+{
+    double start, add_ms, del_ms = -1;
+    int ret;
+
+    bench_stats.peer_mac_add = 0;
+    bench_stats.peer_mac_del = 0;
+    start = bench_now_ms();
+    ret = bench_syncd_send_fdb(BENCH_MAC_UPDATE, bench_cfg.update_count, MAC_SYNC_ADD);
+    if (ret == 0)
+        ret = bench_run_until(bench_peer_updates_added);
+    add_ms = bench_elapsed(start, ret);
+
+    if (ret == 0)
+    {
+        start = bench_now_ms();
+        ret = bench_syncd_send_fdb(BENCH_MAC_UPDATE, bench_cfg.update_count, MAC_SYNC_DEL);
+        if (ret == 0)
+            ret = bench_run_until(bench_peer_updates_deleted);
+        del_ms = bench_elapsed(start, ret);
+    }
+
+    printf("{\"phase\": \"local_update\", \"macs\": %d, \"add_ms\": %.3f, \"add_per_sec\": %.0f, "
+           "\"del_ms\": %.3f, \"del_per_sec\": %.0f",
+           bench_cfg.update_count, add_ms, add_ms > 0 ? bench_cfg.update_count * 1000.0 / add_ms : 0,
+           del_ms, del_ms > 0 ? bench_cfg.update_count * 1000.0 / del_ms : 0);
+    bench_print_memory();
+
+    return ret;
+}
+
+static int bench_phase_failover()
+{
+    double start, state_ms, flush_ms = -1;
+    int ret;
+
+    bench_stats.iccp_state = 0;
+    bench_stats.fdb_local_add = 0;
+    start = bench_now_ms();
+    bench_conn_close(&peer_conn);
+
+    ret = bench_run_until(bench_iccp_state_sent);
+    state_ms = bench_elapsed(start, ret);
+    if (ret == 0)
+    {
+        ret = bench_run_until(bench_fdb_flushed);
+        flush_ms = bench_elapsed(start, ret);
+    }
+
+    printf("{\"phase\": \"failover\", \"macs\": %d, \"iccp_state_ms\": %.3f, \"flush_ms\": %.3f, \"fdb_rx\": %lu",
+           bench_cfg.remote_count, state_ms, flush_ms, bench_stats.fdb_local_add);
+    bench_print_memory();
+
+    return ret;
+}
+
+static pid_t bench_start_iccpd()
+{
+    pid_t pid;
+
+    pid = fork();
+    if (pid == 0)
+    {
+        execv(bench_cfg.iccpd_path, bench_cfg.iccpd_argv);
+        fprintf(stderr, "execv %s: %s\n", bench_cfg.iccpd_path, strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+
+    return pid;
+}
+
+int main(int argc, char **argv)
+{
+    int ifindex;
+    int ret = EXIT_FAILURE;
+    int opt;
+    struct in_addr base;
+    char *prog = basename(argv[0]);
+
+    while ((opt = getopt(argc, argv, "n:a:r:u:i:o:v:b:t:s:x:p:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                bench_cfg.mac_count = atoi(optarg);
+                break;
+            case 'a':
+                bench_cfg.arp_count = atoi(optarg);
+                break;
+            case 'r':
+                bench_cfg.remote_count = atoi(optarg);
+                break;
+            case 'u':
+                bench_cfg.update_count = atoi(optarg);
+                break;
+            case 'i':
+                bench_cfg.mlag_id = atoi(optarg);
+                break;
+            case 'o':
+                snprintf(bench_cfg.po_name, sizeof(bench_cfg.po_name), "%s", optarg);
+                break;
+            case 'v':
+                bench_cfg.vid = atoi(optarg);
+                break;
+            case 'b':
+                if (inet_pton(AF_INET, optarg, &base) != 1)
+                {
+                    fprintf(stderr, "invalid neighbor base ip '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                bench_cfg.neigh_base = ntohl(base.s_addr);
+                break;
+            case 't':
+                bench_cfg.timeout_ms = atoi(optarg) * 1000;
+                break;
+            case 's':
+                snprintf(bench_cfg.ctl_path, sizeof(bench_cfg.ctl_path), "%s", optarg);
+                break;
+            case 'x':
+                bench_cfg.iccpd_path = optarg;
+                break;
+            case 'p':
+                bench_cfg.pid = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                usage(prog);
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (bench_cfg.arp_count < 0)
+        bench_cfg.arp_count = bench_cfg.mac_count;
+    if (bench_cfg.remote_count < 0)
+        bench_cfg.remote_count = bench_cfg.mac_count;
+    if (bench_cfg.update_count < 0)
+        bench_cfg.update_count = bench_cfg.mac_count;
+
+    if ((!bench_cfg.iccpd_path && bench_cfg.pid <= 0) || bench_cfg.mac_count <= 0
+        || bench_cfg.remote_count <= 0 || bench_cfg.update_count <= 0 || bench_cfg.timeout_ms <= 0)
+    {
+        usage(prog);
+        return EXIT_FAILURE;
+    }
+
+    ifindex = if_nametoindex(bench_cfg.po_name);
+    if (ifindex == 0)
+    {
+        fprintf(stderr, "interface %s does not exist, see %s -h\n", bench_cfg.po_name, prog);
+        return EXIT_FAILURE;
+    }
+
+    syncd_listen_fd = bench_syncd_listen();
+    if (syncd_listen_fd < 0)
+        return EXIT_FAILURE;
+
+    if (bench_cfg.iccpd_path)
+    {
+        /* Arguments after "--" are passed to iccpd */
+        argv[optind - 1] = bench_cfg.iccpd_path;
+        bench_cfg.iccpd_argv = &argv[optind - 1];
+        bench_cfg.pid = bench_start_iccpd();
+        if (bench_cfg.pid < 0)
+        {
+            fprintf(stderr, "fork: %s\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bench_run_until(bench_syncd_connected) < 0)
+    {
+        fprintf(stderr, "iccpd did not connect to mclagsyncd\n");
+        goto out;
+    }
+
+    printf("{\"phase\": \"start\", \"pid\": %d", (int)bench_cfg.pid);
+    bench_print_memory();
+
+    if (bench_syncd_send_config() < 0)
+        goto out;
+
+    if (bench_phase_load(ifindex) < 0
+        || bench_phase_initial_sync() < 0
+        || bench_phase_remote_update() < 0
+        || bench_phase_local_update() < 0
+        || bench_phase_failover() < 0)
+    {
+        fprintf(stderr, "phase timed out after %d sec\n", bench_cfg.timeout_ms / 1000);
+        goto out;
+    }
+
+    ret = EXIT_SUCCESS;
+
+out:
+    if (bench_cfg.iccpd_path && bench_cfg.pid > 0)
+    {
+        kill(bench_cfg.pid, SIGTERM);
+        waitpid(bench_cfg.pid, NULL, 0);
+    }
+    if (bench_cfg.arp_count > 0)
+        bench_neigh_update(ifindex, bench_cfg.arp_count, 0);
+    bench_conn_close(&peer_conn);
+    bench_conn_close(&syncd_conn);
+    close(syncd_listen_fd);
+
+    return ret;
+}
@@ -36,8 +36,13 @@
 #include "../include/app_csm.h"
 #include "../include/msg_format.h"
 #include "../include/port.h"
+#include "../include/scheduler.h"
 
 #define CSM_BUFFER_SIZE 65536
+/* Per session receive buffer, fits a partial frame plus a maximum size one */
+#define CSM_RX_BUFFER_SIZE (CSM_BUFFER_SIZE * 2)
+/* MAC entries allocated per slab */
+#define MAC_MSG_POOL_CHUNK 1024
 
 #ifndef IFNAMSIZ
 #define IFNAMSIZ 16
@@ -71,12 +76,29 @@ struct IccpInfo
     uint32_t rejected_msg_id;
 };
 
+/* Session receive buffer. Frames are queued in place, each holds a
+ * reference until it is freed */
+struct RxBuf
+{
+    int refcnt;
+    char data[CSM_RX_BUFFER_SIZE];
+};
+
 /* Receive message node */
 struct Msg
 {
     char* buf;
     size_t len;
+    /* Receive buffer buf points into, NULL if buf is allocated */
+    struct RxBuf* rx_buf;
     TAILQ_ENTRY(Msg) tail;
+    /* ARP/ND table indexes, by IP and by interface name */
+    LIST_ENTRY(Msg) neigh_ip_next;
+    LIST_ENTRY(Msg) neigh_if_next;
+    /* ARP/ND entry content last exchanged with the peer, 0 if none */
+    uint32_t sync_digest;
+    /* Time read from the peer, or queued for it by a local learn event */
+    uint64_t trace_usec;
 };
 
 /* Connection state */
@@ -106,6 +128,8 @@ struct CSM
 
     /* Socket info */
     int sock_fd;
+    int conn_fd;            /* non-blocking connect in progress, -1 if none */
+    int conn_backoff_sec;   /* interval before next connect attempt */
     pthread_mutex_t conn_mutex;
     time_t connTimePrev;
     time_t heartbeat_send_time;
@@ -113,6 +137,7 @@ struct CSM
     time_t peer_warm_reboot_time;
     time_t warm_reboot_disconn_time;
     char peer_itf_name[IFNAMSIZ];
+    uint16_t peer_itf_id;   /* Interned peer_itf_name */
     time_t peer_link_learning_retry_time;
     char peer_ip[INET_ADDRSTRLEN];
     char sender_ip[INET_ADDRSTRLEN];
@@ -122,9 +147,20 @@ struct CSM
     int session_timeout;
     int peer_link_learning_enable;
 
+    /* Received bytes, allocated on the first read of a connection. Bytes
+     * from rx_start to rx_len are not yet parsed into ICCP frames */
+    struct RxBuf* rx_buf;
+    size_t rx_start;
+    size_t rx_len;
+    int rx_resume_count;    /* EPOLLIN events spent on current partial frame */
+
     /* Msg queue */
     TAILQ_HEAD(msg_list, Msg) msg_list;
 
+    /* FSMs run on the next scheduler iteration only when set */
+    int fsm_dirty;
+    struct SchedTimer fsm_timer;
+
     /* STP role */
     stp_role_type_et role_type;
 
@@ -148,6 +184,12 @@ struct CSM
 };
 int iccp_csm_send(struct CSM*, char*, int);
 int iccp_csm_init_msg(struct Msg**, char*, int);
+int iccp_csm_init_rx_msg(struct Msg**, struct RxBuf*, size_t, int);
+int iccp_csm_detach_msg(struct Msg*);
+void iccp_csm_free_msg(struct Msg*);
+struct RxBuf* iccp_csm_rx_buf_alloc();
+void iccp_csm_rx_buf_put(struct RxBuf*);
+void iccp_csm_rx_release(struct CSM*);
 int iccp_csm_prepare_nak_msg(struct CSM*, char*, size_t);
 int iccp_csm_prepare_iccp_msg(struct CSM*, char*, size_t);
 int iccp_csm_prepare_capability_msg(struct CSM*, char*, size_t);
@@ -170,4 +212,5 @@ void iccp_csm_correspond_from_rg_disconnect_msg(struct CSM*, struct Msg*);
 
 int mlacp_bind_port_channel_to_csm(struct CSM* csm, const char *ifname);
 int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len);
+void iccp_csm_free_mac_msg(struct MACMsg* mac_msg);
 #endif /* ICCP_CSM_H_ */
@@ -27,6 +27,7 @@
 #include <netlink/netlink.h>
 
 int iccp_sys_local_if_list_get_init();
+int iccp_sys_local_if_list_resync();
 
 int iccp_neigh_get_init();
 
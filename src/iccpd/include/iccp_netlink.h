@@ -44,21 +44,28 @@ struct nd_msg
     __u8 opt[0];
 };
 
+/* glibc provides it with _GNU_SOURCE */
+#ifndef __USE_GNU
 struct in6_pktinfo
 {
     struct in6_addr ipi6_addr;  /* src/dst IPv6 address */
     unsigned int ipi6_ifindex;  /* send/recv interface index */
 };
+#endif
 
 int iccp_get_port_member_list(struct LocalInterface *lif);
+int iccp_get_port_member_list_async(struct LocalInterface *lif);
 void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg);
 void iccp_event_handler_obj_input_dellink(struct nl_object *obj, void *arg);
+void iccp_event_handler_obj_resync_link(struct nl_object *obj, void *arg);
 int iccp_system_init_netlink_socket();
 void iccp_system_dinit_netlink_socket();
 int iccp_init_netlink_event_fd(struct System *sys);
 int iccp_handle_events(struct System *sys);
 void update_if_ipmac_on_standby(struct LocalInterface *lif_po, int dir);
 int iccp_sys_local_if_list_get_addr();
+void iccp_netlink_neigh_batch_flush();
+void iccp_netlink_sync_again();
 int iccp_netlink_neighbor_request(int family, uint8_t *addr, int add, uint8_t *mac, char *portname, int permanent, int dir);
 int iccp_check_if_addr_from_netlink(int family, uint8_t *addr, struct LocalInterface *lif);
 
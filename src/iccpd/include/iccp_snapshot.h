@@ -0,0 +1,35 @@
+/*
+ * iccp_snapshot.h
+ *
+ * Copyright(c) 2016-2019 Nephos/Estinet.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ *
+ *  Maintainer: jianjun, grace Li from nephos
+ */
+
+#ifndef ICCP_SNAPSHOT_H
+#define ICCP_SNAPSHOT_H
+
+#include "../include/system.h"
+#include "../include/iccp_csm.h"
+
+int iccp_snapshot_save(struct System* sys);
+int iccp_snapshot_load(struct System* sys);
+void iccp_snapshot_restore(struct CSM* csm);
+void iccp_snapshot_discard();
+
+#endif /* ICCP_SNAPSHOT_H */
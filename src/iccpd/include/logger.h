@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 #include <syslog.h>
+#include <time.h>
 
 #include "../include/cmd_option.h"
 
@@ -43,12 +44,42 @@ typedef enum _iccpd_log_level_t
 #define LOGBUF_SIZE 1024
 #define ICCPD_UTILS_SYSLOG    (syslog)
 
+/* Messages queued for the log thread */
+#define LOG_RING_SLOTS                  1024
+/* Log thread poll interval if waiting on the wakeup eventfd fails */
+#define LOG_WAKEUP_RETRY_USEC           10000
+/* Messages per call site and interval before the rest is suppressed,
+ * errors and critical messages are never suppressed */
+#define LOG_RATE_LIMIT_BURST            20
+#define LOG_RATE_LIMIT_INTERVAL_SEC     1
+
+/* Rate limit state, one per ICCPD_LOG_* call site. tag, level and next
+ * are set when the call site first suppresses a message, so the log
+ * thread can report the suppressed count once the interval is over */
+struct LogRateLimit
+{
+    time_t interval_start;
+    uint32_t count;
+    uint32_t suppressed;
+    int level;
+    const char* tag;
+    struct LogRateLimit* next;
+};
+
+#define ICCPD_LOG_RATELIMIT(level, tag, format, args ...) \
+    do \
+    { \
+        static struct LogRateLimit _log_rate_limit; \
+        if ((level) <= logger_get_configuration()->log_level) \
+            write_log_ratelimit(&_log_rate_limit, level, tag, format, ## args); \
+    } while (0)
+
 #define ICCPD_LOG_CRITICAL(tag, format, args ...) write_log(CRITICAL_LOG_LEVEL, tag, format, ## args)
 #define ICCPD_LOG_ERR(tag, format, args ...) write_log(ERR_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_WARN(tag, format, args ...) write_log(WARN_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_NOTICE(tag, format, args ...) write_log(NOTICE_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_INFO(tag, format, args ...) write_log(INFO_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_DEBUG(tag, format, args ...) write_log(DEBUG_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_WARN(tag, format, args ...) ICCPD_LOG_RATELIMIT(WARN_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_NOTICE(tag, format, args ...) ICCPD_LOG_RATELIMIT(NOTICE_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_INFO(tag, format, args ...) ICCPD_LOG_RATELIMIT(INFO_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_DEBUG(tag, format, args ...) ICCPD_LOG_RATELIMIT(DEBUG_LOG_LEVEL, tag, format, ## args)
 
 struct LoggerConfig
 {
@@ -64,6 +95,7 @@ void log_setup(char* progname, char* path);
 void log_finalize();
 void log_init(struct CmdOptionParser* parser);
 void write_log(const int level, const char* tag, const char *format, ...);
+void write_log_ratelimit(struct LogRateLimit* rate_limit, const int level, const char* tag, const char *format, ...);
 
 #endif /* LOGGER_H_ */
 
@@ -148,6 +148,29 @@ typedef struct mlacp_dbg_counter_info
     uint64_t iccp_counters[ICCP_DBG_CNTR_MSG_MAX][ICCP_DBG_CNTR_DIR_MAX][ICCP_DBG_CNTR_STS_MAX];
 }mlacp_dbg_counter_info_t;
 
+/* Number of buckets of ARP/ND table indexes, power of 2 */
+#define NEIGH_IP_HASH_SIZE      8192
+#define NEIGH_IF_HASH_SIZE      256
+
+/* Number of buckets of MAC table index by origin interface, power of 2 */
+#define MAC_IF_HASH_SIZE        256
+#define MAC_IF_HASH(ifname_id)  ((ifname_id) & (MAC_IF_HASH_SIZE - 1))
+
+/* Walk the MAC entries that may have been learned on ifname_id, callers
+ * still compare origin_ifname_id. Current entry may be removed */
+#define MAC_IF_FOREACH_SAFE(var, csm, ifname_id, tvar) \
+    for ((var) = LIST_FIRST(&MLACP(csm).mac_if_hash[MAC_IF_HASH(ifname_id)]); \
+         (var) && ((tvar) = LIST_NEXT((var), mac_if_next), 1); \
+         (var) = (tvar))
+
+/* Digest of the ARP/ND entries last exchanged with the peer, a sum of
+ * the entries' Msg.sync_digest */
+struct mLACPSyncDigest
+{
+    uint32_t count;
+    uint32_t sum;
+};
+
 struct mLACP
 {
     int id;
@@ -170,9 +193,22 @@ struct mLACP
     TAILQ_HEAD(arp_info_list, Msg) arp_list;
     TAILQ_HEAD(ndisc_msg_list, Msg) ndisc_msg_list;
     TAILQ_HEAD(ndisc_info_list, Msg) ndisc_list;
+    LIST_HEAD(arp_ip_hash_list, Msg) arp_ip_hash[NEIGH_IP_HASH_SIZE];
+    LIST_HEAD(arp_if_hash_list, Msg) arp_if_hash[NEIGH_IF_HASH_SIZE];
+    LIST_HEAD(ndisc_ip_hash_list, Msg) ndisc_ip_hash[NEIGH_IP_HASH_SIZE];
+    LIST_HEAD(ndisc_if_hash_list, Msg) ndisc_if_hash[NEIGH_IF_HASH_SIZE];
+
+    /* Incremental ARP/ND resync. Both peers keep the same digests and
+     * generation, a reconnecting peer sends them in its sync request */
+    uint32_t sync_gen;
+    uint8_t sync_digest_peer;
+    uint8_t sync_delta;
+    struct mLACPSyncDigest arp_digest;
+    struct mLACPSyncDigest ndisc_digest;
     TAILQ_HEAD(mac_msg_list, MACMsg) mac_msg_list;
 
     struct mac_rb_tree mac_rb;
+    LIST_HEAD(mac_if_hash_list, MACMsg) mac_if_hash[MAC_IF_HASH_SIZE];
 
     LIST_HEAD(lif_list, LocalInterface) lif_list;
     LIST_HEAD(lif_purge_list, LocalInterface) lif_purge_list;
@@ -185,6 +221,7 @@ struct mLACP
 void mlacp_init(struct CSM* csm, int all);
 void mlacp_finalize(struct CSM* csm);
 void mlacp_fsm_transit(struct CSM* csm);
+void mlacp_fsm_send_heartbeat(struct CSM* csm);
 void mlacp_enqueue_msg(struct CSM*, struct Msg*);
 struct Msg* mlacp_dequeue_msg(struct CSM*);
 char* mlacp_state(struct CSM* csm);
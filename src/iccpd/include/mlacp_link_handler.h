@@ -51,6 +51,7 @@ void peerlink_port_isolate_cleanup(struct CSM* csm);
 void update_peerlink_isolate_from_all_csm_lif(struct CSM* csm);
 
 ssize_t iccp_send_to_mclagsyncd(uint8_t msg_type, char *send_buff, uint16_t send_len);
+int iccp_syncd_tx_queue_drain();
 
 void del_mac_from_chip(struct MACMsg* mac_msg);
 void add_mac_to_chip(struct MACMsg* mac_msg, uint8_t mac_type);
@@ -58,7 +59,8 @@ uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t
 
 extern int mclagd_ctl_sock_create();
 extern int mclagd_ctl_sock_accept(int fd);
-extern int mclagd_ctl_interactive_process(int client_fd);
+extern int mclagd_ctl_client_add(int client_fd);
+extern int mclagd_ctl_client_handler(int fd, uint32_t events);
 extern int parseMacString(const char *str_mac, uint8_t *bin_mac);
 
 char *show_ip_str(uint32_t ipv4_addr);
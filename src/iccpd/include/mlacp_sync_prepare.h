@@ -43,6 +43,7 @@ int mlacp_sync_with_kernel_callback();
 * ***************************************/
 int mlacp_prepare_for_sync_request_tlv(struct CSM* csm, char* buf, size_t max_buf_size);
 int mlacp_prepare_for_sync_data_tlv(struct CSM* csm, char* buf, size_t max_buf_size, int end);
+int mlacp_prepare_for_sync_digest_tlv(struct CSM* csm, char* buf, size_t max_buf_size, size_t msg_len, int delta);
 int mlacp_prepare_for_sys_config(struct CSM* csm, char* buf, size_t max_buf_size);
 int mlacp_prepare_for_mac_info_to_peer(struct CSM* csm, char* buf, size_t max_buf_size, struct MACMsg* mac_msg, int count);
 int mlacp_prepare_for_arp_info(struct CSM* csm, char* buf, size_t max_buf_size, struct ARPMsg* arp_msg, int count, int dir);
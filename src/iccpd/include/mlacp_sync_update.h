@@ -44,6 +44,23 @@ int mlacp_fsm_update_warmboot(struct CSM* csm, struct mLACPWarmbootTLV* tlv);
 
 void mlacp_enqueue_arp(struct CSM* csm, struct Msg* msg);
 void mlacp_enqueue_ndisc(struct CSM *csm, struct Msg *msg);
+void mlacp_dequeue_arp(struct CSM* csm, struct Msg* msg);
+void mlacp_dequeue_ndisc(struct CSM *csm, struct Msg *msg);
+struct Msg* mlacp_arp_find(struct CSM* csm, uint32_t ipv4_addr);
+struct Msg* mlacp_ndisc_find(struct CSM *csm, const uint32_t *ipv6_addr);
+void mlacp_arp_set_ifname(struct CSM* csm, struct Msg* msg, const char *ifname);
+void mlacp_ndisc_set_ifname(struct CSM *csm, struct Msg *msg, const char *ifname);
+unsigned int mlacp_neigh_if_hash(const char *ifname);
+void mlacp_neigh_index_reinit(struct CSM* csm);
+void mlacp_mac_index_add(struct CSM* csm, struct MACMsg* mac_msg);
+void mlacp_mac_set_origin(struct CSM* csm, struct MACMsg* mac_msg, uint16_t origin_ifname_id);
+void mlacp_mac_index_reinit(struct CSM* csm);
+uint32_t mlacp_arp_digest(const struct ARPMsg *arp_msg);
+uint32_t mlacp_ndisc_digest(const struct NDISCMsg *ndisc_msg);
+void mlacp_neigh_sync_mark(struct mLACPSyncDigest *digest, struct Msg *msg, uint32_t entry_digest);
+void mlacp_neigh_sync_unmark(struct mLACPSyncDigest *digest, struct Msg *msg);
+void mlacp_neigh_sync_reset(struct CSM* csm);
+void mlacp_neigh_add_failed(int family, const uint8_t *addr, const uint8_t *mac_addr, const char *ifname);
 int mlacp_fsm_update_Agg_conf(struct CSM* csm, mLACPAggConfigTLV* portconf);
 int mlacp_fsm_update_port_channel_info(struct CSM* csm, struct mLACPPortChannelInfoTLV* tlv);
 int mlacp_fsm_update_peerlink_info(struct CSM* csm, struct mLACPPeerLinkInfoTLV* tlv);
@@ -305,6 +305,26 @@ struct mLACPSyncDataTLV
 
 typedef struct mLACPSyncDataTLV mLACPSyncDataTLV;
 
+/*
+ * Sync Digest TLV, appended after the Sync Request TLV and after the
+ * Sync Data TLV starting the reply. Peers not knowing it only parse the
+ * first TLV of the message and fall back to a full sync
+ */
+#define MLACP_SYNC_DIGEST_F_DELTA   0x01    /* reply: only changed entries follow */
+
+struct mLACPSyncDigestTLV
+{
+    ICCParameter icc_parameter;
+    uint8_t flags;
+    uint32_t sync_gen;
+    uint32_t arp_count;
+    uint32_t arp_sum;
+    uint32_t ndisc_count;
+    uint32_t ndisc_sum;
+} __attribute__ ((packed));
+
+typedef struct mLACPSyncDigestTLV mLACPSyncDigestTLV;
+
 /* VLAN Information TLV*/
 struct mLACPVLANData
 {
@@ -512,21 +532,24 @@ enum MAC_TYPE
 struct MACMsg
 {
     RB_ENTRY(MACMsg) mac_entry_rb;
+    TAILQ_ENTRY(MACMsg) tail;     // entry into mac_msg_list
+    LIST_ENTRY(MACMsg) mac_if_next;   // entry into mac_if_hash, by origin_ifname_id
+
     uint16_t    vid;
     uint8_t     mac_addr[ETHER_ADDR_LEN];
     uint8_t     op_type;    /*add or del*/
     uint8_t     fdb_type;   /*static or dynamic*/
 
-    /*Current if name that set in chip*/
-    char     ifname[MAX_L_PORT_NAME];
-    /*if we set the mac to peer-link, origin_ifname store the
-       original if name that learned from chip*/
-    char     origin_ifname[MAX_L_PORT_NAME];
+    /*Current if that set in chip, interned by ifname_intern()*/
+    uint16_t    ifname_id;
+    /*if we set the mac to peer-link, origin_ifname_id store the
+       original if that learned from chip*/
+    uint16_t    origin_ifname_id;
     uint8_t age_flag;/*local or peer is age?*/
     uint8_t pending_local_del;
     uint8_t add_to_syncd;
-
-    TAILQ_ENTRY(MACMsg) tail;     // entry into mac_msg_list
+    /* Time queued to mac_msg_list by a local learn event, 0 if none */
+    uint64_t    trace_usec;
 };
 
 RB_HEAD(mac_rb_tree, MACMsg);
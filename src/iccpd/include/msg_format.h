@@ -105,6 +105,7 @@
 #define TLV_T_MLACP_WARMBOOT_FLAG       0x1039
 #define TLV_T_MLACP_NDISC_INFO          0x103A
 #define TLV_T_MLACP_IF_UP_ACK           0x103B
+#define TLV_T_MLACP_SYNC_DIGEST         0x103C
 #define TLV_T_MLACP_LIST_END            0x104a //list end
 
 /* Debug */
@@ -187,6 +188,9 @@ static char* get_tlv_type_string(int type)
 
         case TLV_T_MLACP_IF_UP_ACK:
             return "TLV_T_MLACP_IF_UP_ACK";
+
+        case TLV_T_MLACP_SYNC_DIGEST:
+            return "TLV_T_MLACP_SYNC_DIGEST";
     }
 
     return "UNKNOWN";
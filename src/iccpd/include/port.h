@@ -129,6 +129,7 @@ struct LocalInterface
     int ifindex;
     int type;
     char name[MAX_L_PORT_NAME];
+    uint16_t ifname_id; /* Interned name, see ifname_intern() */
 
     uint8_t mac_addr[ETHER_ADDR_LEN];
     uint8_t mac_addr_ori[ETHER_ADDR_LEN];
@@ -160,6 +161,8 @@ struct LocalInterface
     bool is_l3_proto_enabled;  /* Enable L3 Protocol support */
     uint32_t vlan_count;
     uint32_t master_ifindex;   /* VRF ifindex*/
+    uint32_t link_digest;      /* Attributes of the last RTM_NEWLINK handled */
+    uint32_t link_resync_gen;  /* Last kernel re-sync that found the link */
 
     struct vlan_rb_tree vlan_tree;
 
@@ -167,12 +170,26 @@ struct LocalInterface
     LIST_ENTRY(LocalInterface) system_purge_next;
     LIST_ENTRY(LocalInterface) mlacp_next;
     LIST_ENTRY(LocalInterface) mlacp_purge_next;
+    LIST_ENTRY(LocalInterface) name_hash_next;
+    LIST_ENTRY(LocalInterface) ifindex_hash_next;
+    LIST_ENTRY(LocalInterface) po_id_hash_next;
 };
 
+/* Interface names referenced by MAC entries are interned to small ids,
+ * id 0 is the empty name. IFNAME_ID_INVALID is returned when no id is
+ * left and never names an interface */
+#define IFNAME_ID_CHUNK_SIZE    256
+#define IFNAME_ID_HASH_SIZE     1024
+#define IFNAME_ID_INVALID       UINT16_MAX
+
+uint16_t ifname_intern(const char* ifname);
+const char* ifname_from_id(uint16_t id);
+
 struct LocalInterface* local_if_create(int ifindex, char* ifname, int type, uint8_t state);
 struct LocalInterface* local_if_find_by_name(const char* ifname);
 struct LocalInterface* local_if_find_by_ifindex(int ifindex);
 struct LocalInterface* local_if_find_by_po_id(int po_id);
+void local_if_update_ifindex(struct LocalInterface* local_if, int ifindex);
 
 void local_if_destroy(char *ifname);
 void local_if_change_flag_clear(void);
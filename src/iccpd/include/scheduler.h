@@ -25,6 +25,7 @@
 #define SCHEDULER_H_
 
 #include <errno.h>
+#include <stdint.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -38,11 +39,40 @@ struct CSM;
 struct System;
 
 #define CONNECT_INTERVAL_SEC        1
-#define CONNECT_TIMEOUT_MSEC        100
+#define CONNECT_TIMEOUT_SEC         3
+#define CONNECT_BACKOFF_MAX_SEC     16
 #define HEARTBEAT_TIMEOUT_SEC       15
 #define TRANSIT_INTERVAL_SEC        1
 #define EPOLL_TIMEOUT_MSEC          100
 
+/* Timer wheel driven by a timerfd, TIMER_WHEEL_TICK_MSEC resolution */
+#define TIMER_WHEEL_TICK_MSEC       100
+#define TIMER_WHEEL_SLOTS           256
+/* FSM transit interval while a session is being set up or has pending TX */
+#define TRANSIT_FAST_INTERVAL_MSEC  100
+#define SYNCD_CONNECT_INTERVAL_MSEC 100
+
+struct SchedTimer
+{
+    uint64_t expire_tick;
+    int armed;
+    void (*callback)(struct SchedTimer*);
+    void* arg;
+    LIST_ENTRY(SchedTimer) next;
+};
+
+void scheduler_timer_init(struct SchedTimer* timer, void (*callback)(struct SchedTimer*), void* arg);
+void scheduler_timer_start(struct SchedTimer* timer, uint32_t msec);
+void scheduler_timer_stop(struct SchedTimer* timer);
+int scheduler_timer_wheel_init(struct System* sys);
+int scheduler_get_timer_fd(struct System* sys);
+int scheduler_timer_handler(struct System* sys);
+void scheduler_csm_fsm_timer_expire(struct SchedTimer* timer);
+void scheduler_csm_set_dirty(struct CSM* csm);
+void scheduler_csm_set_dirty_all();
+int scheduler_csm_dirty_pending();
+void scheduler_heartbeat_service();
+
 int scheduler_prepare_session(struct CSM*);
 int scheduler_check_csm_config(struct CSM*);
 int scheduler_unregister_sock_read_event_callback(struct CSM*);
@@ -53,6 +83,8 @@ void scheduler_loop();
 void scheduler_start();
 void scheduler_server_sock_init();
 int scheduler_csm_read_callback(struct CSM* csm);
+int scheduler_csm_connect_callback(struct CSM* csm);
+void scheduler_csm_connect_abort(struct CSM* csm);
 int iccp_get_server_sock_fd();
 int scheduler_server_accept();
 int iccp_receive_signal_handler(struct System* sys);
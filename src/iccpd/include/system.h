@@ -74,6 +74,10 @@ extern char mac_print_str[ETHER_ADDR_STR_LEN];
     (elm)->mac_entry_rb.rbt_parent = NULL;   \
     (elm)->mac_entry_rb.rbt_left = NULL;     \
     (elm)->mac_entry_rb.rbt_right = NULL;    \
+    if ((elm)->mac_if_next.le_prev != NULL) {\
+        LIST_REMOVE(elm, mac_if_next);       \
+        (elm)->mac_if_next.le_prev = NULL;   \
+    }                                        \
 } while (/*CONSTCOND*/0)
 
 /* Debug counters */
@@ -288,10 +292,55 @@ typedef struct system_dbg_counter_info
     uint32_t mac_entry_alloc_counter;
     uint32_t mac_entry_free_counter;
 
+    uint32_t syncd_tx_queue_depth; //bytes queued to mclagsyncd waiting for EPOLLOUT
+    uint32_t syncd_tx_queue_max_depth; //high watermark of syncd_tx_queue_depth
+    uint32_t syncd_tx_drop_counter; //msgs to mclagsyncd dropped as TX queue is full
+    uint32_t syncd_tx_coalesce_counter; //FDB entries merged into a queued SET_FDB msg
+
+    uint32_t netlink_overrun_counter; //netlink event socket overruns (ENOBUFS)
+    uint32_t netlink_resync_counter; //kernel re-syncs after netlink errors
+    uint32_t netlink_resync_link_counter; //links handled again by re-syncs
+    uint32_t netlink_resync_skip_counter; //unchanged links skipped by re-syncs
+    uint32_t netlink_resync_del_counter; //links found deleted by re-syncs
+    uint32_t netlink_resync_team_counter; //PortChannel member lists queried by re-syncs
+    uint32_t netlink_resync_last_usec; //duration of the last re-sync
+    uint32_t netlink_resync_max_usec; //longest re-sync
+
+    uint32_t arp_rx_packet_counter; //ARP replies received on the packet socket
+    uint32_t ndisc_rx_packet_counter; //neighbor advertisements received
+    uint32_t packet_rx_budget_counter; //wakeups leaving ARP/ND packets for the next one
+    uint32_t team_query_counter; //PortChannel member queries sent
+    uint32_t team_query_max_inflight; //high watermark of member queries waiting for reply
+
     uint64_t syncd_tx_counters[SYNCD_TX_DBG_CNTR_MSG_MAX][SYNCD_DBG_CNTR_STS_MAX];
     uint64_t syncd_rx_counters[SYNCD_RX_DBG_CNTR_MSG_MAX][SYNCD_DBG_CNTR_STS_MAX];
 }system_dbg_counter_info_t;
 
+/* Phases of a MAC/ARP/ND update, each measured on the node it runs on */
+typedef enum
+{
+    ICCP_LATENCY_LEARN_QUEUE = 0, //mclagsyncd/netlink event read -> queued for the peer
+    ICCP_LATENCY_QUEUE_TX, //queued for the peer -> sent to the peer
+    ICCP_LATENCY_PEER_RX_APPLY, //msg read from the peer -> applied
+    ICCP_LATENCY_APPLY_PROGRAM, //SET_FDB issued -> written to mclagsyncd
+    ICCP_LATENCY_PHASE_MAX
+} ICCP_LATENCY_PHASE_e;
+
+/* Bucket 0 counts samples below 1 usec, bucket i (i > 0) samples in
+ * [2^(i-1), 2^i) usec, the last bucket everything above */
+#define ICCP_LATENCY_BUCKETS    24
+
+typedef struct iccp_latency_hist
+{
+    uint64_t count;
+    uint64_t sum_usec;
+    uint32_t max_usec;
+    uint32_t buckets[ICCP_LATENCY_BUCKETS];
+} iccp_latency_hist_t;
+
+/* Number of buckets of LocalInterface hash indexes, power of 2 */
+#define LIF_HASH_SIZE           1024
+
 struct System
 {
     int server_fd;/* Peer-Link Socket*/
@@ -300,6 +349,7 @@ struct System
     int arp_receive_fd;
     int ndisc_receive_fd;
     int epoll_fd;
+    int timer_fd;
 
     struct nl_sock * genric_sock;
     int genric_sock_seq;
@@ -308,6 +358,7 @@ struct System
     int route_sock_seq;
     struct nl_sock * genric_event_sock;
     struct nl_sock * route_event_sock;
+    struct nl_sock * neigh_batch_sock;
 
     int sig_pipe_r;
     int sig_pipe_w;
@@ -321,11 +372,17 @@ struct System
     LIST_HEAD(unq_ip_all_if_list, Unq_ip_If_info) unq_ip_if_list;
     LIST_HEAD(pending_vlan_mbr_if_list, PendingVlanMbrIf) pending_vlan_mbr_if_list;
 
+    /* lif_list lookup indexes by name, ifindex and PortChannel po_id */
+    LIST_HEAD(lif_name_hash_list, LocalInterface) lif_name_hash[LIF_HASH_SIZE];
+    LIST_HEAD(lif_ifindex_hash_list, LocalInterface) lif_ifindex_hash[LIF_HASH_SIZE];
+    LIST_HEAD(lif_po_id_hash_list, LocalInterface) lif_po_id_hash[LIF_HASH_SIZE];
+
     /* Settings */
     char* log_file_path;
     char* cmd_file_path;
     char* config_file_path;
     char* mclagdctl_file_path;
+    char* snapshot_file_path;
     int pid_file_fd;
     int telnet_port;
     fd_set readfd; /*record socket need to listen*/
@@ -333,9 +390,15 @@ struct System
     time_t csm_trans_time;
     int need_sync_team_again;
     int need_sync_netlink_again;
+    uint32_t link_resync_gen;
 
     /* ICCDd/MclagSyncd debug counters */
     system_dbg_counter_info_t dbg_counters;
+
+    /* Per phase latency histograms, and the read time of the
+     * mclagsyncd/netlink event being handled (0 if none) */
+    iccp_latency_hist_t latency[ICCP_LATENCY_PHASE_MAX];
+    uint64_t latency_event_usec;
 };
 
 struct CSM* system_create_csm();
@@ -351,5 +414,8 @@ SYNCD_RX_DBG_CNTR_MSG_e system_syncdrx_to_dbg_msg_type(uint32_t msg_type);
 
 char *mac_addr_to_str(uint8_t mac_addr[ETHER_ADDR_LEN]);
 void system_update_netlink_counters(uint16_t netlink_msg_type, struct nlmsghdr *nlh);
+uint64_t system_get_usec();
+void system_latency_record(ICCP_LATENCY_PHASE_e phase, uint64_t start_usec);
+uint64_t system_latency_queue_stamp();
 
 #endif /* SYSTEM_H_ */
@@ -40,8 +40,7 @@
         while (!TAILQ_EMPTY(&(list))) { \
             msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), msg, tail); \
-            free(msg->buf); \
-            free(msg); \
+            iccp_csm_free_msg(msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -97,6 +96,19 @@ void app_csm_transit(struct CSM* csm)
     return;
 }
 
+/* Messages on the application list are kept until the session is reset,
+ * don't let them hold the receive buffer */
+static void app_csm_keep_msg(struct CSM* csm, struct Msg* msg)
+{
+    if (iccp_csm_detach_msg(msg) != 0)
+    {
+        iccp_csm_free_msg(msg);
+        return;
+    }
+
+    TAILQ_INSERT_TAIL(&(csm->app_csm.app_msg_list), msg, tail);
+}
+
 /* Add received message into application message list */
 void app_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
 {
@@ -108,8 +120,7 @@ void app_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
 
     if (csm == NULL )
     {
-        if (msg != NULL )
-            free(msg);
+        iccp_csm_free_msg(msg);
         return;
     }
     if (msg == NULL )
@@ -124,7 +135,7 @@ void app_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
         if (param->type > TLV_T_MLACP_CONNECT && param->type < TLV_T_MLACP_LIST_END)
             mlacp_enqueue_msg(csm, msg);
         else
-            TAILQ_INSERT_TAIL(&(csm->app_csm.app_msg_list), msg, tail);
+            app_csm_keep_msg(csm, msg);
     }
     else if (icc_hdr->ldp_hdr.msg_type == MSG_T_NOTIFICATION)
     {
@@ -142,12 +153,13 @@ void app_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
         if (tlv > TLV_T_MLACP_CONNECT && tlv <= TLV_T_MLACP_MAC_INFO)
             mlacp_enqueue_msg(csm, msg);
         else
-            TAILQ_INSERT_TAIL(&(csm->app_csm.app_msg_list), msg, tail);
+            app_csm_keep_msg(csm, msg);
     }
     else
     {
         /* This packet is not for me, ignore it. */
         ICCPD_LOG_DEBUG(__FUNCTION__, "Ignore the packet with msg_type = %d", icc_hdr->ldp_hdr.msg_type);
+        iccp_csm_free_msg(msg);
     }
 }
 
@@ -299,7 +311,7 @@ int mlacp_bind_port_channel_to_csm(struct CSM* csm, const char *ifname)
     if (lif_po)
     {
         mlacp_bind_local_if(csm, lif_po);
-        iccp_get_port_member_list(lif_po);
+        iccp_get_port_member_list_async(lif_po);
     }
     else
     {
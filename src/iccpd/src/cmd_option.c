@@ -132,6 +132,7 @@ void cmd_option_parser_init(struct CmdOptionParser* parser)
     LIST_INIT(&parser->option_list);
     cmd_option_register(parser, "-l <LOG_FILE_PATH>", "Set log file path.\n(Default: /var/log/iccpd.log)");
     cmd_option_register(parser, "-p <TCP_PORT>", "Set the port used for telnet listening port.\n(Default: 2015)");
+    cmd_option_register(parser, "-w <SNAPSHOT_FILE_PATH>", "Set warm restart snapshot file path.\n(Default: /var/warmboot/iccpd/iccpd.snapshot)");
     cmd_option_register(parser, "-c", "Dump log message to console. (Default: No)");
     cmd_option_register(parser, "-h", "Show the usage.");
 }
@@ -248,6 +249,9 @@ int cmd_option_parser_parse(struct CmdOptionParser* parser, int argc, char* argv
         if (strncmp(opt_name, "-l", 2) == 0)
             parser->log_file_path = val;
 
+        if (strncmp(opt_name, "-w", 2) == 0)
+            parser->snapshot_file_path = val;
+
         if (strncmp(opt_name, "-p", 2) == 0)
         {
             num = atoi(val);
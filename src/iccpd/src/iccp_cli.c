@@ -29,6 +29,7 @@
 #include "../include/iccp_csm.h"
 #include "../include/mlacp_link_handler.h"
 #include "../include/iccp_netlink.h"
+#include "../include/iccp_snapshot.h"
 /*
  * 'id <1-65535>' command
  */
@@ -44,6 +45,9 @@ int set_mc_lag_id( struct CSM *csm, uint16_t id)
     csm->mlag_id = id;
     csm->iccp_info.icc_rg_id = id;
     csm->app_csm.mlacp.id = id;
+
+    /*ARP/ND tables saved on warm exit*/
+    iccp_snapshot_restore(csm);
     return 0;
 }
 
@@ -68,6 +72,7 @@ int set_peer_link(int mid, const char* ifname)
     struct CSM* csm = NULL;
     struct LocalInterface *lif = NULL;
     size_t len = 0;
+    uint16_t ifname_id;
 
     len = strlen(ifname);
 
@@ -89,6 +94,10 @@ int set_peer_link(int mid, const char* ifname)
         return MCLAG_ERROR;
     }
 
+    ifname_id = ifname_intern(ifname);
+    if (ifname_id == IFNAME_ID_INVALID)
+        return MCLAG_ERROR;
+
     if (strlen(csm->peer_itf_name) > 0)
     {
         if (strcmp(csm->peer_itf_name, ifname) == 0)
@@ -119,6 +128,7 @@ int set_peer_link(int mid, const char* ifname)
 
     memset(csm->peer_itf_name, 0, MAX_L_PORT_NAME);
     memcpy(csm->peer_itf_name, ifname, len);
+    csm->peer_itf_id = ifname_id;
 
     /* update peer-link link handler*/
     lif = local_if_find_by_name(csm->peer_itf_name);
@@ -163,6 +173,7 @@ int unset_peer_link(int mid)
 
     /* clean peer-link*/
     memset(csm->peer_itf_name, 0, MAX_L_PORT_NAME);
+    csm->peer_itf_id = 0;
     if (csm->peer_link_if)
     {
         csm->peer_link_if->is_peer_link = 0;
@@ -199,7 +199,7 @@ int iccp_arp_dump(char * *buf, int *num, int mclag_id)
 
             if ((arp_num + 1) * sizeof(struct mclagd_arp_msg) > (arp_buf_size - MCLAGD_REPLY_INFO_HDR))
             {
-                arp_buf_size += MCLAGDCTL_CMD_SIZE;
+                arp_buf_size *= 2;
                 arp_buf = (char*)realloc(arp_buf, arp_buf_size);
                 if (!arp_buf)
                     return EXEC_TYPE_FAILED;
@@ -264,7 +264,7 @@ int iccp_ndisc_dump(char * *buf, int *num, int mclag_id)
 
             if ((ndisc_num + 1) * sizeof(struct mclagd_ndisc_msg) > (ndisc_buf_size - MCLAGD_REPLY_INFO_HDR))
             {
-                ndisc_buf_size += MCLAGDCTL_CMD_SIZE;
+                ndisc_buf_size *= 2;
                 ndisc_buf = (char *)realloc(ndisc_buf, ndisc_buf_size);
                 if (!ndisc_buf)
                     return EXEC_TYPE_FAILED;
@@ -320,8 +320,8 @@ int iccp_mac_dump(char * *buf, int *num, int mclag_id)
             mclagd_mac.fdb_type = iccpd_mac->fdb_type;
             memcpy(mclagd_mac.mac_addr, iccpd_mac->mac_addr, ETHER_ADDR_LEN);
             mclagd_mac.vid = iccpd_mac->vid;
-            memcpy(mclagd_mac.ifname, iccpd_mac->ifname, strlen(iccpd_mac->ifname));
-            memcpy(mclagd_mac.origin_ifname, iccpd_mac->origin_ifname, strlen(iccpd_mac->origin_ifname));
+            snprintf(mclagd_mac.ifname, sizeof(mclagd_mac.ifname), "%s", ifname_from_id(iccpd_mac->ifname_id));
+            snprintf(mclagd_mac.origin_ifname, sizeof(mclagd_mac.origin_ifname), "%s", ifname_from_id(iccpd_mac->origin_ifname_id));
             mclagd_mac.age_flag = iccpd_mac->age_flag;
 
             memcpy(mac_buf + MCLAGD_REPLY_INFO_HDR + mac_num * sizeof(struct mclagd_mac_msg),
@@ -331,7 +331,7 @@ int iccp_mac_dump(char * *buf, int *num, int mclag_id)
 
             if ((mac_num + 1) * sizeof(struct mclagd_mac_msg) > (mac_buf_size - MCLAGD_REPLY_INFO_HDR))
             {
-                mac_buf_size += MCLAGDCTL_CMD_SIZE;
+                mac_buf_size *= 2;
                 mac_buf = (char*)realloc(mac_buf, mac_buf_size);
                 if (!mac_buf)
                     return EXEC_TYPE_FAILED;
@@ -765,6 +765,33 @@ int iccp_cmd_dbg_counter_dump(char **buf, int *data_len, int mclag_id)
     return EXEC_TYPE_SUCCESS;
 }
 
+int iccp_cmd_dbg_latency_dump(char **buf, int *data_len)
+{
+    struct System *sys = NULL;
+    char *latency_buf = NULL;
+    mclagd_dbg_latency_info_t *latency_ptr;
+    int buf_size = 0;
+
+    if (!(sys = system_get_instance()))
+    {
+        ICCPD_LOG_INFO(__FUNCTION__, "cannot find sys!\n");
+        return EXEC_TYPE_NO_EXIST_SYS;
+    }
+
+    buf_size = MCLAGD_REPLY_INFO_HDR + sizeof(mclagd_dbg_latency_info_t);
+    latency_buf = (char*)malloc(buf_size);
+    if (!latency_buf)
+        return EXEC_TYPE_FAILED;
+
+    memset(latency_buf, 0, buf_size);
+    latency_ptr = (mclagd_dbg_latency_info_t *)(latency_buf + MCLAGD_REPLY_INFO_HDR);
+    memcpy(latency_ptr->hist, sys->latency, sizeof(sys->latency));
+
+    *buf = latency_buf;
+    *data_len = buf_size - MCLAGD_REPLY_INFO_HDR;
+    return EXEC_TYPE_SUCCESS;
+}
+
 int iccp_unique_ip_if_dump(char **buf, int *num, int mclag_id)
 {
     struct System *sys = NULL;
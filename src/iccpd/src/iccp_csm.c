@@ -41,8 +41,7 @@
         while (!TAILQ_EMPTY(&(list))) { \
             msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), msg, tail); \
-            free(msg->buf); \
-            free(msg); \
+            iccp_csm_free_msg(msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -55,6 +54,17 @@ char g_csm_buf[CSM_BUFFER_SIZE] = { 0 };
 
 uint32_t ICCP_MSG_ID = 0x1;
 
+/* Free small messages (ARP/ND sync entries) are kept for reuse */
+#define MSG_POOL_BUF_SIZE   64
+#define MSG_POOL_MAX        4096
+
+static TAILQ_HEAD(msg_pool_list, Msg) msg_pool = TAILQ_HEAD_INITIALIZER(msg_pool);
+static int msg_pool_count = 0;
+
+/* Free message nodes of received frames, they have no buffer of their own */
+static TAILQ_HEAD(rx_msg_pool_list, Msg) rx_msg_pool = TAILQ_HEAD_INITIALIZER(rx_msg_pool);
+static int rx_msg_pool_count = 0;
+
 /* Enter Connection State Machine NONEXISTENT handle function */
 static void iccp_csm_enter_state_nonexistent(struct CSM* csm)
 {
@@ -124,12 +134,15 @@ void iccp_csm_init(struct CSM* csm)
     csm->iccp_info.icc_rg_id = 0x0;
     csm->keepalive_time      = CONNECT_INTERVAL_SEC; 
     csm->session_timeout     = HEARTBEAT_TIMEOUT_SEC;
+    csm->fsm_dirty = 1;
+    scheduler_timer_init(&csm->fsm_timer, scheduler_csm_fsm_timer_expire, csm);
 }
 
 /* Connection State Machine instance status reset */
 void iccp_csm_status_reset(struct CSM* csm, int all)
 {
     ICCP_CSM_QUEUE_REINIT(csm->msg_list);
+    iccp_csm_rx_release(csm);
 
     if (all)
     {
@@ -138,6 +151,9 @@ void iccp_csm_status_reset(struct CSM* csm, int all)
     }
 
     csm->sock_fd = -1;
+    csm->conn_fd = -1;
+    csm->conn_backoff_sec = CONNECT_INTERVAL_SEC;
+    csm->rx_resume_count = 0;
     pthread_mutex_init(&csm->conn_mutex, NULL);
     csm->connTimePrev = 0;
     csm->heartbeat_send_time = 0;
@@ -219,6 +235,7 @@ void iccp_csm_finalize(struct CSM* csm)
     }
             
     /* Release iccp_csm */
+    scheduler_timer_stop(&csm->fsm_timer);
     pthread_mutex_destroy(&(csm->conn_mutex));
     iccp_csm_msg_list_finalize(csm);
     LIST_REMOVE(csm, next);
@@ -237,7 +254,7 @@ void iccp_csm_msg_list_finalize(struct CSM* csm)
     {
         msg = TAILQ_FIRST(&(csm->msg_list));
         TAILQ_REMOVE(&(csm->msg_list), msg, tail);
-        free(msg);
+        iccp_csm_free_msg(msg);
     }
 }
 
@@ -308,6 +325,8 @@ void iccp_csm_transit(struct CSM* csm)
     switch (csm->current_state)
     {
         case ICCP_NONEXISTENT:
+            /* Dropped, so it does not hold the receive buffer */
+            iccp_csm_free_msg(msg);
             scheduler_prepare_session(csm);
             if (csm->sock_fd > 0 && scheduler_check_csm_config(csm) > 0)
                 csm->current_state = ICCP_INITIALIZED;
@@ -660,8 +679,7 @@ void iccp_csm_correspond_from_msg(struct CSM* csm, struct Msg* msg)
         ++csm->u_msg_in_count;
     }
 
-    free(msg->buf);
-    free(msg);
+    iccp_csm_free_msg(msg);
 }
 
 /* Receive capability message correspond function */
@@ -727,8 +745,7 @@ void iccp_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
 
     if (csm == NULL)
     {
-        if (msg != NULL)
-            free(msg);
+        iccp_csm_free_msg(msg);
         return;
     }
 
@@ -765,6 +782,8 @@ void iccp_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
     {
         TAILQ_INSERT_TAIL(&(csm->msg_list), msg, tail);
     }
+
+    csm->fsm_dirty = 1;
 }
 
 /* Get received message from message list */
@@ -793,16 +812,29 @@ int iccp_csm_init_msg(struct Msg** msg, char* data, int len)
     if (data == NULL || len <= 0)
         return MCLAG_ERROR;
 
-    iccp_msg = (struct Msg*)malloc(sizeof(struct Msg));
-    if (iccp_msg == NULL)
-        goto err_ret;
-
-    iccp_msg->buf = (char*)malloc(len);
-    if (iccp_msg->buf == NULL)
-        goto err_ret;
+    if (len <= MSG_POOL_BUF_SIZE && !TAILQ_EMPTY(&msg_pool))
+    {
+        iccp_msg = TAILQ_FIRST(&msg_pool);
+        TAILQ_REMOVE(&msg_pool, iccp_msg, tail);
+        msg_pool_count--;
+    }
+    else
+    {
+        iccp_msg = (struct Msg*)malloc(sizeof(struct Msg));
+        if (iccp_msg == NULL)
+            goto err_ret;
+
+        /* Small buffers are allocated at pool size so they can be reused */
+        iccp_msg->buf = (char*)malloc(len <= MSG_POOL_BUF_SIZE ? MSG_POOL_BUF_SIZE : len);
+        if (iccp_msg->buf == NULL)
+            goto err_ret;
+    }
 
     memcpy(iccp_msg->buf, data, len);
     iccp_msg->len = len;
+    iccp_msg->rx_buf = NULL;
+    iccp_msg->sync_digest = 0;
+    iccp_msg->trace_usec = 0;
     *msg = iccp_msg;
 
     return 0;
@@ -818,6 +850,172 @@ int iccp_csm_init_msg(struct Msg** msg, char* data, int len)
     return MCLAG_ERROR;
 }
 
+/* Received frame initialization, the message refers to the frame in the
+ * session receive buffer instead of copying it */
+int iccp_csm_init_rx_msg(struct Msg** msg, struct RxBuf* rx_buf, size_t offset, int len)
+{
+    struct Msg* iccp_msg = NULL;
+
+    if (msg == NULL)
+        return -2;
+
+    if (rx_buf == NULL || len <= 0)
+        return MCLAG_ERROR;
+
+    if (!TAILQ_EMPTY(&rx_msg_pool))
+    {
+        iccp_msg = TAILQ_FIRST(&rx_msg_pool);
+        TAILQ_REMOVE(&rx_msg_pool, iccp_msg, tail);
+        rx_msg_pool_count--;
+    }
+    else
+    {
+        iccp_msg = (struct Msg*)malloc(sizeof(struct Msg));
+        if (iccp_msg == NULL)
+            return MCLAG_ERROR;
+    }
+
+    ++rx_buf->refcnt;
+    iccp_msg->buf = &rx_buf->data[offset];
+    iccp_msg->len = len;
+    iccp_msg->rx_buf = rx_buf;
+    iccp_msg->sync_digest = 0;
+    iccp_msg->trace_usec = 0;
+    *msg = iccp_msg;
+
+    return 0;
+}
+
+/* Copy a received frame out of the session receive buffer, for messages
+ * kept longer than their processing */
+int iccp_csm_detach_msg(struct Msg* msg)
+{
+    char* buf = NULL;
+
+    if (msg == NULL || msg->rx_buf == NULL)
+        return 0;
+
+    buf = (char*)malloc(msg->len);
+    if (buf == NULL)
+        return MCLAG_ERROR;
+
+    memcpy(buf, msg->buf, msg->len);
+    iccp_csm_rx_buf_put(msg->rx_buf);
+    msg->rx_buf = NULL;
+    msg->buf = buf;
+
+    return 0;
+}
+
+/* Message release, small messages go back to the pool */
+void iccp_csm_free_msg(struct Msg* msg)
+{
+    if (msg == NULL)
+        return;
+
+    if (msg->rx_buf)
+    {
+        iccp_csm_rx_buf_put(msg->rx_buf);
+        msg->rx_buf = NULL;
+        if (rx_msg_pool_count < MSG_POOL_MAX)
+        {
+            TAILQ_INSERT_HEAD(&rx_msg_pool, msg, tail);
+            rx_msg_pool_count++;
+        }
+        else
+            free(msg);
+        return;
+    }
+
+    if (msg->len <= MSG_POOL_BUF_SIZE && msg_pool_count < MSG_POOL_MAX)
+    {
+        TAILQ_INSERT_HEAD(&msg_pool, msg, tail);
+        msg_pool_count++;
+        return;
+    }
+
+    free(msg->buf);
+    free(msg);
+
+    return;
+}
+
+/* Receive buffer with a reference for the session */
+struct RxBuf* iccp_csm_rx_buf_alloc()
+{
+    struct RxBuf* rx_buf = NULL;
+
+    rx_buf = (struct RxBuf*)malloc(sizeof(struct RxBuf));
+    if (rx_buf)
+        rx_buf->refcnt = 1;
+
+    return rx_buf;
+}
+
+void iccp_csm_rx_buf_put(struct RxBuf* rx_buf)
+{
+    if (rx_buf && --rx_buf->refcnt == 0)
+        free(rx_buf);
+}
+
+/* Drop the session reference to its receive buffer on disconnect, queued
+ * frames keep it until they are freed */
+void iccp_csm_rx_release(struct CSM* csm)
+{
+    iccp_csm_rx_buf_put(csm->rx_buf);
+    csm->rx_buf = NULL;
+    csm->rx_start = 0;
+    csm->rx_len = 0;
+}
+
+/* MAC entries are carved from slabs of MAC_MSG_POOL_CHUNK entries, freed
+ * entries are kept on a free list for reuse */
+union MACMsgSlot
+{
+    struct MACMsg mac_msg;
+    union MACMsgSlot* next_free;
+};
+
+static union MACMsgSlot* mac_msg_free_list = NULL;
+
+static struct MACMsg* iccp_csm_alloc_mac_msg()
+{
+    union MACMsgSlot* slab = NULL;
+    union MACMsgSlot* slot = NULL;
+    int i;
+
+    if (mac_msg_free_list == NULL)
+    {
+        slab = (union MACMsgSlot*)malloc(MAC_MSG_POOL_CHUNK * sizeof(union MACMsgSlot));
+        if (slab == NULL)
+            return NULL;
+
+        for (i = 0; i < MAC_MSG_POOL_CHUNK; i++)
+        {
+            slab[i].next_free = mac_msg_free_list;
+            mac_msg_free_list = &slab[i];
+        }
+    }
+
+    slot = mac_msg_free_list;
+    mac_msg_free_list = slot->next_free;
+
+    return &slot->mac_msg;
+}
+
+void iccp_csm_free_mac_msg(struct MACMsg* mac_msg)
+{
+    union MACMsgSlot* slot = (union MACMsgSlot*)mac_msg;
+
+    if (mac_msg == NULL)
+        return;
+
+    slot->next_free = mac_msg_free_list;
+    mac_msg_free_list = slot;
+
+    return;
+}
+
 /* MAC Message initialization */
 int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len)
 {
@@ -826,10 +1024,10 @@ int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len)
     if (mac_msg == NULL)
         return -2;
 
-    if (data == NULL || len <= 0)
+    if (data == NULL || len <= 0 || len > sizeof(struct MACMsg))
         return MCLAG_ERROR;
 
-    iccp_mac_msg = (struct MACMsg*)malloc(sizeof(struct MACMsg));
+    iccp_mac_msg = iccp_csm_alloc_mac_msg();
     if (iccp_mac_msg == NULL)
        return -3;
 
@@ -59,8 +59,20 @@ static int iccp_valid_handler(struct nl_msg *msg, void *arg)
     return 0;
 }
 
-/*Get kernel interfaces and ports during initialization*/
-int iccp_sys_local_if_list_get_init()
+static int iccp_resync_valid_handler(struct nl_msg *msg, void *arg)
+{
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+
+    if (nlh->nlmsg_type != RTM_NEWLINK)
+        return 0;
+
+    if (nl_msg_parse(msg, &iccp_event_handler_obj_resync_link, arg) < 0)
+        ICCPD_LOG_ERR(__FUNCTION__, "Unknown message type.");
+
+    return 0;
+}
+
+static int iccp_sys_local_if_list_dump(nl_recvmsg_msg_cb_t valid_handler)
 {
     struct System *sys = NULL;
     struct nl_cb *cb;
@@ -94,7 +106,7 @@ int iccp_sys_local_if_list_get_init()
             return -ENOMEM;
         }
 
-        nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, iccp_valid_handler, sys);
+        nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, valid_handler, sys);
 
         ret = nl_recvmsgs(sys->route_sock, cb);
         nl_cb_put(cb);
@@ -113,6 +125,52 @@ int iccp_sys_local_if_list_get_init()
     return ret;
 }
 
+/*Get kernel interfaces and ports during initialization*/
+int iccp_sys_local_if_list_get_init()
+{
+    return iccp_sys_local_if_list_dump(iccp_valid_handler);
+}
+
+/* Get kernel interfaces again after netlink events were lost. Links
+ * unchanged since their last RTM_NEWLINK are skipped, links missing
+ * from a complete dump lost their RTM_DELLINK */
+int iccp_sys_local_if_list_resync()
+{
+    struct System *sys = NULL;
+    struct LocalInterface *lif = NULL;
+    int ret;
+
+    if (!(sys = system_get_instance()))
+        return MCLAG_ERROR;
+
+    ++sys->link_resync_gen;
+    ret = iccp_sys_local_if_list_dump(iccp_resync_valid_handler);
+    if (ret < 0)
+        return ret;
+
+    /* Destroying an interface may change the list, restart the walk */
+    do
+    {
+        LIST_FOREACH(lif, &(sys->lif_list), system_next)
+        {
+            if (lif->ifindex > 0 && lif->type != IF_T_VXLAN
+                && lif->link_resync_gen != sys->link_resync_gen)
+                break;
+        }
+
+        if (lif)
+        {
+            ICCPD_LOG_NOTICE(__FUNCTION__, "Interface %s ifindex %d deleted while events were lost",
+                lif->name, lif->ifindex);
+            lif->link_resync_gen = sys->link_resync_gen;
+            ++sys->dbg_counters.netlink_resync_del_counter;
+            local_if_destroy(lif->name);
+        }
+    } while (lif);
+
+    return ret;
+}
+
 static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int msgtype, int is_del)
 {
     struct System *sys = NULL;
@@ -277,19 +335,16 @@ static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int
     }
 
     /* update lif ARP*/
-    TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+    msg = mlacp_arp_find(csm, arp_msg->ipv4_addr);
+    if (msg)
     {
         arp_info = (struct ARPMsg *)msg->buf;
-        if (arp_info->ipv4_addr != arp_msg->ipv4_addr)
-            continue;
 
         entry_exists = 1;
         if (msgtype == RTM_DELNEIGH)
         {
             /* delete ARP*/
-            TAILQ_REMOVE(&MLACP(csm).arp_list, msg, tail);
-            free(msg->buf);
-            free(msg);
+            mlacp_dequeue_arp(csm, msg);
             msg = NULL;
             ICCPD_LOG_DEBUG(__FUNCTION__, "Delete ARP %s", show_ip_str(arp_msg->ipv4_addr));
         }
@@ -302,12 +357,11 @@ static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int
             {
                 arp_update = 1;
                 arp_info->op_type = arp_msg->op_type;
-                sprintf(arp_info->ifname, "%s", arp_msg->ifname);
+                mlacp_arp_set_ifname(csm, msg, arp_msg->ifname);
                 memcpy(arp_info->mac_addr, arp_msg->mac_addr, ETHER_ADDR_LEN);
                 ICCPD_LOG_DEBUG(__FUNCTION__, "Update ARP for %s", show_ip_str(arp_msg->ipv4_addr));
             }
         }
-        break;
     }
 
     if (msg && !arp_update)
@@ -338,6 +392,7 @@ static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int
             arp_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char *)arp_msg, msg_len) == 0)
             {
+                msg_send->trace_usec = system_latency_queue_stamp();
                 TAILQ_INSERT_TAIL(&(MLACP(csm).arp_msg_list), msg_send, tail);
                 /*ICCPD_LOG_DEBUG(__FUNCTION__, "Enqueue ARP[ADD] message for %s",
                                 show_ip_str(arp_msg->ipv4_addr));*/
@@ -356,6 +411,7 @@ static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int
             arp_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char *)arp_msg, msg_len) == 0)
             {
+                msg_send->trace_usec = system_latency_queue_stamp();
                 TAILQ_INSERT_TAIL(&(MLACP(csm).arp_msg_list), msg_send, tail);
                 /*ICCPD_LOG_DEBUG(__FUNCTION__, "Enqueue ARP[DEL] message for %s",
                                 show_ip_str(arp_msg->ipv4_addr));*/
@@ -551,20 +607,16 @@ static void do_ndisc_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], i
     }
 
     /* update lif ND */
-    TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+    msg = mlacp_ndisc_find(csm, ndisc_msg->ipv6_addr);
+    if (msg)
     {
         ndisc_info = (struct NDISCMsg *)msg->buf;
 
-        if (memcmp(&ndisc_info->ipv6_addr, &ndisc_msg->ipv6_addr, 16) != 0)
-            continue;
-
         entry_exists = 1;
         if (msgtype == RTM_DELNEIGH)
         {
             /* delete ND */
-            TAILQ_REMOVE(&MLACP(csm).ndisc_list, msg, tail);
-            free(msg->buf);
-            free(msg);
+            mlacp_dequeue_ndisc(csm, msg);
             msg = NULL;
             ICCPD_LOG_DEBUG(__FUNCTION__, "Delete neighbor %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr));
         }
@@ -576,12 +628,11 @@ static void do_ndisc_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], i
             {
                 neigh_update = 1;
                 ndisc_info->op_type = ndisc_msg->op_type;
-                sprintf(ndisc_info->ifname, "%s", ndisc_msg->ifname);
+                mlacp_ndisc_set_ifname(csm, msg, ndisc_msg->ifname);
                 memcpy(ndisc_info->mac_addr, ndisc_msg->mac_addr, ETHER_ADDR_LEN);
                 ICCPD_LOG_DEBUG(__FUNCTION__, "Update neighbor for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr));
             }
         }
-        break;
     }
 
     if (msg && !neigh_update)
@@ -611,6 +662,7 @@ static void do_ndisc_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], i
             ndisc_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char *)ndisc_msg, msg_len) == 0)
             {
+                msg_send->trace_usec = system_latency_queue_stamp();
                 TAILQ_INSERT_TAIL(&(MLACP(csm).ndisc_msg_list), msg_send, tail);
                 /* ICCPD_LOG_DEBUG(__FUNCTION__, "Enqueue Ndisc[ADD] for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr)); */
             }
@@ -628,6 +680,7 @@ static void do_ndisc_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], i
             ndisc_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char *)ndisc_msg, msg_len) == 0)
             {
+                msg_send->trace_usec = system_latency_queue_stamp();
                 TAILQ_INSERT_TAIL(&(MLACP(csm).ndisc_msg_list), msg_send, tail);
                 /* ICCPD_LOG_DEBUG(__FUNCTION__, "Enqueue Ndisc[DEL] for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr)); */
             }
@@ -960,11 +1013,10 @@ void do_arp_update_from_reply_packet(unsigned int ifindex, unsigned int addr, ui
     }
 
     /* update lif ARP*/
-    TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+    msg = mlacp_arp_find(csm, arp_msg->ipv4_addr);
+    if (msg)
     {
         arp_info = (struct ARPMsg*)msg->buf;
-        if (arp_info->ipv4_addr != arp_msg->ipv4_addr)
-            continue;
 
         /* update ARP*/
         if (arp_info->op_type != arp_msg->op_type
@@ -972,12 +1024,11 @@ void do_arp_update_from_reply_packet(unsigned int ifindex, unsigned int addr, ui
             || memcmp(arp_info->mac_addr, arp_msg->mac_addr, ETHER_ADDR_LEN) != 0)
         {
             arp_info->op_type = arp_msg->op_type;
-            sprintf(arp_info->ifname, "%s", arp_msg->ifname);
+            mlacp_arp_set_ifname(csm, msg, arp_msg->ifname);
             memcpy(arp_info->mac_addr, arp_msg->mac_addr, ETHER_ADDR_LEN);
             ICCPD_LOG_DEBUG(__FUNCTION__, "Update ARP for %s",
                             show_ip_str(arp_msg->ipv4_addr));
         }
-        break;
     }
 
     /* enquene lif_msg (add)*/
@@ -1003,6 +1054,7 @@ void do_arp_update_from_reply_packet(unsigned int ifindex, unsigned int addr, ui
         arp_msg->flag = 0;
         if (iccp_csm_init_msg(&msg_send, (char*)arp_msg, msg_len) == 0)
         {
+            msg_send->trace_usec = system_latency_queue_stamp();
             TAILQ_INSERT_TAIL(&(MLACP(csm).arp_msg_list), msg_send, tail);
             /*ICCPD_LOG_DEBUG(__FUNCTION__, "Enqueue ARP[ADD] for %s",
                             show_ip_str(arp_msg->ipv4_addr));*/
@@ -1182,13 +1234,11 @@ void do_ndisc_update_from_reply_packet(unsigned int ifindex, char *ipv6_addr, ui
     }
 
     /* update lif ND */
-    TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+    msg = mlacp_ndisc_find(csm, ndisc_msg->ipv6_addr);
+    if (msg)
     {
         ndisc_info = (struct NDISCMsg *)msg->buf;
 
-        if (memcmp((char *)ndisc_info->ipv6_addr, (char *)ndisc_msg->ipv6_addr, 16) != 0)
-            continue;
-
         /* If MAC addr is NULL, use the old one */
         if (memcmp(mac_addr, null_mac, ETHER_ADDR_LEN) == 0)
         {
@@ -1202,11 +1252,10 @@ void do_ndisc_update_from_reply_packet(unsigned int ifindex, char *ipv6_addr, ui
             || strcmp(ndisc_info->ifname, ndisc_msg->ifname) != 0 || memcmp(ndisc_info->mac_addr, ndisc_msg->mac_addr, ETHER_ADDR_LEN) != 0)
         {
             ndisc_info->op_type = ndisc_msg->op_type;
-            sprintf(ndisc_info->ifname, "%s", ndisc_msg->ifname);
+            mlacp_ndisc_set_ifname(csm, msg, ndisc_msg->ifname);
             memcpy(ndisc_info->mac_addr, ndisc_msg->mac_addr, ETHER_ADDR_LEN);
              ICCPD_LOG_DEBUG(__FUNCTION__, "Update ND for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr)); 
         }
-        break;
     }
 
     /* enquene lif_msg (add) */
@@ -1231,13 +1280,12 @@ void do_ndisc_update_from_reply_packet(unsigned int ifindex, char *ipv6_addr, ui
 
     ICCPD_LOG_DEBUG(__FUNCTION__, "add nd entry(%s, %s, %s) to kernel",
             ndisc_msg->ifname, show_ipv6_str((char *)ndisc_msg->ipv6_addr), mac_str);
+    /* Kernel errors show up when the request completes, see mlacp_neigh_add_failed() */
     if ((err = iccp_netlink_neighbor_request(AF_INET6, (uint8_t *)ndisc_msg->ipv6_addr, 1, ndisc_msg->mac_addr, ndisc_msg->ifname, 0, 3)) < 0)
     {
-        if (err != ICCP_NLE_SEQ_MISMATCH) {
-            ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to add nd entry(%s, %s, %s) to kernel, status %d",
-                        ndisc_msg->ifname, show_ipv6_str((char *)ndisc_msg->ipv6_addr), mac_str, err);
-            return;
-        }
+        ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to request nd entry(%s, %s, %s) add, status %d",
+                         ndisc_msg->ifname, show_ipv6_str((char *)ndisc_msg->ipv6_addr), mac_str, err);
+        return;
     }
 
     /* enqueue iccp_msg (add) */
@@ -1247,6 +1295,7 @@ void do_ndisc_update_from_reply_packet(unsigned int ifindex, char *ipv6_addr, ui
         ndisc_msg->flag = 0;
         if (iccp_csm_init_msg(&msg_send, (char *)ndisc_msg, msg_len) == 0)
         {
+            msg_send->trace_usec = system_latency_queue_stamp();
             TAILQ_INSERT_TAIL(&(MLACP(csm).ndisc_msg_list), msg_send, tail);
             /* ICCPD_LOG_DEBUG(__FUNCTION__, "Enqueue ND[ADD] for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr)); */
         }
@@ -257,6 +257,9 @@ int main(int argc, char* argv[])
     sys->cmd_file_path = strdup(parser.cmd_file_path);
     sys->config_file_path = strdup(parser.config_file_path);
     sys->mclagdctl_file_path = strdup(parser.mclagdctl_file_path);
+    if (sys->snapshot_file_path != NULL)
+        free(sys->snapshot_file_path);
+    sys->snapshot_file_path = strdup(parser.snapshot_file_path);
     sys->pid_file_fd = pid_file_fd;
     sys->telnet_port = parser.telnet_port;
     parser.finalize(&parser);
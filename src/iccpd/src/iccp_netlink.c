@@ -21,12 +21,17 @@
  *  Maintainer: jianjun, grace Li from nephos
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* recvmmsg */
+#endif
 #include <stdio.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <sys/epoll.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -46,6 +51,7 @@
 #include <linux/types.h>
 #include <linux/socket.h>
 #include <linux/in6.h>
+#include <linux/filter.h>
 
 #include "../include/system.h"
 #include "../include/iccp_ifm.h"
@@ -76,79 +82,10 @@
 /* Use the same socket buffer size as in SwSS common */
 #define NETLINK_SOCKET_BUFFER_SIZE      16777216
 
-static int iccp_ack_handler(struct nl_msg *msg, void *arg)
-{
-    bool *acked = arg;
-
-    *acked = true;
-
-    return NL_STOP;
-}
-
-static int iccp_seq_check_handler(struct nl_msg *msg, void *arg)
-{
-    unsigned int *seq = arg;
-    struct nlmsghdr *hdr = nlmsg_hdr(msg);
-
-    if (hdr->nlmsg_seq != *seq)
-        return NL_SKIP;
-
-    return NL_OK;
-}
-
-int iccp_send_and_recv(struct System *sys, struct nl_msg *msg,
-                       int (*valid_handler)(struct nl_msg *, void *),
-                       void *valid_data)
-{
-    int ret;
-    struct nl_cb *cb;
-    struct nl_cb *orig_cb;
-    bool acked;
-    unsigned int seq = sys->genric_sock_seq++;
-    int err;
-
-    ret = nl_send_auto(sys->genric_sock, msg);
-    nlmsg_free(msg);
-    if (ret < 0)
-        return ret;
-
-    orig_cb = nl_socket_get_cb(sys->genric_sock);
-    cb = nl_cb_clone(orig_cb);
-    nl_cb_put(orig_cb);
-    if (!cb)
-        return -ENOMEM;
-
-    nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, iccp_ack_handler, &acked);
-    nl_cb_set(cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, iccp_seq_check_handler, &seq);
-    if (valid_handler)
-        nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, valid_handler, valid_data);
-
-    /* There is a bug in libnl. When implicit sequence number checking is in
-     * use the expected next number is increased when NLMSG_DONE is
-     * received. The ACK which comes after that correctly includes the
-     * original sequence number. However libnl is checking that number
-     * against the incremented one and therefore ack handler is never called
-     * and nl_recvmsgs finished with an error. To resolve this, custom
-     * sequence number checking is used here.
-     */
-
-    acked = false;
-
-    while (!acked)
-    {
-        ret = nl_recvmsgs(sys->genric_sock, cb);
-        if (ret)
-        {
-            err = ret;
-            goto put_cb;
-        }
-    }
-
-    err = 0;
-put_cb:
-    nl_cb_put(cb);
-    return err;
-}
+#define ICCP_PACKET_BATCH_SIZE          32
+#define ICCP_PACKET_RX_BUDGET           256
+#define ICCP_ARP_PACKET_SIZE            128
+#define ICCP_NDISC_PACKET_SIZE          512
 
 int iccp_get_portchannel_member_list_handler(struct nl_msg *msg, void * arg)
 {
@@ -382,20 +319,177 @@ int iccp_genric_socket_team_family_get()
     return err;
 }
 
-int iccp_get_port_member_list(struct LocalInterface* lif)
+/* PortChannel member queries are pipelined on genric_sock, replies are
+ * matched by sequence number and handled from the event loop */
+#define TEAM_QUERY_MAX_INFLIGHT     256
+#define TEAM_QUERY_WAIT_MSEC        1000
+/* iccp_team_query_recv result when nothing arrived within the timeout */
+#define TEAM_QUERY_RECV_TIMEOUT     1
+
+struct team_query_entry
 {
-    struct System *sys;
-    struct nl_msg *msg;
-    int err;
+    uint32_t seq;
+    int in_use;
+    uint32_t ifindex;
+};
 
-    sys = system_get_instance();
-    if (sys == NULL)
+static struct nl_cb *team_query_cb = NULL;
+static uint32_t team_query_inflight = 0;
+static struct team_query_entry team_query_entries[TEAM_QUERY_MAX_INFLIGHT];
+
+static void iccp_team_query_reset()
+{
+    memset(team_query_entries, 0, sizeof(team_query_entries));
+    team_query_inflight = 0;
+}
+
+static struct team_query_entry *iccp_team_query_find(uint32_t seq)
+{
+    struct team_query_entry *entry = &team_query_entries[seq % TEAM_QUERY_MAX_INFLIGHT];
+
+    if (!entry->in_use || entry->seq != seq)
+        return NULL;
+
+    return entry;
+}
+
+static void iccp_team_query_complete(uint32_t seq, int error)
+{
+    struct team_query_entry *entry = iccp_team_query_find(seq);
+
+    if (!entry)
+        return;
+
+    if (error)
+        ICCPD_LOG_ERR(__FUNCTION__, "PortChannel member query of ifindex %u error, err = %d",
+                      entry->ifindex, error);
+
+    entry->in_use = 0;
+    --team_query_inflight;
+}
+
+static int iccp_team_query_seq_check_handler(struct nl_msg *msg, void *arg)
+{
+    if (!iccp_team_query_find(nlmsg_hdr(msg)->nlmsg_seq))
+        return NL_SKIP;
+
+    return NL_OK;
+}
+
+static int iccp_team_query_ack_handler(struct nl_msg *msg, void *arg)
+{
+    iccp_team_query_complete(nlmsg_hdr(msg)->nlmsg_seq, 0);
+
+    return NL_OK;
+}
+
+static int iccp_team_query_err_handler(struct sockaddr_nl *nla, struct nlmsgerr *nlerr, void *arg)
+{
+    iccp_team_query_complete(nlerr->msg.nlmsg_seq, nlerr->error);
+
+    return NL_SKIP;
+}
+
+/* There is a bug in libnl. When implicit sequence number checking is in
+ * use the expected next number is increased when NLMSG_DONE is
+ * received. The ACK which comes after that correctly includes the
+ * original sequence number. However libnl is checking that number
+ * against the incremented one and therefore ack handler is never called
+ * and nl_recvmsgs finished with an error. To resolve this, sequence
+ * numbers are checked against the query table.
+ */
+static int iccp_team_query_cb_init(struct System *sys)
+{
+    struct nl_cb *orig_cb;
+
+    if (team_query_cb)
         return 0;
 
-    msg = nlmsg_alloc();
-    if (!msg)
+    orig_cb = nl_socket_get_cb(sys->genric_sock);
+    team_query_cb = nl_cb_clone(orig_cb);
+    nl_cb_put(orig_cb);
+    if (!team_query_cb)
         return -ENOMEM;
 
+    nl_cb_set(team_query_cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, iccp_team_query_seq_check_handler, NULL);
+    nl_cb_set(team_query_cb, NL_CB_ACK, NL_CB_CUSTOM, iccp_team_query_ack_handler, NULL);
+    nl_cb_err(team_query_cb, NL_CB_CUSTOM, iccp_team_query_err_handler, NULL);
+    nl_cb_set(team_query_cb, NL_CB_VALID, NL_CB_CUSTOM, iccp_get_portchannel_member_list_handler, NULL);
+
+    return 0;
+}
+
+/* Handle replies of in flight queries, waiting up to timeout msec for
+ * the socket to become readable. Return -1 if replies were lost and
+ * TEAM_QUERY_RECV_TIMEOUT if the socket did not become readable */
+static int iccp_team_query_recv(struct System *sys, int timeout)
+{
+    struct pollfd pfd;
+    int ret;
+
+    if (!team_query_cb)
+        return 0;
+
+    pfd.fd = nl_socket_get_fd(sys->genric_sock);
+    pfd.events = POLLIN;
+
+    ret = poll(&pfd, 1, timeout);
+    if (ret == 0)
+        return TEAM_QUERY_RECV_TIMEOUT;
+    if (ret < 0)
+        return 0;
+
+    ret = nl_recvmsgs(sys->genric_sock, team_query_cb);
+    if (ret < 0)
+    {
+        /* Member lists of the in flight queries are unknown, query again */
+        ICCPD_LOG_WARN(__FUNCTION__, "PortChannel member query recv error %d, %u queries in flight",
+                       ret, team_query_inflight);
+        SYSTEM_INCR_NETLINK_RX_ERROR();
+        iccp_team_query_reset();
+        sys->need_sync_team_again = 1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Wait for all in flight queries to complete. A query completes on its
+ * ACK or error, which come in their own datagram after the multipart
+ * member list, so keep reading until they arrive */
+static int iccp_team_query_wait(struct System *sys)
+{
+    int ret;
+
+    while (team_query_inflight > 0)
+    {
+        ret = iccp_team_query_recv(sys, TEAM_QUERY_WAIT_MSEC);
+        if (ret < 0)
+            return MCLAG_ERROR;
+
+        /* Nothing arrived in time, give up on the lost replies */
+        if (ret == TEAM_QUERY_RECV_TIMEOUT)
+        {
+            ICCPD_LOG_WARN(__FUNCTION__, "PortChannel member query timeout, %u queries in flight",
+                           team_query_inflight);
+            iccp_team_query_reset();
+            sys->need_sync_team_again = 1;
+            return MCLAG_ERROR;
+        }
+    }
+
+    return 0;
+}
+
+/* Send a member list query, the reply is handled by
+ * iccp_get_portchannel_member_list_handler */
+static int iccp_team_query_send(struct System *sys, struct LocalInterface* lif)
+{
+    struct team_query_entry *entry = NULL;
+    struct nl_msg *msg;
+    uint32_t seq;
+    int err;
+
     err = iccp_genric_socket_team_family_get();
     if (err)
     {
@@ -403,20 +497,79 @@ int iccp_get_port_member_list(struct LocalInterface* lif)
         return err;
     }
 
-    genlmsg_put(msg, NL_AUTO_PID, sys->genric_sock_seq, sys->family, 0, 0,
+    err = iccp_team_query_cb_init(sys);
+    if (err)
+        return err;
+
+    /* Make room for the query */
+    if (team_query_inflight >= TEAM_QUERY_MAX_INFLIGHT)
+        iccp_team_query_wait(sys);
+
+    msg = nlmsg_alloc();
+    if (!msg)
+        return -ENOMEM;
+
+    seq = sys->genric_sock_seq++;
+    genlmsg_put(msg, NL_AUTO_PID, seq, sys->family, 0, 0,
                 TEAM_CMD_PORT_LIST_GET, 0);
     nla_put_u32(msg, TEAM_ATTR_TEAM_IFINDEX, lif->ifindex);
 
-    err = iccp_send_and_recv(sys, msg, iccp_get_portchannel_member_list_handler, lif);
-    if (err)
+    err = nl_send_auto(sys->genric_sock, msg);
+    nlmsg_free(msg);
+    if (err < 0)
     {
-        ICCPD_LOG_ERR(__FUNCTION__, "recv msg err err = %d . errno = %d", err, errno);
+        ICCPD_LOG_ERR(__FUNCTION__, "send msg err err = %d . errno = %d", err, errno);
         return err;
     }
 
+    entry = &team_query_entries[seq % TEAM_QUERY_MAX_INFLIGHT];
+    if (entry->in_use)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "PortChannel member query reply of seq %u is lost", entry->seq);
+        --team_query_inflight;
+    }
+
+    entry->seq = seq;
+    entry->in_use = 1;
+    entry->ifindex = lif->ifindex;
+    ++team_query_inflight;
+    ++sys->dbg_counters.team_query_counter;
+    if (team_query_inflight > sys->dbg_counters.team_query_max_inflight)
+        sys->dbg_counters.team_query_max_inflight = team_query_inflight;
+
     return 0;
 }
 
+/* Query the member list and wait for it */
+int iccp_get_port_member_list(struct LocalInterface* lif)
+{
+    struct System *sys;
+    int err;
+
+    sys = system_get_instance();
+    if (sys == NULL)
+        return 0;
+
+    err = iccp_team_query_send(sys, lif);
+    if (err)
+        return err;
+
+    return iccp_team_query_wait(sys);
+}
+
+/* Query the member list, it is updated when the reply is handled from
+ * the event loop */
+int iccp_get_port_member_list_async(struct LocalInterface* lif)
+{
+    struct System *sys;
+
+    sys = system_get_instance();
+    if (sys == NULL)
+        return 0;
+
+    return iccp_team_query_send(sys, lif);
+}
+
 int iccp_netlink_if_hwaddr_set(uint32_t ifindex, uint8_t *addr, unsigned int addr_len)
 {
     struct rtnl_link *link;
@@ -441,6 +594,7 @@ int iccp_netlink_if_hwaddr_set(uint32_t ifindex, uint8_t *addr, unsigned int add
     rtnl_link_set_ifindex(link, ifindex);
     rtnl_link_set_addr(link, nl_addr);
 
+    iccp_netlink_neigh_batch_flush();
     err = rtnl_link_change(sys->route_sock, link, link, 0);
 
     nl_addr_put(nl_addr);
@@ -501,18 +655,7 @@ void iccp_set_interface_ipadd_mac(struct LocalInterface *lif, char * mac_addr )
 
     /*send msg*/
     if (sys->sync_fd)
-    {
-        if (write(sys->sync_fd,msg_buf, msg_hdr->len) == -1)
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
-        }
-        else
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
-        }
-    }
+        iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
     return;
 }
 
@@ -532,6 +675,7 @@ int iccp_netlink_if_startup_set(uint32_t ifindex)
     rtnl_link_set_ifindex(link, ifindex);
     rtnl_link_set_flags(link, IFF_UP);
 
+    iccp_netlink_neigh_batch_flush();
     err = rtnl_link_change(sys->route_sock, link, link, 0);
 
 errout:
@@ -555,6 +699,7 @@ int iccp_netlink_if_shutdown_set(uint32_t ifindex)
     rtnl_link_set_ifindex(link, ifindex);
     rtnl_link_unset_flags(link, IFF_UP);
 
+    iccp_netlink_neigh_batch_flush();
     err = rtnl_link_change(sys->route_sock, link, link, 0);
 
 errout:
@@ -824,6 +969,257 @@ void recover_if_ipmac_on_standby(struct LocalInterface *lif_po, int dir)
     return;
 }
 
+/* Neighbor requests are batched on a dedicated route socket, a batch is
+ * sent with a single sendmsg and the ACKs are matched by sequence number */
+#define NEIGH_BATCH_BUF_SIZE        32768
+#define NEIGH_BATCH_MAX_INFLIGHT    4096
+
+struct neigh_batch_entry
+{
+    uint32_t seq;
+    int in_use;
+    int family;
+    int add;
+    uint8_t addr[16];
+    uint8_t mac[ETHER_ADDR_LEN];
+    char ifname[MAX_L_PORT_NAME];
+};
+
+static char neigh_batch_buf[NEIGH_BATCH_BUF_SIZE];
+static size_t neigh_batch_len = 0;
+static uint32_t neigh_batch_seq = 0;
+static uint32_t neigh_batch_inflight = 0;
+static struct neigh_batch_entry neigh_batch_entries[NEIGH_BATCH_MAX_INFLIGHT];
+
+/* Add the kernel rejected. The entry is dropped from the neighbor lists
+ * later, the requests are made while walking those lists */
+struct neigh_add_failure
+{
+    TAILQ_ENTRY(neigh_add_failure) tail;
+    int family;
+    uint8_t addr[16];
+    uint8_t mac[ETHER_ADDR_LEN];
+    char ifname[MAX_L_PORT_NAME];
+};
+
+static TAILQ_HEAD(neigh_add_failure_list, neigh_add_failure) neigh_add_failures =
+    TAILQ_HEAD_INITIALIZER(neigh_add_failures);
+
+static void iccp_netlink_neigh_add_failed(int family, uint8_t *addr, uint8_t *mac, char *ifname)
+{
+    struct neigh_add_failure *failure = NULL;
+
+    failure = (struct neigh_add_failure *)malloc(sizeof(struct neigh_add_failure));
+    if (!failure)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Unable to allocate neighbor add failure, intf %s", ifname);
+        return;
+    }
+
+    failure->family = family;
+    memcpy(failure->addr, addr, (family == AF_INET) ? 4 : 16);
+    memcpy(failure->mac, mac, ETHER_ADDR_LEN);
+    snprintf(failure->ifname, sizeof(failure->ifname), "%s", ifname);
+    TAILQ_INSERT_TAIL(&neigh_add_failures, failure, tail);
+}
+
+/* Drop the entries the kernel refused to add */
+static void iccp_netlink_neigh_add_failures_handle()
+{
+    struct neigh_add_failure *failure = NULL;
+
+    while ((failure = TAILQ_FIRST(&neigh_add_failures)) != NULL)
+    {
+        TAILQ_REMOVE(&neigh_add_failures, failure, tail);
+        mlacp_neigh_add_failed(failure->family, failure->addr, failure->mac, failure->ifname);
+        free(failure);
+    }
+}
+
+static void iccp_netlink_neigh_batch_reset()
+{
+    memset(neigh_batch_entries, 0, sizeof(neigh_batch_entries));
+    neigh_batch_len = 0;
+    neigh_batch_inflight = 0;
+}
+
+static void iccp_netlink_neigh_batch_complete(uint32_t seq, int error)
+{
+    struct neigh_batch_entry *entry = &neigh_batch_entries[seq % NEIGH_BATCH_MAX_INFLIGHT];
+    char mac_str[18] = "";
+
+    if (!entry->in_use || entry->seq != seq)
+        return;
+
+    if (error)
+    {
+        sprintf(mac_str, "%02x:%02x:%02x:%02x:%02x:%02x", entry->mac[0], entry->mac[1], entry->mac[2],
+                entry->mac[3], entry->mac[4], entry->mac[5]);
+        if (entry->add)
+        {
+            ICCPD_LOG_ERR(__FUNCTION__, "add %s entry(ip:%s, mac:%s, intf:%s) error, err = %d",
+                          (entry->family == AF_INET) ? "ARP" : "ND",
+                          (entry->family == AF_INET) ? show_ip_str(*((int *)entry->addr)) : show_ipv6_str((char *)entry->addr),
+                          mac_str, entry->ifname, error);
+            iccp_netlink_neigh_add_failed(entry->family, entry->addr, entry->mac, entry->ifname);
+        }
+        else
+        {
+            ICCPD_LOG_DEBUG(__FUNCTION__, "del %s entry(ip:%s, mac:%s, intf:%s) error, err = %d",
+                            (entry->family == AF_INET) ? "ARP" : "ND",
+                            (entry->family == AF_INET) ? show_ip_str(*((int *)entry->addr)) : show_ipv6_str((char *)entry->addr),
+                            mac_str, entry->ifname, error);
+        }
+    }
+
+    entry->in_use = 0;
+    --neigh_batch_inflight;
+}
+
+/* Match ACKs of sent batches, return -1 if the socket failed. The socket
+ * is drained until EAGAIN even when nothing is tracked, ACKs of reset or
+ * overwritten requests would otherwise keep the level triggered fd ready */
+static int iccp_netlink_neigh_batch_recv(struct System *sys)
+{
+    static char buf[NEIGH_BATCH_BUF_SIZE];
+    struct nlmsghdr *nlh = NULL;
+    struct nlmsgerr *nlerr = NULL;
+    int fd;
+    int len;
+    int err;
+
+    fd = nl_socket_get_fd(sys->neigh_batch_sock);
+
+    while (1)
+    {
+        len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0)
+        {
+            err = errno;
+            if (err == EINTR)
+                continue;
+            if (err == EAGAIN || err == EWOULDBLOCK)
+                return 0;
+
+            /* ACKs were lost, outcome of the in flight requests is unknown */
+            ICCPD_LOG_WARN(__FUNCTION__, "neighbor batch recv error, errno %d, %u requests in flight",
+                           err, neigh_batch_inflight);
+            SYSTEM_INCR_NETLINK_RX_ERROR();
+            iccp_netlink_neigh_batch_reset();
+
+            /* The socket stays usable after an overrun, read what is left */
+            if (err == ENOBUFS)
+                continue;
+            return -1;
+        }
+
+        /* ACKs with unknown sequence numbers are ignored by complete */
+        for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
+        {
+            if (nlh->nlmsg_type != NLMSG_ERROR)
+                continue;
+
+            nlerr = (struct nlmsgerr *)NLMSG_DATA(nlh);
+            iccp_netlink_neigh_batch_complete(nlh->nlmsg_seq, nlerr->error);
+        }
+    }
+
+    return 0;
+}
+
+/* Send the queued neighbor requests */
+void iccp_netlink_neigh_batch_flush()
+{
+    struct System *sys = NULL;
+    struct nlmsghdr *nlh = NULL;
+    size_t offset;
+    int ret;
+    int err;
+
+    if (!(sys = system_get_instance()) || !sys->neigh_batch_sock || neigh_batch_len == 0)
+        return;
+
+    do
+    {
+        ret = send(nl_socket_get_fd(sys->neigh_batch_sock), neigh_batch_buf, neigh_batch_len, 0);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        err = -errno;
+        ICCPD_LOG_ERR(__FUNCTION__, "neighbor batch send error, errno %d", -err);
+        for (offset = 0; offset < neigh_batch_len; offset += NLMSG_ALIGN(nlh->nlmsg_len))
+        {
+            nlh = (struct nlmsghdr *)(neigh_batch_buf + offset);
+            iccp_netlink_neigh_batch_complete(nlh->nlmsg_seq, err);
+        }
+    }
+
+    neigh_batch_len = 0;
+}
+
+/* Queue a neighbor add/del request, errors are reported when its ACK
+ * arrives */
+static int iccp_netlink_neigh_batch_add(struct System *sys, struct rtnl_neigh *neigh, int family,
+                                        uint8_t *addr, int add, uint8_t *mac, char *portname)
+{
+    struct nl_msg *msg = NULL;
+    struct nlmsghdr *nlh = NULL;
+    struct neigh_batch_entry *entry = NULL;
+    size_t msg_len;
+    int err;
+
+    if (add)
+        err = rtnl_neigh_build_add_request(neigh, NLM_F_REPLACE | NLM_F_CREATE, &msg);
+    else
+        err = rtnl_neigh_build_delete_request(neigh, 0, &msg);
+    if (err < 0)
+        return err;
+
+    nlh = nlmsg_hdr(msg);
+    msg_len = NLMSG_ALIGN(nlh->nlmsg_len);
+    if (neigh_batch_len + msg_len > NEIGH_BATCH_BUF_SIZE)
+        iccp_netlink_neigh_batch_flush();
+
+    /* Kernel ACKs route requests before sendmsg returns, pick them up
+     * when all tracking slots are used */
+    if (neigh_batch_inflight >= NEIGH_BATCH_MAX_INFLIGHT)
+    {
+        iccp_netlink_neigh_batch_flush();
+        iccp_netlink_neigh_batch_recv(sys);
+    }
+
+    ++neigh_batch_seq;
+    entry = &neigh_batch_entries[neigh_batch_seq % NEIGH_BATCH_MAX_INFLIGHT];
+    if (entry->in_use)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "neighbor batch ACK of seq %u is lost", entry->seq);
+        --neigh_batch_inflight;
+    }
+
+    entry->seq = neigh_batch_seq;
+    entry->in_use = 1;
+    entry->family = family;
+    entry->add = add;
+    memcpy(entry->addr, addr, (family == AF_INET) ? 4 : 16);
+    memcpy(entry->mac, mac, ETHER_ADDR_LEN);
+    snprintf(entry->ifname, sizeof(entry->ifname), "%s", portname);
+    ++neigh_batch_inflight;
+
+    nlh->nlmsg_seq = neigh_batch_seq;
+    nlh->nlmsg_pid = 0;
+    nlh->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+    memcpy(neigh_batch_buf + neigh_batch_len, nlh, nlh->nlmsg_len);
+    neigh_batch_len += msg_len;
+
+    nlmsg_free(msg);
+
+    return 0;
+}
+
+/* Request a neighbor add/del. A negative return means no request was
+ * made, entries the kernel refuses to add are dropped from the neighbor
+ * lists once the request completes, see mlacp_neigh_add_failed() */
 int iccp_netlink_neighbor_request(int family, uint8_t *addr, int add, uint8_t *mac, char *portname, int permanent, int dir)
 {
     struct System *sys = NULL;
@@ -883,15 +1279,26 @@ int iccp_netlink_neighbor_request(int family, uint8_t *addr, int add, uint8_t *m
         rtnl_neigh_set_state(neigh, NUD_REACHABLE);
     }
 
-    if (add)
+    if (sys->neigh_batch_sock)
+    {
+        if ((err = iccp_netlink_neigh_batch_add(sys, neigh, family, addr, add, mac, portname)) < 0)
+            ICCPD_LOG_DEBUG(__FUNCTION__, "queue neigh error, err = %d", err);
+    }
+    else if (add)
     {
         if ((err = rtnl_neigh_add(sys->route_sock, neigh, NLM_F_REPLACE | NLM_F_CREATE)) < 0)
+        {
             ICCPD_LOG_DEBUG(__FUNCTION__, "add neigh error, err = %d", err);
+            if (err != ICCP_NLE_SEQ_MISMATCH)
+                iccp_netlink_neigh_add_failed(family, addr, mac, portname);
+        }
+        err = 0;
     }
     else
     {
         if ((err = rtnl_neigh_delete(sys->route_sock, neigh, 0)) < 0)
             ICCPD_LOG_DEBUG(__FUNCTION__, "del neigh error, err = %d", err);
+        err = 0;
     }
 
 errout:
@@ -901,6 +1308,38 @@ errout:
     return err;
 }
 
+/* Digest of the link attributes iccp_event_handler_obj_input_newlink()
+ * looks at, kernel re-syncs skip the links it handled unchanged */
+static uint32_t iccp_netlink_link_digest(struct rtnl_link *link)
+{
+    uint32_t hash = 2166136261u;
+    uint32_t attrs[4];
+    struct nl_addr *nl_addr = rtnl_link_get_addr(link);
+    const char *name = rtnl_link_get_name(link);
+    const uint8_t *p = NULL;
+    unsigned int i;
+
+    attrs[0] = rtnl_link_get_ifindex(link);
+    attrs[1] = rtnl_link_get_operstate(link);
+    attrs[2] = rtnl_link_get_flags(link);
+    attrs[3] = rtnl_link_get_master(link);
+    p = (const uint8_t *)attrs;
+    for (i = 0; i < sizeof(attrs); i++)
+        hash = (hash ^ p[i]) * 16777619u;
+
+    if (nl_addr)
+    {
+        p = nl_addr_get_binary_addr(nl_addr);
+        for (i = 0; i < nl_addr_get_len(nl_addr); i++)
+            hash = (hash ^ p[i]) * 16777619u;
+    }
+
+    for (i = 0; name && name[i]; i++)
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+
+    return hash;
+}
+
 void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg)
 {
     struct rtnl_link *link;
@@ -913,9 +1352,11 @@ void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg)
     int op_state = 0;
     int link_flag = 0;
     uint32_t master_ifindex = 0;
+    uint32_t link_digest = 0;
     char addr_null[16] = { 0 };
 
     link = (struct rtnl_link *)obj;
+    link_digest = iccp_netlink_link_digest(link);
     ifindex = rtnl_link_get_ifindex(link);
     op_state = rtnl_link_get_operstate(link);
     ifname = rtnl_link_get_name(link);
@@ -957,7 +1398,7 @@ void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg)
 
     if (lif && (lif->ifindex == -1) && (lif->type == IF_T_VLAN))
     {
-        lif->ifindex = ifindex;
+        local_if_update_ifindex(lif, ifindex);
         lif->state = (op_state == IF_OPER_UP) ? PORT_STATE_UP : PORT_STATE_DOWN;
 
         if (addr_type == AF_LLC)
@@ -1099,6 +1540,35 @@ void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg)
         }
     }
 
+    if ((lif = local_if_find_by_ifindex(ifindex)) != NULL)
+        lif->link_digest = link_digest;
+
+    return;
+}
+
+/* RTM_NEWLINK from a kernel re-sync dump, arg is the System */
+void iccp_event_handler_obj_resync_link(struct nl_object *obj, void *arg)
+{
+    struct System *sys = (struct System *)arg;
+    struct rtnl_link *link = (struct rtnl_link *)obj;
+    struct LocalInterface *lif = NULL;
+    unsigned int event = 1;
+    int ifindex = rtnl_link_get_ifindex(link);
+
+    lif = local_if_find_by_ifindex(ifindex);
+    if (lif && lif->link_digest == iccp_netlink_link_digest(link))
+    {
+        lif->link_resync_gen = sys->link_resync_gen;
+        ++sys->dbg_counters.netlink_resync_skip_counter;
+        return;
+    }
+
+    ++sys->dbg_counters.netlink_resync_link_counter;
+    iccp_event_handler_obj_input_newlink(obj, &event);
+
+    if ((lif = local_if_find_by_ifindex(ifindex)) != NULL)
+        lif->link_resync_gen = sys->link_resync_gen;
+
     return;
 }
 
@@ -1226,8 +1696,8 @@ int iccp_del_self_ip_from_neigh_table (struct LocalInterface *lif, int addr_fami
     struct System *sys = NULL;
     struct CSM *csm = NULL;
     struct Msg *msg = NULL;
-    struct ARPMsg *arp_msg = NULL, *arp_info = NULL;
-    struct NDISCMsg *ndisc_msg = NULL, *ndisc_info = NULL;
+    struct ARPMsg *arp_msg = NULL;
+    struct NDISCMsg *ndisc_msg = NULL;
     int err = 0;
 
     if (!(sys = system_get_instance()))
@@ -1239,20 +1709,11 @@ int iccp_del_self_ip_from_neigh_table (struct LocalInterface *lif, int addr_fami
 
         LIST_FOREACH(csm, &(sys->csm_list), next)
         {
-            TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
-            {
-                arp_info = (struct ARPMsg *)msg->buf;
-                if (arp_info->ipv4_addr == lif->ipv4_addr) {
-                    ICCPD_LOG_NOTICE(__FUNCTION__, " Delete ARP %s", show_ip_str(lif->ipv4_addr));
-                    break;
-                }
-            }
-
+            msg = mlacp_arp_find(csm, lif->ipv4_addr);
             if (msg)
             {
-                TAILQ_REMOVE(&(MLACP(csm).arp_list), msg, tail);
-                free(msg->buf);
-                free(msg);
+                ICCPD_LOG_NOTICE(__FUNCTION__, " Delete ARP %s", show_ip_str(lif->ipv4_addr));
+                mlacp_dequeue_arp(csm, msg);
                 msg = NULL;
                 break;
             }
@@ -1261,21 +1722,11 @@ int iccp_del_self_ip_from_neigh_table (struct LocalInterface *lif, int addr_fami
 
         LIST_FOREACH(csm, &(sys->csm_list), next)
         {
-            TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
-            {
-                ndisc_info = (struct NDISCMsg *)msg->buf;
-
-                if (memcmp(&ndisc_info->ipv6_addr, &lif->ipv6_addr, 16) == 0) {
-                    ICCPD_LOG_DEBUG(__FUNCTION__, " Delete neighbor %s", show_ipv6_str((char *)lif->ipv6_addr));
-                    break;
-                }
-            }
-
+            msg = mlacp_ndisc_find(csm, lif->ipv6_addr);
             if (msg)
             {
-                TAILQ_REMOVE(&MLACP(csm).ndisc_list, msg, tail);
-                free(msg->buf);
-                free(msg);
+                ICCPD_LOG_DEBUG(__FUNCTION__, " Delete neighbor %s", show_ipv6_str((char *)lif->ipv6_addr));
+                mlacp_dequeue_ndisc(csm, msg);
                 msg = NULL;
                 break;
             }
@@ -1639,6 +2090,50 @@ int iccp_make_nd_socket(void)
     return sock;
 }
 
+/* Only Ethernet/IPv4 ARP replies reach the socket, offsets are from
+ * the ARP header as the link header is removed for SOCK_DGRAM. Without
+ * the filter every ARP packet is read and dropped in user space */
+static void iccp_arp_attach_filter(int fd)
+{
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, offsetof(struct arphdr, ar_pro)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 5),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, offsetof(struct arphdr, ar_hln)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (ETHER_ADDR_LEN << 8) | 4, 0, 3),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, offsetof(struct arphdr, ar_op)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ARPOP_REPLY, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, ICCP_ARP_PACKET_SIZE),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog fprog = {
+        .len = ARRAY_SIZE(code),
+        .filter = code,
+    };
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0)
+        ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to attach ARP socket filter, errno %d", errno);
+}
+
+/* Event sockets and the member query socket get the largest buffers,
+ * an overrun costs a kernel re-sync. SO_RCVBUF is capped by net.core.rmem_max, SO_RCVBUFFORCE
+ * is not with CAP_NET_ADMIN. NETLINK_NO_ENOBUFS is left off as
+ * ENOBUFS is the only sign of lost events */
+static int iccp_netlink_set_event_buffer_size(struct nl_sock *sk)
+{
+    int size = NETLINK_SOCKET_BUFFER_SIZE;
+    int err;
+
+    err = nl_socket_set_buffer_size(sk, size, 0);
+    if (err)
+        return err;
+
+    if (setsockopt(nl_socket_get_fd(sk), SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+        ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to force buffer size of netlink sock %d, errno %d",
+            nl_socket_get_fd(sk), errno);
+
+    return 0;
+}
+
 /*init netlink socket*/
 int iccp_system_init_netlink_socket()
 {
@@ -1688,6 +2183,22 @@ int iccp_system_init_netlink_socket()
         goto err_route_sock_connect;
     }
 
+    /* Batched neighbor programming is optional, requests fall back to
+     * route_sock one at a time without it */
+    sys->neigh_batch_sock = nl_socket_alloc();
+    if (sys->neigh_batch_sock)
+    {
+        val = 1;
+        if (nl_connect(sys->neigh_batch_sock, NETLINK_ROUTE) < 0
+            || nl_socket_set_buffer_size(sys->neigh_batch_sock, NETLINK_SOCKET_BUFFER_SIZE, 0) < 0
+            || setsockopt(nl_socket_get_fd(sys->neigh_batch_sock), SOL_NETLINK, NETLINK_CAP_ACK, &val, sizeof(val)) < 0)
+        {
+            ICCPD_LOG_WARN(__FUNCTION__, "Failed to setup netlink neighbor batch sock.");
+            nl_socket_free(sys->neigh_batch_sock);
+            sys->neigh_batch_sock = NULL;
+        }
+    }
+
     sys->route_event_sock = nl_socket_alloc();
     if (!sys->route_event_sock)
         goto err_route_event_sock_alloc;
@@ -1701,7 +2212,7 @@ int iccp_system_init_netlink_socket()
 
     /* Set the same buffer size as done in SwSS common*/
     //err = nl_socket_set_buffer_size(sys->route_event_sock, 98304, 0);
-    err = nl_socket_set_buffer_size(sys->route_event_sock, NETLINK_SOCKET_BUFFER_SIZE, 0);
+    err = iccp_netlink_set_event_buffer_size(sys->route_event_sock);
     if (err)
     {
         ICCPD_LOG_ERR(__FUNCTION__, "Failed to set buffer size of netlink route event sock.");
@@ -1717,14 +2228,15 @@ int iccp_system_init_netlink_socket()
         goto err_return;
     }
 
-    err = nl_socket_set_buffer_size(sys->genric_sock, 98304, 0);
+    /* Replies of pipelined member queries queue up here */
+    err = iccp_netlink_set_event_buffer_size(sys->genric_sock);
     if (err)
     {
         ICCPD_LOG_ERR(__FUNCTION__, "Failed to set buffer size of netlink sock.");
         goto err_return;
     }
 
-    err = nl_socket_set_buffer_size(sys->genric_event_sock, 98304, 0);
+    err = iccp_netlink_set_event_buffer_size(sys->genric_event_sock);
     if (err)
     {
         ICCPD_LOG_ERR(__FUNCTION__, "Failed to set buffer size of netlink event sock.");
@@ -1788,6 +2300,8 @@ int iccp_system_init_netlink_socket()
         }
     }
 
+    iccp_arp_attach_filter(sys->arp_receive_fd);
+
     /* receive ipv6 packet socket */
     //sys->ndisc_receive_fd = socket(PF_PACKET, SOCK_DGRAM, 0);
     sys->ndisc_receive_fd = iccp_make_nd_socket();
@@ -1817,6 +2331,10 @@ err_return:
 err_route_event_sock_connect:
     nl_socket_free(sys->route_event_sock);
 
+    if (sys->neigh_batch_sock)
+        nl_socket_free(sys->neigh_batch_sock);
+    sys->neigh_batch_sock = NULL;
+
 err_route_sock_alloc:
 err_route_sock_connect:
     nl_socket_free(sys->route_sock);
@@ -1844,9 +2362,21 @@ void iccp_system_dinit_netlink_socket()
     if ((sys = system_get_instance()) == NULL )
         return;
 
+    if (sys->neigh_batch_sock)
+    {
+        iccp_netlink_neigh_batch_flush();
+        nl_socket_free(sys->neigh_batch_sock);
+        sys->neigh_batch_sock = NULL;
+    }
     nl_socket_free(sys->route_event_sock);
     nl_socket_free(sys->route_sock);
     nl_socket_free(sys->genric_event_sock);
+    if (team_query_cb)
+    {
+        nl_cb_put(team_query_cb);
+        team_query_cb = NULL;
+    }
+    iccp_team_query_reset();
     nl_socket_free(sys->genric_sock);
     return;
 }
@@ -1864,8 +2394,16 @@ static int iccp_netlink_genic_sock_event_handler(struct System *sys)
     if (ret)
     {
         sys->need_sync_team_again = 1;
+        /* libnl reports ENOBUFS as NLE_NOMEM */
+        if (ret == -NLE_NOMEM)
+            ++sys->dbg_counters.netlink_overrun_counter;
         ICCPD_LOG_DEBUG(__FUNCTION__, "genric_event_sock %d recvmsg error ret = %d ", nl_socket_get_fd(sys->genric_event_sock), ret);
     }
+    /*get team info again when error happens */
+    if (ret == 0 && sys->need_sync_team_again == 1)
+    {
+        iccp_netlink_sync_again();
+    }
 
     return ret;
 }
@@ -1885,25 +2423,13 @@ static int iccp_get_receive_ndisc_packet_sock_fd(struct System *sys)
     return sys->ndisc_receive_fd;
 }
 
-static int iccp_receive_arp_packet_handler(struct System *sys)
+/* Handle one ARP packet, only replies are learned */
+static void iccp_handle_arp_packet(unsigned char *buf, int n, struct sockaddr_ll *sll)
 {
-    unsigned char buf[1024];
-    struct sockaddr_ll sll;
-    socklen_t sll_len = sizeof(sll);
     struct arphdr *a = (struct arphdr*)buf;
-    int n;
     unsigned int ifindex;
     unsigned int addr;
     uint8_t mac_addr[ETHER_ADDR_LEN];
-    struct CSM* csm = NULL;
-
-    n = recvfrom(sys->arp_receive_fd, buf, sizeof(buf), MSG_DONTWAIT,
-                 (struct sockaddr*)&sll, &sll_len);
-    if (n < 0)
-    {
-        ICCPD_LOG_WARN(__FUNCTION__, "ARP recvfrom error: %s", buf);
-        return MCLAG_ERROR;
-    }
 
     /* Sanity checks */
     /*Only process ARPOP_REPLY*/
@@ -1911,32 +2437,83 @@ static int iccp_receive_arp_packet_handler(struct System *sys)
         a->ar_op != htons(ARPOP_REPLY) ||
         a->ar_pln != 4 ||
         a->ar_pro != htons(ETH_P_IP) ||
-        a->ar_hln != sll.sll_halen ||
+        a->ar_hln != sll->sll_halen ||
         sizeof(*a) + 2 * 4 + 2 * a->ar_hln > n)
-        return 0;
-
-    /*Check if mclag configured*/
-    csm = system_get_first_csm();
-    if (!csm)
-        return 0;
+        return;
 
-    ifindex = sll.sll_ifindex;
+    ifindex = sll->sll_ifindex;
     memcpy(mac_addr,  (char*)(a + 1), ETHER_ADDR_LEN);
     memcpy(&addr, (char*)(a + 1) + a->ar_hln, 4);
 
     do_arp_update_from_reply_packet(ifindex, addr, mac_addr);
+}
+
+/* Packets are drained up to ICCP_PACKET_BATCH_SIZE per recvmmsg and
+ * ICCP_PACKET_RX_BUDGET per wakeup, so an ARP storm can't starve the
+ * other event sources. epoll is level triggered, leftovers wake the
+ * loop again */
+static int iccp_receive_arp_packet_handler(struct System *sys)
+{
+    static unsigned char bufs[ICCP_PACKET_BATCH_SIZE][ICCP_ARP_PACKET_SIZE];
+    static struct sockaddr_ll slls[ICCP_PACKET_BATCH_SIZE];
+    static struct iovec iovs[ICCP_PACKET_BATCH_SIZE];
+    static struct mmsghdr msgs[ICCP_PACKET_BATCH_SIZE];
+    struct CSM* csm = NULL;
+    int total = 0;
+    int n, i;
+
+    /*Check if mclag configured, drain the socket anyway*/
+    csm = system_get_first_csm();
+
+    while (total < ICCP_PACKET_RX_BUDGET)
+    {
+        for (i = 0; i < ICCP_PACKET_BATCH_SIZE; i++)
+        {
+            iovs[i].iov_base = bufs[i];
+            iovs[i].iov_len = ICCP_ARP_PACKET_SIZE;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_name = &slls[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(slls[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        n = recvmmsg(sys->arp_receive_fd, msgs, ICCP_PACKET_BATCH_SIZE, MSG_DONTWAIT, NULL);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+
+            ICCPD_LOG_WARN(__FUNCTION__, "ARP recvmmsg error, errno %d", errno);
+            return MCLAG_ERROR;
+        }
+
+        if (n == 0)
+            break;
+
+        total += n;
+        sys->dbg_counters.arp_rx_packet_counter += n;
+
+        if (csm)
+        {
+            for (i = 0; i < n; i++)
+                iccp_handle_arp_packet(bufs[i], msgs[i].msg_len, &slls[i]);
+        }
+
+        if (n < ICCP_PACKET_BATCH_SIZE)
+            break;
+    }
+
+    if (total >= ICCP_PACKET_RX_BUDGET)
+        ++sys->dbg_counters.packet_rx_budget_counter;
 
     return 0;
 }
 
-int iccp_receive_ndisc_packet_handler(struct System *sys)
+/* Handle one neighbor advertisement */
+static void iccp_handle_ndisc_packet(uint8_t *buf, int len, struct msghdr *msg)
 {
-    uint8_t buf[4096];
-    uint8_t adata[1024];
-    struct sockaddr_in6 from;
     unsigned int ifindex = 0;
-    struct msghdr msg;
-    struct iovec iov;
     struct cmsghdr *cmsgptr;
     struct nd_msg *ndmsg = NULL;
     struct nd_opt_hdr *nd_opt = NULL;
@@ -1944,29 +2521,12 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
     uint8_t mac_addr[ETHER_ADDR_LEN] = { 0 };
     int8_t *opt = NULL;
     int opt_len = 0, l = 0;
-    int len;
-    struct CSM* csm = NULL;
-
-    /* Fill in message and iovec. */
-    msg.msg_name = (void *)(&from);
-    msg.msg_namelen = sizeof(struct sockaddr_in6);
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = (void *)adata;
-    msg.msg_controllen = sizeof adata;
-    iov.iov_base = buf;
-    iov.iov_len = 4096;
-
-    len = recvmsg(sys->ndisc_receive_fd, &msg, 0);
 
-    if (len < 0)
-    {
-        ICCPD_LOG_DEBUG(__FUNCTION__, "ndisc recvmsg error!");
-        return MCLAG_ERROR;
-    }
+    if (len < sizeof(struct nd_msg))
+        return;
 
-    if (msg.msg_controllen >= sizeof(struct cmsghdr))
-        for (cmsgptr = CMSG_FIRSTHDR(&msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR(&msg, cmsgptr))
+    if (msg->msg_controllen >= sizeof(struct cmsghdr))
+        for (cmsgptr = CMSG_FIRSTHDR(msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR(msg, cmsgptr))
         {
             /* I want interface index which this packet comes from. */
             if (cmsgptr->cmsg_level == IPPROTO_IPV6 && cmsgptr->cmsg_type == IPV6_PKTINFO)
@@ -1980,13 +2540,8 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
 
     ndmsg = (struct nd_msg *)buf;
 
-    /*Check if mclag configured*/
-    csm = system_get_first_csm();
-    if (!csm)
-        return 0;
-
     if (ndmsg->icmph.icmp6_type != NDISC_NEIGHBOUR_ADVERTISEMENT)
-        return 0;
+        return;
 
     memcpy((char *)(&target), (char *)(&ndmsg->target), sizeof(struct in6_addr));
 
@@ -1999,14 +2554,14 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
         while (opt_len)
         {
             if (opt_len < sizeof(struct nd_opt_hdr))
-                return 0;
+                return;
 
             nd_opt = (struct nd_opt_hdr *)opt;
 
             l = nd_opt->nd_opt_len << 3;
 
-            if (l == 0)
-                return 0;
+            if (l == 0 || l > opt_len)
+                return;
 
             if (nd_opt->nd_opt_type == ND_OPT_TARGET_LL_ADDR)
             {
@@ -2020,39 +2575,131 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
     }
 
     do_ndisc_update_from_reply_packet(ifindex, (char *)&target, mac_addr);
+}
+
+int iccp_receive_ndisc_packet_handler(struct System *sys)
+{
+    static uint8_t bufs[ICCP_PACKET_BATCH_SIZE][ICCP_NDISC_PACKET_SIZE];
+    static uint8_t adata[ICCP_PACKET_BATCH_SIZE][CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    static struct sockaddr_in6 from[ICCP_PACKET_BATCH_SIZE];
+    static struct iovec iovs[ICCP_PACKET_BATCH_SIZE];
+    static struct mmsghdr msgs[ICCP_PACKET_BATCH_SIZE];
+    struct CSM* csm = NULL;
+    int total = 0;
+    int n, i;
+
+    /*Check if mclag configured, drain the socket anyway*/
+    csm = system_get_first_csm();
+
+    while (total < ICCP_PACKET_RX_BUDGET)
+    {
+        /* Fill in messages and iovecs. */
+        for (i = 0; i < ICCP_PACKET_BATCH_SIZE; i++)
+        {
+            iovs[i].iov_base = bufs[i];
+            iovs[i].iov_len = ICCP_NDISC_PACKET_SIZE;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_name = &from[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = adata[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(adata[i]);
+        }
+
+        n = recvmmsg(sys->ndisc_receive_fd, msgs, ICCP_PACKET_BATCH_SIZE, MSG_DONTWAIT, NULL);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+
+            ICCPD_LOG_DEBUG(__FUNCTION__, "ndisc recvmmsg error, errno %d", errno);
+            return MCLAG_ERROR;
+        }
+
+        if (n == 0)
+            break;
+
+        total += n;
+        sys->dbg_counters.ndisc_rx_packet_counter += n;
+
+        if (csm)
+        {
+            for (i = 0; i < n; i++)
+                iccp_handle_ndisc_packet(bufs[i], msgs[i].msg_len, &msgs[i].msg_hdr);
+        }
+
+        if (n < ICCP_PACKET_BATCH_SIZE)
+            break;
+    }
+
+    if (total >= ICCP_PACKET_RX_BUDGET)
+        ++sys->dbg_counters.packet_rx_budget_counter;
 
     return 0;
 }
 
+/* Reconcile with the kernel after events were lost, only links whose
+ * attributes changed and PortChannels whose members matter are handled */
 void iccp_netlink_sync_again()
 {
     struct System* sys = NULL;
     struct LocalInterface* lif = NULL;
+    struct timespec start, end;
+    uint32_t usec;
+    uint32_t link_count, skip_count, del_count, team_count;
 
     if ((sys = system_get_instance()) == NULL )
         return;
 
+    if (!sys->need_sync_netlink_again && !sys->need_sync_team_again)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    /* The counters are cumulative, log what this re-sync did */
+    link_count = sys->dbg_counters.netlink_resync_link_counter;
+    skip_count = sys->dbg_counters.netlink_resync_skip_counter;
+    del_count = sys->dbg_counters.netlink_resync_del_counter;
+    team_count = sys->dbg_counters.netlink_resync_team_counter;
+    ++sys->dbg_counters.netlink_resync_counter;
+
     if (sys->need_sync_netlink_again)
     {
         sys->need_sync_netlink_again = 0;
 
         /*Get kernel interface and port */
-        iccp_sys_local_if_list_get_init();
+        iccp_sys_local_if_list_resync();
     }
 
     if (sys->need_sync_team_again)
     {
         sys->need_sync_team_again = 0;
 
+        /* Member lists are only used for MLAG PortChannels and peer-link */
         LIST_FOREACH(lif, &(sys->lif_list), system_next)
         {
-            if (lif->type == IF_T_PORT_CHANNEL)
+            if (lif->type == IF_T_PORT_CHANNEL && (lif->csm || lif->is_peer_link))
             {
-                iccp_get_port_member_list(lif);
+                ++sys->dbg_counters.netlink_resync_team_counter;
+                iccp_get_port_member_list_async(lif);
             }
         }
     }
 
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    usec = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+    sys->dbg_counters.netlink_resync_last_usec = usec;
+    if (usec > sys->dbg_counters.netlink_resync_max_usec)
+        sys->dbg_counters.netlink_resync_max_usec = usec;
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "Kernel re-sync done in %u usec, links handled %u, skipped %u, deleted %u, "
+        "PortChannel member queries %u (total re-syncs %u, overruns %u)", usec,
+        sys->dbg_counters.netlink_resync_link_counter - link_count,
+        sys->dbg_counters.netlink_resync_skip_counter - skip_count,
+        sys->dbg_counters.netlink_resync_del_counter - del_count,
+        sys->dbg_counters.netlink_resync_team_counter - team_count,
+        sys->dbg_counters.netlink_resync_counter, sys->dbg_counters.netlink_overrun_counter);
+
     return;
 }
 
@@ -2065,6 +2712,8 @@ static int iccp_netlink_route_sock_event_handler(struct System *sys)
     if (ret)
     {
         sys->need_sync_netlink_again = 1;
+        if (ret == -NLE_NOMEM)
+            ++sys->dbg_counters.netlink_overrun_counter;
         ICCPD_LOG_NOTICE(__FUNCTION__, "fd %d recvmsg error ret = %d  errno = %d ", nl_socket_get_fd(sys->route_event_sock), ret, errno);
         SYSTEM_INCR_NETLINK_RX_ERROR();
     }
@@ -2077,6 +2726,35 @@ static int iccp_netlink_route_sock_event_handler(struct System *sys)
     return ret;
 }
 
+static int iccp_get_netlink_genic_sock_fd(struct System *sys)
+{
+    return nl_socket_get_fd(sys->genric_sock);
+}
+
+static int iccp_netlink_genic_sock_handler(struct System *sys)
+{
+    /* Stale messages are skipped by the sequence number check */
+    if (iccp_team_query_cb_init(sys))
+        return MCLAG_ERROR;
+
+    return (iccp_team_query_recv(sys, 0) < 0) ? MCLAG_ERROR : 0;
+}
+
+static int iccp_get_netlink_neigh_batch_sock_fd(struct System *sys)
+{
+    return sys->neigh_batch_sock ? nl_socket_get_fd(sys->neigh_batch_sock) : -1;
+}
+
+static int iccp_netlink_neigh_batch_sock_handler(struct System *sys)
+{
+    int ret;
+
+    ret = iccp_netlink_neigh_batch_recv(sys);
+    iccp_netlink_neigh_add_failures_handle();
+
+    return ret;
+}
+
 extern int iccp_get_receive_fdb_sock_fd(struct System *sys);
 
 /* cond HIDDEN_SYMBOLS */
@@ -2088,6 +2766,10 @@ struct iccp_eventfd
 /* endcond */
 
 static const struct iccp_eventfd iccp_eventfds[] = {
+    {
+        .get_fd = scheduler_get_timer_fd,
+        .event_handler = scheduler_timer_handler,
+    },
     {
         .get_fd = iccp_get_server_sock_fd,
         .event_handler = scheduler_server_accept,
@@ -2107,6 +2789,14 @@ static const struct iccp_eventfd iccp_eventfds[] = {
     {
      .get_fd = iccp_get_receive_ndisc_packet_sock_fd,
      .event_handler = iccp_receive_ndisc_packet_handler,
+    },
+    {
+        .get_fd = iccp_get_netlink_genic_sock_fd,
+        .event_handler = iccp_netlink_genic_sock_handler,
+    },
+    {
+        .get_fd = iccp_get_netlink_neigh_batch_sock_fd,
+        .event_handler = iccp_netlink_neigh_batch_sock_handler,
     }
 };
 
@@ -2138,6 +2828,11 @@ int iccp_init_netlink_event_fd(struct System *sys)
     {
         int fd = iccp_eventfds[i].get_fd(sys);
 
+        /* timer fd and neighbor batch sock are optional */
+        if (fd < 0 && (iccp_eventfds[i].get_fd == scheduler_get_timer_fd
+                       || iccp_eventfds[i].get_fd == iccp_get_netlink_neigh_batch_sock_fd))
+            continue;
+
         event.data.fd = fd;
         event.events = EPOLLIN;
         err = epoll_ctl(efd, EPOLL_CTL_ADD, fd, &event);
@@ -2174,15 +2869,66 @@ int iccp_handle_events(struct System * sys)
     int i;
     int err;
     int max_nfds;
+    int timeout;
     struct mLACPHeartbeatTLV dummy_tlv; 
 
     max_nfds = ICCP_EVENT_FDS_COUNT + sys->readfd_count;
 
-    nfds = epoll_wait(sys->epoll_fd, events, max_nfds, EPOLL_TIMEOUT_MSEC);
+    /* Timers wake up the loop when there is timer fd, don't block if any
+     * session FSM has pending work */
+    if (scheduler_csm_dirty_pending())
+        timeout = 0;
+    else if (sys->timer_fd >= 0)
+        timeout = -1;
+    else
+        timeout = EPOLL_TIMEOUT_MSEC;
+
+    /* Neighbor requests queued since the last wait go out in one batch */
+    iccp_netlink_neigh_batch_flush();
+    iccp_netlink_neigh_add_failures_handle();
+
+    nfds = epoll_wait(sys->epoll_fd, events, max_nfds, timeout);
+
+    /* Entries queued for the peer while handling these events count
+     * their learn latency from this wakeup */
+    sys->latency_event_usec = nfds > 0 ? system_get_usec() : 0;
+
+    /* Peer sessions go first, their reads refresh the peer heartbeat
+     * and must not wait behind a burst of local events */
+    for (i = 0; i < nfds; i++)
+    {
+        if (!FD_ISSET(events[i].data.fd, &sys->readfd))
+            continue;
+
+        LIST_FOREACH(csm, &(sys->csm_list), next)
+        {
+            if (csm->sock_fd == events[i].data.fd )
+            {
+                scheduler_csm_set_dirty(csm);
+                if (scheduler_csm_read_callback(csm) != MCLAG_ERROR)
+                {
+                    //consider any msg from peer as heartbeat update, this will be in scenarios of scaled msg sync b/w peers 
+                    mlacp_fsm_update_heartbeat(csm, &dummy_tlv);
+                }
+                events[i].data.fd = -1;
+                break;
+            }
+        }
+    }
 
     /* Go over list of event fds and handle them sequentially */
     for (i = 0; i < nfds; i++)
     {
+        if (events[i].data.fd < 0)
+            continue;
+
+        /* Our heartbeats go out between handlers, not after the batch */
+        scheduler_heartbeat_service();
+
+        /* Session sockets only affect their own CSM, timers mark theirs */
+        if (events[i].data.fd != sys->timer_fd && !FD_ISSET(events[i].data.fd, &sys->readfd))
+            scheduler_csm_set_dirty_all();
+
         for (n = 0; n < ICCP_EVENT_FDS_COUNT; n++)
         {
             const struct iccp_eventfd *eventfd = &iccp_eventfds[n];
@@ -2202,16 +2948,19 @@ int iccp_handle_events(struct System * sys)
         {
             int client_fd = mclagd_ctl_sock_accept(sys->sync_ctrl_fd);
             if (client_fd > 0)
-            {
-                mclagd_ctl_interactive_process(client_fd);
-                close(client_fd);
-            }
+                mclagd_ctl_client_add(client_fd);
             continue;
         }
 
+        if (mclagd_ctl_client_handler(events[i].data.fd, events[i].events))
+            continue;
+
         if (events[i].data.fd == sys->sync_fd)
         {
-            iccp_mclagsyncd_msg_handler(sys);
+            if (events[i].events & EPOLLOUT)
+                iccp_syncd_tx_queue_drain();
+            if (events[i].events & ~EPOLLOUT)
+                iccp_mclagsyncd_msg_handler(sys);
             continue;
         }
 
@@ -2222,22 +2971,16 @@ int iccp_handle_events(struct System * sys)
             continue;
         }
 
-        if (FD_ISSET(events[i].data.fd, &sys->readfd))
+        LIST_FOREACH(csm, &(sys->csm_list), next)
         {
-            LIST_FOREACH(csm, &(sys->csm_list), next)
+            if (csm->conn_fd >= 0 && csm->conn_fd == events[i].data.fd)
             {
-                if (csm->sock_fd == events[i].data.fd )
-                {
-                    if (scheduler_csm_read_callback(csm) != MCLAG_ERROR)
-                    {
-                        //consider any msg from peer as heartbeat update, this will be in scenarios of scaled msg sync b/w peers 
-                        mlacp_fsm_update_heartbeat(csm, &dummy_tlv);
-                    }
-                    break;
-                }
+                scheduler_csm_connect_callback(csm);
+                break;
             }
         }
     }
+    sys->latency_event_usec = 0;
 
     return 0;
 }
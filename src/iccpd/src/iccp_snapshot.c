@@ -0,0 +1,486 @@
+/*
+ * iccp_snapshot.c
+ *
+ * Copyright(c) 2016-2019 Nephos/Estinet.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ *
+ *  Maintainer: jianjun, grace Li from nephos
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include <netlink/netlink.h>
+#include <netlink/route/neighbour.h>
+#include <linux/neighbour.h>
+
+#include "../include/system.h"
+#include "../include/logger.h"
+#include "../include/port.h"
+#include "../include/iccp_csm.h"
+#include "../include/mlacp_tlv.h"
+#include "../include/mlacp_sync_update.h"
+#include "../include/iccp_snapshot.h"
+
+/* ARP/ND tables of each MC-LAG domain and their peer sync state are
+ * written on a warm exit and restored when the domain is configured
+ * again. Entries missing from the kernel or learned again are dropped,
+ * and then a full sync with the peer follows. Otherwise the sync
+ * digests still match the peer's, so only the entries changed meanwhile
+ * are exchanged. Host byte order, the file is only read back on the
+ * same host */
+#define ICCP_SNAPSHOT_MAGIC         0x49435053
+#define ICCP_SNAPSHOT_VERSION       1
+#define ICCP_SNAPSHOT_MAX_AGE_SEC   900
+
+struct iccp_snapshot_hdr
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t domain_count;
+    uint64_t save_time;
+    uint32_t body_len;
+    uint32_t checksum;
+};
+
+struct iccp_snapshot_domain
+{
+    uint16_t mlag_id;
+    uint32_t sync_gen;
+    struct mLACPSyncDigest arp_digest;
+    struct mLACPSyncDigest ndisc_digest;
+    uint32_t arp_count;
+    uint32_t ndisc_count;
+};
+
+struct iccp_snapshot_arp
+{
+    struct ARPMsg arp_msg;
+    uint32_t sync_digest;
+};
+
+struct iccp_snapshot_ndisc
+{
+    struct NDISCMsg ndisc_msg;
+    uint32_t sync_digest;
+};
+
+/* Body of the loaded snapshot, kept until all its domains are restored */
+static char *snapshot_body = NULL;
+static uint16_t snapshot_domain_count = 0;
+
+static uint32_t iccp_snapshot_checksum(const char *buf, uint32_t len)
+{
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ (uint8_t)buf[i]) * 16777619u;
+
+    return hash;
+}
+
+static size_t iccp_snapshot_domain_len(const struct iccp_snapshot_domain *domain)
+{
+    return sizeof(struct iccp_snapshot_domain)
+           + (size_t)domain->arp_count * sizeof(struct iccp_snapshot_arp)
+           + (size_t)domain->ndisc_count * sizeof(struct iccp_snapshot_ndisc);
+}
+
+static int iccp_snapshot_write(const char *path, struct iccp_snapshot_hdr *hdr, const char *body)
+{
+    char tmp_path[PATH_MAX];
+    char dir[PATH_MAX];
+    char *slash = NULL;
+    FILE *fp = NULL;
+    int ok;
+
+    snprintf(dir, sizeof(dir), "%s", path);
+    slash = strrchr(dir, '/');
+    if (slash && slash != dir)
+    {
+        *slash = '\0';
+        if (mkdir(dir, 0755) < 0 && errno != EEXIST)
+        {
+            ICCPD_LOG_ERR(__FUNCTION__, "Failed to create directory %s, errno %d", dir, errno);
+            return MCLAG_ERROR;
+        }
+    }
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    fp = fopen(tmp_path, "w");
+    if (!fp)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to open %s, errno %d", tmp_path, errno);
+        return MCLAG_ERROR;
+    }
+
+    ok = (fwrite(hdr, sizeof(*hdr), 1, fp) == 1
+          && (hdr->body_len == 0 || fwrite(body, hdr->body_len, 1, fp) == 1)
+          && fflush(fp) == 0
+          && fsync(fileno(fp)) == 0);
+    if (fclose(fp) != 0)
+        ok = 0;
+
+    /* A reader sees either the previous file or the complete new one */
+    if (!ok || rename(tmp_path, path) < 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to write %s, errno %d", path, errno);
+        unlink(tmp_path);
+        return MCLAG_ERROR;
+    }
+
+    return 0;
+}
+
+/* Called on warm exit, before the tables are released */
+int iccp_snapshot_save(struct System* sys)
+{
+    struct CSM* csm = NULL;
+    struct Msg* msg = NULL;
+    struct iccp_snapshot_hdr hdr;
+    struct iccp_snapshot_domain domain;
+    struct iccp_snapshot_arp arp;
+    struct iccp_snapshot_ndisc ndisc;
+    char *body = NULL;
+    size_t len = 0;
+    size_t offset = 0;
+    size_t domain_offset;
+    uint32_t arp_total = 0, ndisc_total = 0;
+    int ret;
+
+    if (!sys->snapshot_file_path)
+        return MCLAG_ERROR;
+
+    memset(&hdr, 0, sizeof(hdr));
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+    {
+        len += sizeof(struct iccp_snapshot_domain);
+        TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+            len += sizeof(struct iccp_snapshot_arp);
+        TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_list), tail)
+            len += sizeof(struct iccp_snapshot_ndisc);
+        ++hdr.domain_count;
+    }
+
+    if (len > UINT32_MAX)
+        return MCLAG_ERROR;
+
+    if (len > 0)
+    {
+        body = (char*)malloc(len);
+        if (!body)
+        {
+            ICCPD_LOG_ERR(__FUNCTION__, "Failed to allocate %zu bytes", len);
+            return MCLAG_ERROR;
+        }
+    }
+
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+    {
+        memset(&domain, 0, sizeof(domain));
+        domain.mlag_id = csm->mlag_id;
+        domain.sync_gen = MLACP(csm).sync_gen;
+        domain.arp_digest = MLACP(csm).arp_digest;
+        domain.ndisc_digest = MLACP(csm).ndisc_digest;
+        domain_offset = offset;
+        offset += sizeof(domain);
+
+        TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+        {
+            memcpy(&arp.arp_msg, msg->buf, sizeof(struct ARPMsg));
+            arp.sync_digest = msg->sync_digest;
+            memcpy(body + offset, &arp, sizeof(arp));
+            offset += sizeof(arp);
+            ++domain.arp_count;
+        }
+
+        TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_list), tail)
+        {
+            memcpy(&ndisc.ndisc_msg, msg->buf, sizeof(struct NDISCMsg));
+            ndisc.sync_digest = msg->sync_digest;
+            memcpy(body + offset, &ndisc, sizeof(ndisc));
+            offset += sizeof(ndisc);
+            ++domain.ndisc_count;
+        }
+
+        memcpy(body + domain_offset, &domain, sizeof(domain));
+        arp_total += domain.arp_count;
+        ndisc_total += domain.ndisc_count;
+    }
+
+    hdr.magic = ICCP_SNAPSHOT_MAGIC;
+    hdr.version = ICCP_SNAPSHOT_VERSION;
+    hdr.save_time = time(NULL);
+    hdr.body_len = len;
+    hdr.checksum = iccp_snapshot_checksum(body, len);
+
+    ret = iccp_snapshot_write(sys->snapshot_file_path, &hdr, body);
+    free(body);
+
+    if (ret == 0)
+        ICCPD_LOG_NOTICE(__FUNCTION__, "Saved %u domains, %u ARP and %u ND entries to %s",
+                         hdr.domain_count, arp_total, ndisc_total, sys->snapshot_file_path);
+
+    return ret;
+}
+
+/* Called at startup, the snapshot is held until its domains are
+ * configured. The file is removed so that it is never used twice */
+int iccp_snapshot_load(struct System* sys)
+{
+    struct iccp_snapshot_hdr hdr;
+    struct iccp_snapshot_domain domain;
+    FILE *fp = NULL;
+    char *body = NULL;
+    size_t offset = 0;
+    time_t now;
+    int i;
+
+    if (!sys->snapshot_file_path)
+        return MCLAG_ERROR;
+
+    fp = fopen(sys->snapshot_file_path, "r");
+    if (!fp)
+        return 0;
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1
+        || hdr.magic != ICCP_SNAPSHOT_MAGIC
+        || hdr.version != ICCP_SNAPSHOT_VERSION)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Ignore invalid snapshot %s", sys->snapshot_file_path);
+        goto err_close;
+    }
+
+    now = time(NULL);
+    if (hdr.save_time > (uint64_t)now || (uint64_t)now - hdr.save_time > ICCP_SNAPSHOT_MAX_AGE_SEC)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Ignore snapshot saved %lld sec ago",
+                       (long long)now - (long long)hdr.save_time);
+        goto err_close;
+    }
+
+    if (hdr.body_len > 0)
+    {
+        body = (char*)malloc(hdr.body_len);
+        if (!body || fread(body, hdr.body_len, 1, fp) != 1
+            || iccp_snapshot_checksum(body, hdr.body_len) != hdr.checksum)
+        {
+            ICCPD_LOG_WARN(__FUNCTION__, "Ignore truncated or corrupted snapshot %s", sys->snapshot_file_path);
+            goto err_close;
+        }
+    }
+
+    /* Domains must tile the body exactly */
+    for (i = 0; i < hdr.domain_count; i++)
+    {
+        if (hdr.body_len - offset < sizeof(domain))
+            break;
+        memcpy(&domain, body + offset, sizeof(domain));
+        if (hdr.body_len - offset < iccp_snapshot_domain_len(&domain))
+            break;
+        offset += iccp_snapshot_domain_len(&domain);
+    }
+
+    if (i != hdr.domain_count || offset != hdr.body_len)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Ignore malformed snapshot %s", sys->snapshot_file_path);
+        goto err_close;
+    }
+
+    fclose(fp);
+    unlink(sys->snapshot_file_path);
+
+    iccp_snapshot_discard();
+    snapshot_body = body;
+    snapshot_domain_count = hdr.domain_count;
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "Loaded snapshot of %u domains saved %lld sec ago",
+                     hdr.domain_count, (long long)now - (long long)hdr.save_time);
+
+    return 0;
+
+err_close:
+    free(body);
+    fclose(fp);
+    unlink(sys->snapshot_file_path);
+
+    return MCLAG_ERROR;
+}
+
+/* The entry must still be in the kernel with the same MAC */
+static int iccp_snapshot_neigh_in_kernel(struct nl_cache *cache, int family, void *addr, size_t addr_len,
+                                         const char *ifname, const uint8_t *mac_addr)
+{
+    struct LocalInterface *lif = NULL;
+    struct rtnl_neigh *neigh = NULL;
+    struct nl_addr *dst = NULL;
+    struct nl_addr *lladdr = NULL;
+    int found = 0;
+
+    lif = local_if_find_by_name(ifname);
+    if (!lif)
+        return 0;
+
+    dst = nl_addr_build(family, addr, addr_len);
+    if (!dst)
+        return 0;
+
+    neigh = rtnl_neigh_get(cache, lif->ifindex, dst);
+    nl_addr_put(dst);
+    if (!neigh)
+        return 0;
+
+    lladdr = rtnl_neigh_get_lladdr(neigh);
+    if (lladdr && nl_addr_get_len(lladdr) == ETHER_ADDR_LEN
+        && memcmp(nl_addr_get_binary_addr(lladdr), mac_addr, ETHER_ADDR_LEN) == 0
+        && !(rtnl_neigh_get_state(neigh) & (NUD_INCOMPLETE | NUD_FAILED)))
+        found = 1;
+
+    rtnl_neigh_put(neigh);
+
+    return found;
+}
+
+/* Restore the tables of a newly configured domain */
+void iccp_snapshot_restore(struct CSM* csm)
+{
+    struct System* sys = NULL;
+    struct iccp_snapshot_domain domain;
+    struct iccp_snapshot_arp arp;
+    struct iccp_snapshot_ndisc ndisc;
+    struct nl_cache *cache = NULL;
+    struct Msg* msg = NULL;
+    size_t offset = 0;
+    size_t domain_offset = 0;
+    uint32_t restored = 0, dropped = 0;
+    uint32_t i;
+    int d;
+
+    if (!snapshot_body || !(sys = system_get_instance()))
+        return;
+
+    for (d = 0; d < snapshot_domain_count; d++)
+    {
+        memcpy(&domain, snapshot_body + offset, sizeof(domain));
+        if (domain.mlag_id != 0 && domain.mlag_id == csm->mlag_id)
+            break;
+        offset += iccp_snapshot_domain_len(&domain);
+    }
+
+    if (d == snapshot_domain_count)
+        return;
+
+    /* Restore a domain only once */
+    domain_offset = offset;
+    domain.mlag_id = 0;
+    memcpy(snapshot_body + domain_offset, &domain, sizeof(domain));
+    offset += sizeof(domain);
+
+    if (rtnl_neigh_alloc_cache(sys->route_sock, &cache) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to dump kernel neighbors, snapshot of domain %d not used", csm->mlag_id);
+        return;
+    }
+
+    for (i = 0; i < domain.arp_count; i++, offset += sizeof(arp))
+    {
+        memcpy(&arp, snapshot_body + offset, sizeof(arp));
+        arp.arp_msg.ifname[MAX_L_PORT_NAME - 1] = '\0';
+
+        /* Learned again already, its sync state is unknown */
+        if (mlacp_arp_find(csm, arp.arp_msg.ipv4_addr))
+        {
+            ++dropped;
+            continue;
+        }
+
+        if (!iccp_snapshot_neigh_in_kernel(cache, AF_INET, &arp.arp_msg.ipv4_addr, sizeof(arp.arp_msg.ipv4_addr),
+                                           arp.arp_msg.ifname, arp.arp_msg.mac_addr))
+        {
+            ++dropped;
+            continue;
+        }
+
+        if (iccp_csm_init_msg(&msg, (char*)&arp.arp_msg, sizeof(struct ARPMsg)) == 0)
+        {
+            mlacp_enqueue_arp(csm, msg);
+            msg->sync_digest = arp.sync_digest;
+            ++restored;
+        }
+    }
+
+    for (i = 0; i < domain.ndisc_count; i++, offset += sizeof(ndisc))
+    {
+        memcpy(&ndisc, snapshot_body + offset, sizeof(ndisc));
+        ndisc.ndisc_msg.ifname[MAX_L_PORT_NAME - 1] = '\0';
+
+        if (mlacp_ndisc_find(csm, ndisc.ndisc_msg.ipv6_addr))
+        {
+            ++dropped;
+            continue;
+        }
+
+        if (!iccp_snapshot_neigh_in_kernel(cache, AF_INET6, ndisc.ndisc_msg.ipv6_addr, sizeof(ndisc.ndisc_msg.ipv6_addr),
+                                           ndisc.ndisc_msg.ifname, ndisc.ndisc_msg.mac_addr))
+        {
+            ++dropped;
+            continue;
+        }
+
+        if (iccp_csm_init_msg(&msg, (char*)&ndisc.ndisc_msg, sizeof(struct NDISCMsg)) == 0)
+        {
+            mlacp_enqueue_ndisc(csm, msg);
+            msg->sync_digest = ndisc.sync_digest;
+            ++restored;
+        }
+    }
+
+    nl_cache_free(cache);
+
+    /* The peer still holds what was last exchanged, unless entries were
+     * dropped */
+    if (dropped == 0)
+    {
+        MLACP(csm).sync_gen = domain.sync_gen;
+        MLACP(csm).arp_digest = domain.arp_digest;
+        MLACP(csm).ndisc_digest = domain.ndisc_digest;
+    }
+    else
+    {
+        mlacp_neigh_sync_reset(csm);
+    }
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "Restored %u ARP/ND entries of domain %d, %u dropped, %s sync with peer",
+                     restored, csm->mlag_id, dropped, dropped ? "full" : "incremental");
+
+    return;
+}
+
+/* Release the loaded snapshot */
+void iccp_snapshot_discard()
+{
+    free(snapshot_body);
+    snapshot_body = NULL;
+    snapshot_domain_count = 0;
+}
@@ -22,8 +22,14 @@
  */
 #include <stdio.h>
 #include <stdarg.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #include "../include/cmd_option.h"
 #include "../include/logger.h"
@@ -38,6 +44,32 @@ static uint32_t _iccpd_log_level_map[] =
     LOG_DEBUG
 };
 
+/* Formatted message waiting for the log thread */
+struct LogRecord
+{
+    int priority;
+    char buf[LOGBUF_SIZE];
+};
+
+/* Single producer (scheduler thread) single consumer (log thread) ring,
+ * head and tail only grow and are masked when indexing */
+static struct LogRecord log_ring[LOG_RING_SLOTS];
+static uint32_t log_ring_head = 0;
+static uint32_t log_ring_tail = 0;
+static uint32_t log_ring_dropped = 0;
+
+static pthread_t log_thread;
+static pthread_t log_producer;
+static int log_thread_running = 0;
+static int log_thread_stop = 0;
+static int log_thread_waiting = 0;
+static int log_wakeup_fd = -1;
+
+/* Call sites that suppressed messages, only ever grows since call site
+ * state is static */
+static struct LogRateLimit* log_rate_limits = NULL;
+static pthread_mutex_t log_rate_limits_lock = PTHREAD_MUTEX_INITIALIZER;
+
 char* log_level_to_string(int level)
 {
     switch (level)
@@ -88,41 +120,193 @@ void logger_set_configuration(int log_level)
     return;
 }
 
+/* Report the messages suppressed by call sites whose interval is over,
+ * or by all call sites if force is set */
+static void log_flush_suppressed(int force)
+{
+    struct LogRateLimit* rate_limit = NULL;
+    time_t now = time(NULL);
+    uint32_t suppressed;
+
+    pthread_mutex_lock(&log_rate_limits_lock);
+    for (rate_limit = log_rate_limits; rate_limit; rate_limit = rate_limit->next)
+    {
+        if (!force && now - __atomic_load_n(&rate_limit->interval_start, __ATOMIC_ACQUIRE) < LOG_RATE_LIMIT_INTERVAL_SEC)
+            continue;
+
+        suppressed = __atomic_exchange_n(&rate_limit->suppressed, 0, __ATOMIC_SEQ_CST);
+        if (suppressed)
+            ICCPD_UTILS_SYSLOG(_iccpd_log_level_map[rate_limit->level], "[%s.%s] suppressed %u messages",
+                               rate_limit->tag, log_level_to_string(rate_limit->level), suppressed);
+    }
+    pthread_mutex_unlock(&log_rate_limits_lock);
+}
+
+static void *log_thread_main(void *arg)
+{
+    struct LogRecord* record = NULL;
+    struct pollfd pfd;
+    time_t last_flush = time(NULL);
+    time_t now;
+    uint32_t tail;
+    uint64_t wakeup;
+    int timeout;
+    int rv;
+
+    pfd.fd = log_wakeup_fd;
+    pfd.events = POLLIN;
+
+    while (1)
+    {
+        tail = log_ring_tail;
+        if (tail == __atomic_load_n(&log_ring_head, __ATOMIC_ACQUIRE))
+        {
+            if (__atomic_load_n(&log_thread_stop, __ATOMIC_ACQUIRE))
+            {
+                log_flush_suppressed(1);
+                break;
+            }
+
+            now = time(NULL);
+            if (now - last_flush >= LOG_RATE_LIMIT_INTERVAL_SEC)
+            {
+                log_flush_suppressed(0);
+                last_flush = now;
+            }
+
+            /* Wake up once per interval to report suppressed messages */
+            timeout = __atomic_load_n(&log_rate_limits, __ATOMIC_ACQUIRE) ? LOG_RATE_LIMIT_INTERVAL_SEC * 1000 : -1;
+
+            /* Producer wakes us up only when it sees the flag */
+            __atomic_store_n(&log_thread_waiting, 1, __ATOMIC_SEQ_CST);
+            if (tail == __atomic_load_n(&log_ring_head, __ATOMIC_SEQ_CST)
+                && !__atomic_load_n(&log_thread_stop, __ATOMIC_SEQ_CST))
+            {
+                rv = poll(&pfd, 1, timeout);
+                if (rv > 0)
+                {
+                    if (read(log_wakeup_fd, &wakeup, sizeof(wakeup)) < 0 && errno != EINTR && errno != EAGAIN)
+                        usleep(LOG_WAKEUP_RETRY_USEC);
+                }
+                /* EINTR just rechecks the ring, on any other error poll the ring instead of spinning */
+                else if (rv < 0 && errno != EINTR)
+                {
+                    usleep(LOG_WAKEUP_RETRY_USEC);
+                }
+            }
+            __atomic_store_n(&log_thread_waiting, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        record = &log_ring[tail % LOG_RING_SLOTS];
+        ICCPD_UTILS_SYSLOG(record->priority, "%s", record->buf);
+        __atomic_store_n(&log_ring_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    return NULL;
+}
+
+static void log_thread_wakeup()
+{
+    uint64_t wakeup = 1;
+
+    if (write(log_wakeup_fd, &wakeup, sizeof(wakeup)) < 0)
+        return;
+}
+
 void log_init(struct CmdOptionParser* parser)
 {
     struct LoggerConfig* config = logger_get_configuration();
 
     config->console_log_enabled = parser->console_log;
+
+    if (log_thread_running)
+        return;
+
+    log_wakeup_fd = eventfd(0, EFD_CLOEXEC);
+    if (log_wakeup_fd < 0)
+        return;
+
+    log_thread_stop = 0;
+    log_producer = pthread_self();
+    if (pthread_create(&log_thread, NULL, log_thread_main, NULL) != 0)
+    {
+        close(log_wakeup_fd);
+        log_wakeup_fd = -1;
+        return;
+    }
+    log_thread_running = 1;
+
+    /* Don't lose queued messages on exit() */
+    atexit(log_finalize);
 }
 
+/* Stop the log thread once the queued messages are written, later
+ * messages are sent to syslog directly */
 void log_finalize()
 {
-    /*do nothing*/
+    if (!log_thread_running)
+    {
+        log_flush_suppressed(1);
+        return;
+    }
+
+    __atomic_store_n(&log_thread_stop, 1, __ATOMIC_SEQ_CST);
+    log_thread_wakeup();
+    pthread_join(log_thread, NULL);
+    log_thread_running = 0;
+
+    close(log_wakeup_fd);
+    log_wakeup_fd = -1;
 }
 
-void write_log(int level, const char* tag, const char* format, ...)
+/* Format a message in the next free ring slot, or send it to syslog
+ * directly when there is no log thread or it is not the scheduler thread */
+static void log_vemit(int level, const char* tag, const char* format, va_list args)
 {
-    struct LoggerConfig* config = logger_get_configuration();
-    char buf[LOGBUF_SIZE];
-    va_list args;
+    char local_buf[LOGBUF_SIZE];
+    char* buf = local_buf;
+    struct LogRecord* record = NULL;
+    uint32_t head = 0;
+    uint32_t used;
     unsigned int   prefix_len;
     unsigned int   avbl_buf_len;
     unsigned int   print_len;
+    int queued = 0;
 
-#if 0
-    if (!config->console_log_enabled)
-        return;
-#endif
+    if (log_thread_running && pthread_equal(pthread_self(), log_producer))
+    {
+        head = log_ring_head;
+        used = head - __atomic_load_n(&log_ring_tail, __ATOMIC_ACQUIRE);
 
-    if (level > config->log_level)
-        return;
+        /* Report messages dropped on a full ring first */
+        if (log_ring_dropped && used + 1 < LOG_RING_SLOTS)
+        {
+            record = &log_ring[head % LOG_RING_SLOTS];
+            record->priority = LOG_WARNING;
+            snprintf(record->buf, LOGBUF_SIZE, "[logger.WARN] log ring full, dropped %u messages", log_ring_dropped);
+            log_ring_dropped = 0;
+            ++head;
+            ++used;
+        }
+
+        if (used >= LOG_RING_SLOTS)
+        {
+            ++log_ring_dropped;
+            __atomic_store_n(&log_ring_head, head, __ATOMIC_SEQ_CST);
+            return;
+        }
+
+        record = &log_ring[head % LOG_RING_SLOTS];
+        record->priority = _iccpd_log_level_map[level];
+        buf = record->buf;
+        queued = 1;
+    }
 
     prefix_len = snprintf(buf, LOGBUF_SIZE, "[%s.%s] ", tag, log_level_to_string(level));
     avbl_buf_len = LOGBUF_SIZE - prefix_len;
 
-    va_start(args, format);
     print_len = vsnprintf(buf + prefix_len, avbl_buf_len, format, args);
-    va_end(args);
 
     /* Since osal_vsnprintf doesn't always return the exact size written to the buffer,
      * we must check if the user string length exceeds the remaing buffer size.
@@ -133,8 +317,85 @@ void write_log(int level, const char* tag, const char* format, ...)
     }
 
     buf[prefix_len + print_len] = '\0';
-    ICCPD_UTILS_SYSLOG(_iccpd_log_level_map[level], "%s", buf);
+
+    if (!queued)
+    {
+        ICCPD_UTILS_SYSLOG(_iccpd_log_level_map[level], "%s", buf);
+        return;
+    }
+
+    __atomic_store_n(&log_ring_head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&log_thread_waiting, __ATOMIC_SEQ_CST))
+        log_thread_wakeup();
+}
+
+void write_log(int level, const char* tag, const char* format, ...)
+{
+    struct LoggerConfig* config = logger_get_configuration();
+    va_list args;
+
+#if 0
+    if (!config->console_log_enabled)
+        return;
+#endif
+
+    if (level > config->log_level)
+        return;
+
+    va_start(args, format);
+    log_vemit(level, tag, format, args);
+    va_end(args);
 
     return;
 }
 
+/* write_log limited to LOG_RATE_LIMIT_BURST messages per interval, the
+ * number of suppressed messages is reported when the call site logs
+ * again in a later interval, or by the log thread once the interval is
+ * over. Errors and critical messages are never suppressed */
+void write_log_ratelimit(struct LogRateLimit* rate_limit, int level, const char* tag, const char* format, ...)
+{
+    struct LoggerConfig* config = logger_get_configuration();
+    uint32_t suppressed;
+    time_t now;
+    va_list args;
+
+    if (level > config->log_level)
+        return;
+
+    if (level > ERR_LOG_LEVEL)
+    {
+        now = time(NULL);
+        if (now - rate_limit->interval_start >= LOG_RATE_LIMIT_INTERVAL_SEC)
+        {
+            /* The log thread may have reported them already */
+            suppressed = __atomic_exchange_n(&rate_limit->suppressed, 0, __ATOMIC_SEQ_CST);
+            if (suppressed)
+                write_log(level, tag, "suppressed %u messages", suppressed);
+            __atomic_store_n(&rate_limit->interval_start, now, __ATOMIC_RELEASE);
+            rate_limit->count = 0;
+        }
+
+        if (rate_limit->count >= LOG_RATE_LIMIT_BURST)
+        {
+            if (!rate_limit->tag)
+            {
+                rate_limit->level = level;
+                rate_limit->tag = tag;
+                pthread_mutex_lock(&log_rate_limits_lock);
+                rate_limit->next = log_rate_limits;
+                __atomic_store_n(&log_rate_limits, rate_limit, __ATOMIC_RELEASE);
+                pthread_mutex_unlock(&log_rate_limits_lock);
+            }
+            __atomic_add_fetch(&rate_limit->suppressed, 1, __ATOMIC_SEQ_CST);
+            return;
+        }
+    }
+    ++rate_limit->count;
+
+    va_start(args, format);
+    log_vemit(level, tag, format, args);
+    va_end(args);
+
+    return;
+}
@@ -82,6 +82,7 @@ static struct command_type command_types[] =
         .parent_id = ID_CMDTYPE_D,
         .info_type = INFO_TYPE_DUMP_ARP,
         .name = "arp",
+        .params = { "[ifname]" },
         .enca_msg = mclagdctl_enca_dump_arp,
         .parse_msg = mclagdctl_parse_dump_arp,
     },
@@ -90,6 +91,7 @@ static struct command_type command_types[] =
          .parent_id = ID_CMDTYPE_D,
          .info_type = INFO_TYPE_DUMP_NDISC,
          .name = "nd",
+         .params = { "[ifname]" },
          .enca_msg = mclagdctl_enca_dump_ndisc,
          .parse_msg = mclagdctl_parse_dump_ndisc,
      },
@@ -98,6 +100,7 @@ static struct command_type command_types[] =
         .parent_id = ID_CMDTYPE_D,
         .info_type = INFO_TYPE_DUMP_MAC,
         .name = "mac",
+        .params = { "[ifname|-]", "[vid]" },
         .enca_msg = mclagdctl_enca_dump_mac,
         .parse_msg = mclagdctl_parse_dump_mac,
     },
@@ -143,6 +146,14 @@ static struct command_type command_types[] =
         .enca_msg = mclagdctl_enca_dump_dbg_counters,
         .parse_msg = mclagdctl_parse_dump_dbg_counters,
     },
+    {
+        .id = ID_CMDTYPE_D_D_L,
+        .parent_id = ID_CMDTYPE_D_D,
+        .info_type = INFO_TYPE_DUMP_DBG_LATENCY,
+        .name = "latency",
+        .enca_msg = mclagdctl_enca_dump_dbg_latency,
+        .parse_msg = mclagdctl_parse_dump_dbg_latency,
+    },
     {
         .id = ID_CMDTYPE_C,
         .name = "config",
@@ -346,6 +357,9 @@ int mclagdctl_enca_dump_arp(char *msg, int mclag_id, int argc, char **argv)
     memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
     req.info_type = INFO_TYPE_DUMP_ARP;
     req.mclag_id = mclag_id;
+    /* Optional filter: interface name */
+    if (argc > 0)
+        snprintf(req.para1, sizeof(req.para1), "%s", argv[0]);
     memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
 
     return 1;
@@ -364,6 +378,9 @@ int mclagdctl_enca_dump_ndisc(char *msg, int mclag_id, int argc, char **argv)
     memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
     req.info_type = INFO_TYPE_DUMP_NDISC;
     req.mclag_id = mclag_id;
+    /* Optional filter: interface name */
+    if (argc > 0)
+        snprintf(req.para1, sizeof(req.para1), "%s", argv[0]);
     memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
 
     return 1;
@@ -461,6 +478,11 @@ int mclagdctl_enca_dump_mac(char *msg, int mclag_id, int argc, char **argv)
     memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
     req.info_type = INFO_TYPE_DUMP_MAC;
     req.mclag_id = mclag_id;
+    /* Optional filters: interface name ("-" for any) and vlan id */
+    if (argc > 0 && strcmp(argv[0], "-") != 0)
+        snprintf(req.para1, sizeof(req.para1), "%s", argv[0]);
+    if (argc > 1)
+        snprintf(req.para2, sizeof(req.para2), "%s", argv[1]);
     memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
 
     return 1;
@@ -860,6 +882,14 @@ int mclagdctl_parse_dump_dbg_counters(char *msg, int data_len)
         sys_counter_p->socket_close_err_counter);
     fprintf(stdout, "%-20s%u\n", "Socket cleanup:",
         sys_counter_p->socket_cleanup_counter);
+    fprintf(stdout, "%-20s%u\n", "Syncd TX queued:",
+        sys_counter_p->syncd_tx_queue_depth);
+    fprintf(stdout, "%-20s%u\n", "Syncd TX queue max:",
+        sys_counter_p->syncd_tx_queue_max_depth);
+    fprintf(stdout, "%-20s%u\n", "Syncd TX drop:",
+        sys_counter_p->syncd_tx_drop_counter);
+    fprintf(stdout, "%-20s%u\n", "Syncd TX coalesce:",
+        sys_counter_p->syncd_tx_coalesce_counter);
 
     fprintf(stdout, "\n");
     fprintf(stdout, "%-20s%u\n\n", "Warmboot:", sys_counter_p->warmboot_counter);
@@ -920,7 +950,118 @@ int mclagdctl_parse_dump_dbg_counters(char *msg, int data_len)
     fprintf(stdout, "Address add/del: %u/%u\n",
         sys_counter_p->newaddr_count, sys_counter_p->deladdr_count);
     fprintf(stdout, "Unexpected message type: %u\n", sys_counter_p->unknown_type_count);
-    fprintf(stdout, "Receive error: %u\n\n", sys_counter_p->rx_error_count);
+    fprintf(stdout, "Receive error: %u\n", sys_counter_p->rx_error_count);
+    fprintf(stdout, "  Overrun: %u\n", sys_counter_p->netlink_overrun_counter);
+    fprintf(stdout, "Re-sync: %u\n", sys_counter_p->netlink_resync_counter);
+    fprintf(stdout, "  Link handled/skipped/deleted: %u/%u/%u\n",
+        sys_counter_p->netlink_resync_link_counter, sys_counter_p->netlink_resync_skip_counter,
+        sys_counter_p->netlink_resync_del_counter);
+    fprintf(stdout, "  PortChannel member query: %u\n", sys_counter_p->netlink_resync_team_counter);
+    fprintf(stdout, "  Last/max duration (usec): %u/%u\n",
+        sys_counter_p->netlink_resync_last_usec, sys_counter_p->netlink_resync_max_usec);
+    fprintf(stdout, "ARP/ND packet rx: %u/%u\n",
+        sys_counter_p->arp_rx_packet_counter, sys_counter_p->ndisc_rx_packet_counter);
+    fprintf(stdout, "  Budget exhausted: %u\n", sys_counter_p->packet_rx_budget_counter);
+    fprintf(stdout, "PortChannel member query: %u\n", sys_counter_p->team_query_counter);
+    fprintf(stdout, "  Max in flight: %u\n\n", sys_counter_p->team_query_max_inflight);
+    return 0;
+}
+
+int mclagdctl_enca_dump_dbg_latency(char *msg, int mclag_id, int argc, char **argv)
+{
+    struct mclagdctl_req_hdr req;
+
+    memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
+    req.info_type = INFO_TYPE_DUMP_DBG_LATENCY;
+    req.mclag_id = mclag_id;
+    memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
+
+    return 1;
+}
+
+static char *mclagdctl_dbg_latency_phase2str(ICCP_LATENCY_PHASE_e phase)
+{
+    switch (phase)
+    {
+        case ICCP_LATENCY_LEARN_QUEUE:
+            return "Learn->Queue";
+        case ICCP_LATENCY_QUEUE_TX:
+            return "Queue->PeerTx";
+        case ICCP_LATENCY_PEER_RX_APPLY:
+            return "PeerRx->Apply";
+        case ICCP_LATENCY_APPLY_PROGRAM:
+            return "Apply->Syncd";
+        default:
+            return "Unknown";
+    }
+}
+
+int mclagdctl_parse_dump_dbg_latency(char *msg, int data_len)
+{
+    mclagd_dbg_latency_info_t *latency_p;
+    iccp_latency_hist_t *hist;
+    char range[32];
+    int first = ICCP_LATENCY_BUCKETS, last = -1;
+    int i, j;
+
+    if (data_len < sizeof(mclagd_dbg_latency_info_t))
+        return MCLAG_ERROR;
+
+    latency_p = (mclagd_dbg_latency_info_t *)msg;
+
+    fprintf(stdout, "%-20s%-20s%-20s%-20s\n", "Phase", "Count", "Avg(usec)", "Max(usec)");
+    fprintf(stdout, "%-20s%-20s%-20s%-20s\n", "-----", "-----", "---------", "---------");
+    for (i = 0; i < ICCP_LATENCY_PHASE_MAX; ++i)
+    {
+        hist = &latency_p->hist[i];
+        fprintf(stdout, "%-20s%-20lu%-20lu%-20u\n",
+            mclagdctl_dbg_latency_phase2str(i), hist->count,
+            hist->count ? hist->sum_usec / hist->count : 0, hist->max_usec);
+
+        for (j = 0; j < ICCP_LATENCY_BUCKETS; ++j)
+        {
+            if (hist->buckets[j] == 0)
+                continue;
+            if (j < first)
+                first = j;
+            if (j > last)
+                last = j;
+        }
+    }
+
+    if (last < 0)
+    {
+        fprintf(stdout, "\n");
+        return 0;
+    }
+
+    /* Histogram rows from the lowest to the highest used bucket */
+    fprintf(stdout, "\n%-20s", "Latency(usec)");
+    for (i = 0; i < ICCP_LATENCY_PHASE_MAX; ++i)
+        fprintf(stdout, "%-16s", mclagdctl_dbg_latency_phase2str(i));
+    fprintf(stdout, "\n%-20s", "-------------");
+    for (i = 0; i < ICCP_LATENCY_PHASE_MAX; ++i)
+        fprintf(stdout, "%-16s", "-----");
+    fprintf(stdout, "\n");
+
+    for (j = first; j <= last; ++j)
+    {
+        if (j == 0)
+            snprintf(range, sizeof(range), "< 1");
+        else if (j == 1)
+            snprintf(range, sizeof(range), "1");
+        else if (j == ICCP_LATENCY_BUCKETS - 1)
+            snprintf(range, sizeof(range), ">= %u", 1U << (j - 1));
+        else
+            snprintf(range, sizeof(range), "%u - %u", 1U << (j - 1), (1U << j) - 1);
+
+        fprintf(stdout, "%-20s", range);
+        for (i = 0; i < ICCP_LATENCY_PHASE_MAX; ++i)
+            fprintf(stdout, "%-16u", latency_p->hist[i].buckets[j]);
+        fprintf(stdout, "\n");
+    }
+    fprintf(stdout, "\n");
+
     return 0;
 }
 
@@ -1035,7 +1176,8 @@ static int mclagdctl_check_cmd_params(struct command_type *cmd_type,
 {
     int i = 0;
 
-    while (cmd_type->params[i])
+    /* Parameters in brackets are optional */
+    while (cmd_type->params[i] && cmd_type->params[i][0] != '[')
     {
         if (i == argc)
         {
@@ -60,6 +60,7 @@ enum id_command_type
     ID_CMDTYPE_D_P_P,
     ID_CMDTYPE_D_D,
     ID_CMDTYPE_D_D_C,
+    ID_CMDTYPE_D_D_L,
     ID_CMDTYPE_C,
     ID_CMDTYPE_C_L,
     ID_CMDTYPE_C_D,
@@ -78,6 +79,7 @@ enum mclagdctl_notify_peer_type
     INFO_TYPE_DUMP_DBG_COUNTERS,
     INFO_TYPE_CONFIG_LOGLEVEL,
     INFO_TYPE_CONFIG_DOWN,
+    INFO_TYPE_DUMP_DBG_LATENCY,
     INFO_TYPE_FINISH,
 };
 
@@ -220,6 +222,11 @@ typedef struct mclagd_dbg_counter_info
      */
 }mclagd_dbg_counter_info_t;
 
+typedef struct mclagd_dbg_latency_info
+{
+    iccp_latency_hist_t hist[ICCP_LATENCY_PHASE_MAX];
+}mclagd_dbg_latency_info_t;
+
 struct mclagd_unique_ip_if
 {
     int active;
@@ -243,5 +250,7 @@ int mclagdctl_parse_config_loglevel(char *msg, int data_len);
 
 extern int mclagdctl_enca_dump_dbg_counters(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_parse_dump_dbg_counters(char *msg, int data_len);
+extern int mclagdctl_enca_dump_dbg_latency(char *msg, int mclag_id, int argc, char **argv);
+extern int mclagdctl_parse_dump_dbg_latency(char *msg, int data_len);
 extern int mclagdctl_enca_dump_unique_ip(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_parse_dump_unique_ip(char *msg, int data_len);
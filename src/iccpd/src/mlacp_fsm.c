@@ -49,14 +49,17 @@
 * Define
 *
 * ***************************************/
+/* Peer msgs handled per FSM transit, a MAC/ARP/ND msg carries up to
+ * CSM_BUFFER_SIZE bytes of entries */
+#define MLACP_RX_MSG_BUDGET     32
+
 #define MLACP_MSG_QUEUE_REINIT(list) \
     { \
         struct Msg* msg = NULL; \
         while (!TAILQ_EMPTY(&(list))) { \
             msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), msg, tail); \
-            free(msg->buf); \
-            free(msg); \
+            iccp_csm_free_msg(msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -68,7 +71,7 @@
             mac_msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), mac_msg, tail); \
             if (mac_msg->op_type == MAC_SYNC_DEL) \
-                free(mac_msg); \
+                iccp_csm_free_mac_msg(mac_msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -142,8 +145,8 @@ RB_GENERATE(mac_rb_tree, MACMsg, mac_entry_rb, MACMsg_compare);
 *
 * ***************************************/
 char *mlacp_state(struct CSM* csm);
-static void mlacp_resync_arp(struct CSM* csm);
-static void mlacp_resync_ndisc(struct CSM *csm);
+static void mlacp_resync_arp(struct CSM* csm, int changed_only);
+static void mlacp_resync_ndisc(struct CSM *csm, int changed_only);
 /* Sync Sender APIs*/
 static void mlacp_sync_send_sysConf(struct CSM* csm);
 static void mlacp_sync_send_aggConf(struct CSM* csm);
@@ -255,25 +258,37 @@ static void mlacp_sync_send_aggState(struct CSM* csm)
 
     return;
 }
-#define MAX_MAC_ENTRY_NUM 30
-#define MAX_NEIGH_ENTRY_NUM 40
+/* MAC/ARP/ND entries are packed into one message until g_csm_buf is full,
+ * the prepare functions fail when the next entry would not fit */
 static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
 {
     int msg_len = 0;
+    int len = 0;
     struct MACMsg* mac_msg = NULL;
     struct MACMsg mac_find;
     int count = 0;
 
-    memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
     memset(&mac_find, 0, sizeof(struct MACMsg));
 
     while (!TAILQ_EMPTY(&(MLACP(csm).mac_msg_list)))
     {
         mac_msg = TAILQ_FIRST(&(MLACP(csm).mac_msg_list));
         MAC_TAILQ_REMOVE(&(MLACP(csm).mac_msg_list), mac_msg, tail);
+        system_latency_record(ICCP_LATENCY_QUEUE_TX, mac_msg->trace_usec);
+        mac_msg->trace_usec = 0;
 
-        msg_len = mlacp_prepare_for_mac_info_to_peer(csm, g_csm_buf, CSM_BUFFER_SIZE, mac_msg, count);
-        count++;
+        len = mlacp_prepare_for_mac_info_to_peer(csm, g_csm_buf, CSM_BUFFER_SIZE, mac_msg, count);
+        if (len == MCLAG_ERROR && count > 0)
+        {
+            iccp_csm_send(csm, g_csm_buf, msg_len);
+            count = 0;
+            len = mlacp_prepare_for_mac_info_to_peer(csm, g_csm_buf, CSM_BUFFER_SIZE, mac_msg, count);
+        }
+        if (len > 0)
+        {
+            msg_len = len;
+            count++;
+        }
 
         //free mac_msg if marked for delete.
         if (mac_msg->op_type == MAC_SYNC_DEL)
@@ -285,16 +300,10 @@ static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
                 mac_find.vid = mac_msg->vid ;
                 memcpy(mac_find.mac_addr, mac_msg->mac_addr, ETHER_ADDR_LEN);
                 if (!RB_FIND(mac_rb_tree, &MLACP(csm).mac_rb ,&mac_find))
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
             }
         }
 
-        if (count >= MAX_MAC_ENTRY_NUM)
-        {
-            iccp_csm_send(csm, g_csm_buf, msg_len);
-            count = 0;
-            memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
-        }
         /*ICCPD_LOG_DEBUG("mlacp_fsm", "  [SYNC_Send] MacInfo,len=[%d]", msg_len);*/
     }
 
@@ -307,26 +316,34 @@ static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
 static void mlacp_sync_send_syncArpInfo(struct CSM* csm)
 {
     int msg_len = 0;
+    int len = 0;
     struct Msg* msg = NULL;
+    struct Msg* entry = NULL;
+    struct ARPMsg* arp_msg = NULL;
     int count = 0;
 
-    memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
-
     while (!TAILQ_EMPTY(&(MLACP(csm).arp_msg_list)))
     {
         msg = TAILQ_FIRST(&(MLACP(csm).arp_msg_list));
         TAILQ_REMOVE(&(MLACP(csm).arp_msg_list), msg, tail);
+        system_latency_record(ICCP_LATENCY_QUEUE_TX, msg->trace_usec);
 
-        msg_len = mlacp_prepare_for_arp_info(csm, g_csm_buf, CSM_BUFFER_SIZE, (struct ARPMsg*)msg->buf, count, NEIGH_SYNC_CLIENT_IP);
-        count++;
-        free(msg->buf);
-        free(msg);
-        if (count >= MAX_NEIGH_ENTRY_NUM)
+        arp_msg = (struct ARPMsg*)msg->buf;
+        len = mlacp_prepare_for_arp_info(csm, g_csm_buf, CSM_BUFFER_SIZE, arp_msg, count, NEIGH_SYNC_CLIENT_IP);
+        if (len == MCLAG_ERROR && count > 0)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
             count = 0;
-            memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+            len = mlacp_prepare_for_arp_info(csm, g_csm_buf, CSM_BUFFER_SIZE, arp_msg, count, NEIGH_SYNC_CLIENT_IP);
         }
+        if (len > 0)
+        {
+            msg_len = len;
+            count++;
+            if (arp_msg->op_type == NEIGH_SYNC_ADD && (entry = mlacp_arp_find(csm, arp_msg->ipv4_addr)))
+                mlacp_neigh_sync_mark(&MLACP(csm).arp_digest, entry, mlacp_arp_digest(arp_msg));
+        }
+        iccp_csm_free_msg(msg);
         /*ICCPD_LOG_DEBUG("mlacp_fsm", "  [SYNC_Send] ArpInfo,len=[%d]", msg_len);*/
     }
 
@@ -339,26 +356,34 @@ static void mlacp_sync_send_syncArpInfo(struct CSM* csm)
 static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm)
 {
     int msg_len = 0;
+    int len = 0;
     struct Msg *msg = NULL;
+    struct Msg *entry = NULL;
+    struct NDISCMsg *ndisc_msg = NULL;
     int count = 0;
 
-    memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
-
     while (!TAILQ_EMPTY(&(MLACP(csm).ndisc_msg_list)))
     {
         msg = TAILQ_FIRST(&(MLACP(csm).ndisc_msg_list));
         TAILQ_REMOVE(&(MLACP(csm).ndisc_msg_list), msg, tail);
+        system_latency_record(ICCP_LATENCY_QUEUE_TX, msg->trace_usec);
 
-        msg_len = mlacp_prepare_for_ndisc_info(csm, g_csm_buf, CSM_BUFFER_SIZE, (struct NDISCMsg *)msg->buf, count, NEIGH_SYNC_CLIENT_IP);
-        count++;
-        free(msg->buf);
-        free(msg);
-        if (count >= MAX_NEIGH_ENTRY_NUM)
+        ndisc_msg = (struct NDISCMsg *)msg->buf;
+        len = mlacp_prepare_for_ndisc_info(csm, g_csm_buf, CSM_BUFFER_SIZE, ndisc_msg, count, NEIGH_SYNC_CLIENT_IP);
+        if (len == MCLAG_ERROR && count > 0)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
             count = 0;
-            memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+            len = mlacp_prepare_for_ndisc_info(csm, g_csm_buf, CSM_BUFFER_SIZE, ndisc_msg, count, NEIGH_SYNC_CLIENT_IP);
         }
+        if (len > 0)
+        {
+            msg_len = len;
+            count++;
+            if (ndisc_msg->op_type == NEIGH_SYNC_ADD && (entry = mlacp_ndisc_find(csm, ndisc_msg->ipv6_addr)))
+                mlacp_neigh_sync_mark(&MLACP(csm).ndisc_digest, entry, mlacp_ndisc_digest(ndisc_msg));
+        }
+        iccp_csm_free_msg(msg);
         /* ICCPD_LOG_DEBUG("mlacp_fsm", " [SYNC_Send] NDInfo,len=[%d]", msg_len); */
     }
 
@@ -410,22 +435,35 @@ static void mlacp_sync_send_syncPeerLinkInfo(struct CSM* csm)
     return;
 }
 
+/* Heartbeats are built in their own buffer, they may be sent while
+ * a MAC/ARP/ND message is being filled in g_csm_buf */
 static void mlacp_sync_send_heartbeat(struct CSM* csm)
 {
+    char buf[sizeof(ICCHdr) + sizeof(struct mLACPHeartbeatTLV)];
     int msg_len = 0;
 
     if ((csm->heartbeat_send_time == 0) ||
         ((time(NULL) - csm->heartbeat_send_time) > csm->keepalive_time))
     {
-        memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
-        msg_len = mlacp_prepare_for_heartbeat(csm, g_csm_buf, CSM_BUFFER_SIZE);
-        iccp_csm_send(csm, g_csm_buf, msg_len);
+        msg_len = mlacp_prepare_for_heartbeat(csm, buf, sizeof(buf));
+        iccp_csm_send(csm, buf, msg_len);
         time(&csm->heartbeat_send_time);
     }
 
     return;
 }
 
+/* Send the heartbeat of an operational session if it is due, called
+ * between bulk work outside the FSM so that table churn can not hold
+ * keepalives back */
+void mlacp_fsm_send_heartbeat(struct CSM* csm)
+{
+    if (csm == NULL || csm->sock_fd <= 0 || csm->app_csm.current_state != APP_OPERATIONAL)
+        return;
+
+    mlacp_sync_send_heartbeat(csm);
+}
+
 static void mlacp_sync_send_syncDoneData(struct CSM* csm)
 {
     int msg_len = 0;
@@ -535,6 +573,85 @@ static void mlacp_sync_recv_aggState(struct CSM* csm, struct Msg* msg)
     return;
 }
 
+/* Sync Digest TLV following the first TLV of msg, NULL if the peer
+ * did not send one */
+static mLACPSyncDigestTLV* mlacp_sync_find_digest(struct Msg* msg, size_t offset)
+{
+    ICCParameter param;
+
+    if (msg->len < offset + sizeof(mLACPSyncDigestTLV))
+        return NULL;
+
+    memcpy(&param, &msg->buf[offset], sizeof(ICCParameter));
+    *(uint16_t *)&param = ntohs(*(uint16_t *)&param);
+    if (param.type != TLV_T_MLACP_SYNC_DIGEST
+        || ntohs(param.len) < sizeof(mLACPSyncDigestTLV) - sizeof(ICCParameter))
+        return NULL;
+
+    return (mLACPSyncDigestTLV*)&msg->buf[offset];
+}
+
+/* Sender side: exchange only changed ARP/ND entries if the peer holds
+ * what was last exchanged with it, otherwise resend all of them */
+static void mlacp_sync_check_digest(struct CSM* csm, struct Msg* msg)
+{
+    mLACPSyncDigestTLV* tlv = NULL;
+    int delta = 0;
+
+    tlv = mlacp_sync_find_digest(msg, sizeof(ICCHdr) + sizeof(mLACPSyncReqTLV));
+    if (tlv)
+    {
+        MLACP(csm).sync_digest_peer = 1;
+        delta = (ntohl(tlv->sync_gen) == MLACP(csm).sync_gen
+                 && ntohl(tlv->arp_count) == MLACP(csm).arp_digest.count
+                 && ntohl(tlv->arp_sum) == MLACP(csm).arp_digest.sum
+                 && ntohl(tlv->ndisc_count) == MLACP(csm).ndisc_digest.count
+                 && ntohl(tlv->ndisc_sum) == MLACP(csm).ndisc_digest.sum);
+
+        /* Stage 2 follows the choice of stage 1 */
+        if (MLACP(csm).current_state == MLACP_STATE_STAGE2 && !MLACP(csm).sync_delta)
+            delta = 0;
+    }
+
+    MLACP(csm).sync_delta = delta;
+    if (delta)
+    {
+        /* Replace the full resync queued on connection */
+        MLACP_MSG_QUEUE_REINIT(MLACP(csm).arp_msg_list);
+        MLACP_MSG_QUEUE_REINIT(MLACP(csm).ndisc_msg_list);
+        mlacp_resync_arp(csm, 1);
+        mlacp_resync_ndisc(csm, 1);
+    }
+    else
+    {
+        mlacp_neigh_sync_reset(csm);
+    }
+
+    ICCPD_LOG_NOTICE("ICCP_FSM", "%s ARP/ND sync to peer, gen %u, peer digest %s",
+        delta ? "Incremental" : "Full", MLACP(csm).sync_gen, tlv ? "present" : "absent");
+
+    return;
+}
+
+/* Receiver side: follow the choice of the sender */
+static void mlacp_sync_recv_digest_reply(struct CSM* csm, struct Msg* msg)
+{
+    mLACPSyncDigestTLV* tlv = NULL;
+
+    tlv = mlacp_sync_find_digest(msg, sizeof(ICCHdr) + sizeof(mLACPSyncDataTLV));
+    if (tlv)
+        MLACP(csm).sync_digest_peer = 1;
+
+    MLACP(csm).sync_delta = (tlv && (tlv->flags & MLACP_SYNC_DIGEST_F_DELTA));
+    if (!MLACP(csm).sync_delta)
+        mlacp_neigh_sync_reset(csm);
+
+    ICCPD_LOG_NOTICE("ICCP_FSM", "%s ARP/ND sync from peer",
+        MLACP(csm).sync_delta ? "Incremental" : "Full");
+
+    return;
+}
+
 static void mlacp_sync_recv_syncData(struct CSM* csm, struct Msg* msg)
 {
     mLACPSyncDataTLV* syncdata = NULL;
@@ -547,7 +664,11 @@ static void mlacp_sync_recv_syncData(struct CSM* csm, struct Msg* msg)
         ICCPD_LOG_DEBUG("ICCP_FSM", "RX sync done");
     }
     else
+    {
         ICCPD_LOG_DEBUG("ICCP_FSM", "RX sync start");
+        if (MLACP(csm).current_state != MLACP_STATE_EXCHANGE)
+            mlacp_sync_recv_digest_reply(csm, msg);
+    }
     MLACP_SET_ICCP_RX_DBG_COUNTER(csm,
         syncdata->icc_parameter.type, ICCP_DBG_CNTR_STS_OK);
 
@@ -787,7 +908,10 @@ void mlacp_init(struct CSM* csm, int all)
         /* if no clean all, keep the arp info & local interface info for next connection*/
         MLACP_MSG_QUEUE_REINIT(MLACP(csm).arp_list);
         MLACP_MSG_QUEUE_REINIT(MLACP(csm).ndisc_list);
+        mlacp_neigh_index_reinit(csm);
+        mlacp_neigh_sync_reset(csm);
         RB_INIT(mac_rb_tree, &MLACP(csm).mac_rb );
+        mlacp_mac_index_reinit(csm);
         LIF_QUEUE_REINIT(MLACP(csm).lif_list);
 
         MLACP(csm).node_id = MLACP_SYSCONF_NODEID_MSB_MASK;
@@ -814,8 +938,11 @@ void mlacp_finalize(struct CSM* csm)
     mlacp_mac_msg_queue_reinit(csm);
     MLACP_MSG_QUEUE_REINIT(MLACP(csm).arp_list);
     MLACP_MSG_QUEUE_REINIT(MLACP(csm).ndisc_list);
+    mlacp_neigh_index_reinit(csm);
+    mlacp_neigh_sync_reset(csm);
 
     RB_INIT(mac_rb_tree, &MLACP(csm).mac_rb );
+    mlacp_mac_index_reinit(csm);
 
     /* remove lif & lif-purge queue */
     LIF_QUEUE_REINIT(MLACP(csm).lif_list);
@@ -838,6 +965,7 @@ void mlacp_fsm_transit(struct CSM* csm)
     ICCHdr* icc_hdr = NULL;
     ICCParameter* icc_param = NULL;
     int have_msg = 1;
+    int msg_count = 0;
 
     if (csm == NULL)
         return;
@@ -899,8 +1027,7 @@ void mlacp_fsm_transit(struct CSM* csm)
                 if (icc_hdr->ldp_hdr.msg_type == MSG_T_NOTIFICATION && icc_param->type == TLV_T_NAK)
                 {
                     mlacp_sync_recv_nak_handler(csm, msg);
-                    free(msg->buf);
-                    free(msg);
+                    iccp_csm_free_msg(msg);
                     continue;
                 }
             }
@@ -913,7 +1040,12 @@ void mlacp_fsm_transit(struct CSM* csm)
         if (prev_state != MLACP(csm).current_state)
         {
             if (MLACP(csm).current_state == MLACP_STATE_EXCHANGE)
+            {
+                /* Both peers count the syncs they completed */
+                if (MLACP(csm).sync_digest_peer)
+                    MLACP(csm).sync_gen++;
                 mlacp_peer_conn_handler(csm);
+            }
             prev_state = MLACP(csm).current_state;
         }
 
@@ -921,9 +1053,11 @@ void mlacp_fsm_transit(struct CSM* csm)
         if (MLACP(csm).current_state == MLACP_STATE_INIT)
         {
             MLACP(csm).wait_for_sync_data = 0;
+            MLACP(csm).sync_digest_peer = 0;
+            MLACP(csm).sync_delta = 0;
             MLACP(csm).current_state = MLACP_STATE_STAGE1;
-            mlacp_resync_arp(csm);
-            mlacp_resync_ndisc(csm);
+            mlacp_resync_arp(csm, 0);
+            mlacp_resync_ndisc(csm, 0);
         }
 
         switch (MLACP(csm).current_state)
@@ -946,8 +1080,13 @@ void mlacp_fsm_transit(struct CSM* csm)
         /*ICCPD_LOG_DEBUG("mlacp_fsm", "  Next State = %s", mlacp_state(csm));*/
         if (msg)
         {
-            free(msg->buf);
-            free(msg);
+            iccp_csm_free_msg(msg);
+
+            /* Leave the rest for the next transit, events and timers
+             * in between are served first. An emptied list still takes
+             * the final pass that handles the state change */
+            if (++msg_count >= MLACP_RX_MSG_BUDGET && !TAILQ_EMPTY(&MLACP(csm).mlacp_msg_list))
+                have_msg = 0;
         }
     }
 }
@@ -984,8 +1123,7 @@ void mlacp_enqueue_msg(struct CSM* csm, struct Msg* msg)
 {
     if (csm == NULL )
     {
-        if (msg != NULL )
-            free(msg);
+        iccp_csm_free_msg(msg);
         return;
     }
 
@@ -1032,16 +1170,16 @@ void mlacp_sync_mac(struct CSM* csm)
             }
 
             ICCPD_LOG_DEBUG("ICCP_FDB", "Sync MAC: MAC-msg-list enqueue interface %s, "
-                "MAC %s vlan %d, age_flag %d", mac_msg->ifname,
+                "MAC %s vlan %d, age_flag %d", ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
         }
         else
         {
             /*If MAC with local age flag and is point to MCLAG enabled port, reomove local age flag*/
-            if (strcmp(mac_msg->ifname, csm->peer_itf_name) != 0)
+            if (mac_msg->ifname_id != csm->peer_itf_id)
             {
                 ICCPD_LOG_DEBUG("ICCP_FDB", "Sync MAC: MAC-msg-list not enqueue for local age flag: %s, mac %s vlan-id %d, age_flag %d",
-                        mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
+                        ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
                 /* After warmboot remote mac can exist, should not
                    update existing flag
                  */
@@ -1056,12 +1194,12 @@ void mlacp_local_lif_clear_pending_mac(struct CSM* csm, struct LocalInterface *l
 {
     ICCPD_LOG_DEBUG("ICCP_FDB", "mlacp_local_lif_clear_pending_mac If: %s ", local_lif->name );
     struct MACMsg* mac_msg = NULL, *mac_temp = NULL;
-    RB_FOREACH_SAFE (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb, mac_temp)
+    MAC_IF_FOREACH_SAFE (mac_msg, csm, local_lif->ifname_id, mac_temp)
     {
-        if (mac_msg->pending_local_del && strcmp(mac_msg->origin_ifname, local_lif->name) == 0)
+        if (mac_msg->pending_local_del && mac_msg->origin_ifname_id == local_lif->ifname_id)
         {
             ICCPD_LOG_DEBUG("ICCP_FDB", "Clear pending MAC: MAC-msg-list not enqueue for local age flag: %s, mac %s vlan-id %d, age_flag %d, remove local age flag",
-                    mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
+                    ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
 
             del_mac_from_chip(mac_msg);
 
@@ -1074,7 +1212,7 @@ void mlacp_local_lif_clear_pending_mac(struct CSM* csm, struct LocalInterface *l
                 mac_msg->op_type = MAC_SYNC_DEL;
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
                 }
             }
             else
@@ -1085,10 +1223,12 @@ void mlacp_local_lif_clear_pending_mac(struct CSM* csm, struct LocalInterface *l
 }
 
 /******************************************
-* When peerlink ready, prepare the ARPMsg
+* When peerlink ready, prepare the ARPMsg.
+* changed_only skips the entries the peer
+* already holds, see mlacp_neigh_sync_mark()
 *
 ******************************************/
-static void mlacp_resync_arp(struct CSM* csm)
+static void mlacp_resync_arp(struct CSM* csm, int changed_only)
 {
     struct Msg* msg = NULL;
     struct ARPMsg* arp_msg = NULL;
@@ -1100,6 +1240,8 @@ static void mlacp_resync_arp(struct CSM* csm)
         TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
         {
             arp_msg = (struct ARPMsg*)msg->buf;
+            if (changed_only && msg->sync_digest == mlacp_arp_digest(arp_msg))
+                continue;
             arp_msg->op_type = NEIGH_SYNC_ADD;
             arp_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char*)arp_msg, sizeof(struct ARPMsg)) == 0)
@@ -1114,7 +1256,7 @@ static void mlacp_resync_arp(struct CSM* csm)
 * When peerlink ready, prepare the NDISCMsg
 *
 ******************************************/
-static void mlacp_resync_ndisc(struct CSM *csm)
+static void mlacp_resync_ndisc(struct CSM *csm, int changed_only)
 {
     struct Msg *msg = NULL;
     struct NDISCMsg *ndisc_msg = NULL;
@@ -1126,6 +1268,8 @@ static void mlacp_resync_ndisc(struct CSM *csm)
         TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
         {
             ndisc_msg = (struct NDISCMsg *)msg->buf;
+            if (changed_only && msg->sync_digest == mlacp_ndisc_digest(ndisc_msg))
+                continue;
             ndisc_msg->op_type = NEIGH_SYNC_ADD;
             ndisc_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char *)ndisc_msg, sizeof(struct NDISCMsg)) == 0)
@@ -1261,14 +1405,17 @@ static void mlacp_sync_receiver_handler(struct CSM* csm, struct Msg* msg)
 
         case TLV_T_MLACP_MAC_INFO:
             mlacp_sync_recv_macInfo(csm, msg);
+            system_latency_record(ICCP_LATENCY_PEER_RX_APPLY, msg->trace_usec);
             break;
 
         case TLV_T_MLACP_ARP_INFO:
             mlacp_sync_recv_arpInfo(csm, msg);
+            system_latency_record(ICCP_LATENCY_PEER_RX_APPLY, msg->trace_usec);
             break;
 
         case TLV_T_MLACP_NDISC_INFO:
             mlacp_sync_recv_ndiscInfo(csm, msg);
+            system_latency_record(ICCP_LATENCY_PEER_RX_APPLY, msg->trace_usec);
             break;
 
         case TLV_T_MLACP_STP_INFO:
@@ -1350,10 +1497,17 @@ static void mlacp_sync_sender_handler(struct CSM* csm)
 static void mlacp_sync_send_all_info_handler(struct CSM* csm)
 {
     size_t len = 0;
+    int ret = 0;
 
     /* Prepare for sync start reply*/
     memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
     len = mlacp_prepare_for_sync_data_tlv(csm, g_csm_buf, CSM_BUFFER_SIZE, 0);
+    if (MLACP(csm).sync_digest_peer && MLACP(csm).current_state != MLACP_STATE_EXCHANGE)
+    {
+        ret = mlacp_prepare_for_sync_digest_tlv(csm, g_csm_buf, CSM_BUFFER_SIZE, len, MLACP(csm).sync_delta);
+        if (ret > 0)
+            len = ret;
+    }
     iccp_csm_send(csm, g_csm_buf, len);
 
     MLACP(csm).sync_state = MLACP_SYNC_SYSCONF;
@@ -1396,6 +1550,7 @@ static void mlacp_stage_sync_send_handler(struct CSM* csm, struct Msg* msg)
                 mlacp_sync_req = (mLACPSyncReqTLV*)&msg->buf[sizeof(ICCHdr)];
                 MLACP(csm).wait_for_sync_data = 1;
                 MLACP(csm).sync_req_num = ntohs(mlacp_sync_req->req_num);
+                mlacp_sync_check_digest(csm, msg);
 
                 /* Reply the peer all sync info*/
                 mlacp_sync_send_all_info_handler(csm);
@@ -1409,6 +1564,7 @@ static void mlacp_stage_sync_send_handler(struct CSM* csm, struct Msg* msg)
 static void mlacp_stage_sync_request_handler(struct CSM* csm, struct Msg* msg)
 {
     int msg_len = 0;
+    int ret = 0;
 
     /* Socket server send sync request first*/
     if (MLACP(csm).wait_for_sync_data == 0)
@@ -1416,6 +1572,9 @@ static void mlacp_stage_sync_request_handler(struct CSM* csm, struct Msg* msg)
         // Send out the request for ALL
         memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
         msg_len = mlacp_prepare_for_sync_request_tlv(csm, g_csm_buf, CSM_BUFFER_SIZE);
+        ret = mlacp_prepare_for_sync_digest_tlv(csm, g_csm_buf, CSM_BUFFER_SIZE, msg_len, 0);
+        if (ret > 0)
+            msg_len = ret;
         iccp_csm_send(csm, g_csm_buf, msg_len);
         MLACP(csm).wait_for_sync_data = 1;
     }
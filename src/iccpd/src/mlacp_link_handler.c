@@ -26,6 +26,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
+#include <fcntl.h>
+#include <stddef.h>
 #include <arpa/inet.h>
 #include <sys/queue.h>
 #include <sys/epoll.h>
@@ -42,6 +44,7 @@
 #include "../include/iccp_cmd_show.h"
 #include "../include/iccp_cli.h"
 #include "../include/iccp_cmd.h"
+#include "../include/mlacp_sync_update.h"
 #include "../include/mlacp_link_handler.h"
 #include "../include/mlacp_sync_prepare.h"
 #include "../include/iccp_netlink.h"
@@ -71,8 +74,51 @@ char g_iccp_mlagsyncd_send_buf[ICCP_MLAGSYNCD_SEND_MSG_BUFFER_SIZE] = { 0 };
 
 extern void mlacp_sync_mac(struct CSM* csm);
 
-#define SYNCD_SEND_RETRY_INTERVAL_USEC    50000 //50 mseconds
-#define SYNCD_SEND_RETRY_MAX              5
+#define SYNCD_TX_QUEUE_SIZE               (MCLAG_MAX_MSG_LEN * 256)
+#define SYNCD_TX_DROP_LOG_INTERVAL        1000
+#define SYNCD_RX_FDB_HEARTBEAT_INTERVAL   1024
+
+/* Pending msgs to mclagsyncd, bytes in [head, tail) are not sent yet */
+static char g_syncd_tx_queue[SYNCD_TX_QUEUE_SIZE];
+static size_t g_syncd_tx_head = 0;
+static size_t g_syncd_tx_tail = 0;
+/* Offset of the queued SET_FDB msg new FDB entries can be appended to */
+static size_t g_syncd_tx_fdb_msg = 0;
+static int g_syncd_tx_fdb_valid = 0;
+static int g_syncd_tx_pollout = 0;
+
+/* Issue time of queued SET_FDB entries, by the count of sent bytes that
+ * completes them, for the apply to program latency */
+#define SYNCD_TX_MARK_MAX                 1024
+struct syncd_tx_mark
+{
+    uint64_t sent_bytes;
+    uint64_t issue_usec;
+};
+static struct syncd_tx_mark g_syncd_tx_marks[SYNCD_TX_MARK_MAX];
+static unsigned int g_syncd_tx_mark_first = 0;
+static unsigned int g_syncd_tx_mark_count = 0;
+static uint64_t g_syncd_tx_sent_bytes = 0;
+
+#define MCLAGD_CTL_CLIENT_MAX             16
+#define MCLAGD_CTL_CLIENT_TIMEOUT_MSEC    5000
+
+struct mclagd_ctl_client
+{
+    int fd;
+    char req_buf[sizeof(struct mclagdctl_req_hdr)];
+    int req_len;
+    char *reply;
+    int reply_len;
+    int reply_pos;
+    int wait_out;
+    struct SchedTimer timer;
+    LIST_ENTRY(mclagd_ctl_client) next;
+};
+
+static LIST_HEAD(mclagd_ctl_client_list, mclagd_ctl_client) g_mclagd_ctl_client_list =
+    LIST_HEAD_INITIALIZER(g_mclagd_ctl_client_list);
+static int g_mclagd_ctl_client_count = 0;
 
 #define SYNCD_RECV_RETRY_INTERVAL_USEC    50000 //50 mseconds
 #define SYNCD_RECV_RETRY_MAX              5
@@ -145,7 +191,7 @@ add_arp:
     if (MLACP(csm).current_state != MLACP_STATE_EXCHANGE)
         return 0;
 
-    TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+    LIST_FOREACH(msg, &MLACP(csm).arp_if_hash[mlacp_neigh_if_hash(lif->name)], neigh_if_next)
     {
         mac_str[0] = '\0';
         arp_msg = (struct ARPMsg*)msg->buf;
@@ -168,7 +214,7 @@ add_arp:
 
 del_arp:
     /* Process Del */
-    TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+    LIST_FOREACH(msg, &MLACP(csm).arp_if_hash[mlacp_neigh_if_hash(lif->name)], neigh_if_next)
     {
         arp_msg = (struct ARPMsg*)msg->buf;
 
@@ -209,7 +255,7 @@ add_ndisc:
     if (MLACP(csm).current_state != MLACP_STATE_EXCHANGE)
         return 0;
 
-    TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+    LIST_FOREACH(msg, &MLACP(csm).ndisc_if_hash[mlacp_neigh_if_hash(lif->name)], neigh_if_next)
     {
         mac_str[0] = '\0';
         ndisc_msg = (struct NDISCMsg *)msg->buf;
@@ -232,7 +278,7 @@ add_ndisc:
 
 del_ndisc:
     /* Process Del */
-    TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+    LIST_FOREACH(msg, &MLACP(csm).ndisc_if_hash[mlacp_neigh_if_hash(lif->name)], neigh_if_next)
     {
         ndisc_msg = (struct NDISCMsg *)msg->buf;
 
@@ -396,14 +442,155 @@ static int peer_po_is_alive(struct CSM *csm, int po_ifindex)
     return pif_active;
 }
 
-// return -1 if failed
+/*****************************************
+* MclagSyncd TX queue
+*
+* Messages mclagsyncd can not take right away are
+* queued and sent when sync_fd becomes writable.
+* ***************************************/
+static void syncd_tx_queue_set_pollout(struct System *sys, int enable)
+{
+    struct epoll_event event;
+
+    if (g_syncd_tx_pollout == enable)
+        return;
+
+    event.data.fd = sys->sync_fd;
+    event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_MOD, sys->sync_fd, &event) < 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to modify mclagsyncd epoll events, errno %d", errno);
+        return;
+    }
+    g_syncd_tx_pollout = enable;
+}
+
+static void syncd_tx_queue_update_depth(struct System *sys)
+{
+    sys->dbg_counters.syncd_tx_queue_depth = g_syncd_tx_tail - g_syncd_tx_head;
+    if (sys->dbg_counters.syncd_tx_queue_depth > sys->dbg_counters.syncd_tx_queue_max_depth)
+        sys->dbg_counters.syncd_tx_queue_max_depth = sys->dbg_counters.syncd_tx_queue_depth;
+}
+
+/* Remember when the SET_FDB entry just queued was issued, entries are
+ * not timed while the marks are exhausted */
+static void syncd_tx_queue_mark_fdb(uint64_t issue_usec)
+{
+    struct syncd_tx_mark *mark;
+
+    if (g_syncd_tx_mark_count == SYNCD_TX_MARK_MAX)
+        return;
+
+    mark = &g_syncd_tx_marks[(g_syncd_tx_mark_first + g_syncd_tx_mark_count) % SYNCD_TX_MARK_MAX];
+    mark->sent_bytes = g_syncd_tx_sent_bytes + g_syncd_tx_tail - g_syncd_tx_head;
+    mark->issue_usec = issue_usec;
+    g_syncd_tx_mark_count++;
+}
+
+/* Record the latency of SET_FDB entries sent completely */
+static void syncd_tx_queue_unmark_sent()
+{
+    struct syncd_tx_mark *mark;
+
+    while (g_syncd_tx_mark_count > 0)
+    {
+        mark = &g_syncd_tx_marks[g_syncd_tx_mark_first];
+        if (mark->sent_bytes > g_syncd_tx_sent_bytes)
+            break;
+
+        system_latency_record(ICCP_LATENCY_APPLY_PROGRAM, mark->issue_usec);
+        g_syncd_tx_mark_first = (g_syncd_tx_mark_first + 1) % SYNCD_TX_MARK_MAX;
+        g_syncd_tx_mark_count--;
+    }
+}
+
+static void syncd_tx_queue_reset(struct System *sys)
+{
+    g_syncd_tx_mark_count = 0;
+    g_syncd_tx_head = 0;
+    g_syncd_tx_tail = 0;
+    g_syncd_tx_fdb_valid = 0;
+    g_syncd_tx_pollout = 0;
+    sys->dbg_counters.syncd_tx_queue_depth = 0;
+}
+
+/* Send as much of the TX queue as sync_fd accepts */
+int iccp_syncd_tx_queue_drain()
+{
+    struct System *sys;
+    ssize_t send_len;
+
+    if ((sys = system_get_instance()) == NULL || sys->sync_fd < 0)
+        return MCLAG_ERROR;
+
+    while (g_syncd_tx_head < g_syncd_tx_tail)
+    {
+        send_len = send(sys->sync_fd, &g_syncd_tx_queue[g_syncd_tx_head],
+                        g_syncd_tx_tail - g_syncd_tx_head, MSG_DONTWAIT);
+        if (send_len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+
+            ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd failed, errno %d, discard %zu queued bytes",
+                          errno, g_syncd_tx_tail - g_syncd_tx_head);
+            syncd_tx_queue_set_pollout(sys, 0);
+            syncd_tx_queue_reset(sys);
+            return MCLAG_ERROR;
+        }
+
+        g_syncd_tx_head += send_len;
+        g_syncd_tx_sent_bytes += send_len;
+        syncd_tx_queue_unmark_sent();
+        /* Partially sent SET_FDB msg can not be extended any more */
+        if (g_syncd_tx_fdb_valid && g_syncd_tx_fdb_msg < g_syncd_tx_head)
+            g_syncd_tx_fdb_valid = 0;
+    }
+
+    if (g_syncd_tx_head == g_syncd_tx_tail)
+    {
+        g_syncd_tx_head = 0;
+        g_syncd_tx_tail = 0;
+        g_syncd_tx_fdb_valid = 0;
+        syncd_tx_queue_set_pollout(sys, 0);
+    }
+    syncd_tx_queue_update_depth(sys);
+
+    return 0;
+}
+
+/* Try to merge the entry of a SET_FDB msg into the last queued SET_FDB msg */
+static int syncd_tx_queue_coalesce_fdb(struct System *sys, char *send_buff, uint16_t msg_len)
+{
+    struct IccpSyncdHDr *queued_hdr;
+    uint16_t entry_len = msg_len - sizeof(struct IccpSyncdHDr);
+
+    if (!g_syncd_tx_fdb_valid)
+        return 0;
+
+    queued_hdr = (struct IccpSyncdHDr *)&g_syncd_tx_queue[g_syncd_tx_fdb_msg];
+    if (queued_hdr->len + entry_len > MCLAG_MAX_MSG_LEN
+        || g_syncd_tx_tail + entry_len > SYNCD_TX_QUEUE_SIZE)
+        return 0;
+
+    memcpy(&g_syncd_tx_queue[g_syncd_tx_tail], send_buff + sizeof(struct IccpSyncdHDr), entry_len);
+    queued_hdr->len += entry_len;
+    g_syncd_tx_tail += entry_len;
+    ++sys->dbg_counters.syncd_tx_coalesce_counter;
+
+    return 1;
+}
+
+/* Send msg to mclagsyncd, or queue it if the socket is busy.
+ * return msg_len if sent or queued, -1 if failed */
 ssize_t iccp_send_to_mclagsyncd(uint8_t msg_type, char *send_buff, uint16_t msg_len)
 {
     struct System *sys;
-    ssize_t write = 0;
-    int num_retry = 0;
-    size_t pos = 0;
-    int send_len = 0;
+    ssize_t send_len = 0;
+    size_t queue_len;
+    uint64_t issue_usec = 0;
 
     sys = system_get_instance();
     if (sys == NULL)
@@ -412,55 +599,80 @@ ssize_t iccp_send_to_mclagsyncd(uint8_t msg_type, char *send_buff, uint16_t msg_
         return MCLAG_ERROR;
     }
 
-    if (sys->sync_fd)
+    if (sys->sync_fd < 0)
     {
-        while (msg_len > 0)
-        {
-            send_len = send(sys->sync_fd, &send_buff[pos], msg_len, MSG_DONTWAIT);
+        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
+        return MCLAG_ERROR;
+    }
 
-            if (send_len == -1)
-            {
-                if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-                {
-                    ++num_retry;
-                    if (num_retry > SYNCD_SEND_RETRY_MAX)
-                    {
-                        ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() retry failed,msg_type: %d msg_len/send_len %d/%d",
-                                msg_type, msg_len, send_len);
-                        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                                            sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
-                        return MCLAG_ERROR;
-                    }
-                    else
-                    {
-                        usleep(SYNCD_SEND_RETRY_INTERVAL_USEC);
-                        send_len = 0;
-                    }
-                }
-                else
-                {
-                    ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() failed, msg_type: %d errno %d",
-                            msg_type, errno);
-                    SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
-                    return MCLAG_ERROR;
-                }
-            }
-            else if (send_len == 0)
+    if (msg_type == MCLAG_MSG_TYPE_SET_FDB)
+        issue_usec = system_get_usec();
+
+    if (g_syncd_tx_head == g_syncd_tx_tail)
+    {
+        /* Nothing queued, send directly */
+        send_len = send(sys->sync_fd, send_buff, msg_len, MSG_DONTWAIT);
+        if (send_len < 0)
+        {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
             {
-                ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() failed socket closed msg_type: %d errno %d",
-                        msg_type, errno);
-                SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                                    sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
+                ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() failed, msg_type: %d errno %d",
+                              msg_type, errno);
+                SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
                 return MCLAG_ERROR;
             }
-            msg_len -= send_len;
-            pos += send_len;
+            send_len = 0;
         }
+
+        if (send_len == msg_len)
+        {
+            system_latency_record(ICCP_LATENCY_APPLY_PROGRAM, issue_usec);
+            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_OK);
+            return msg_len;
+        }
+        g_syncd_tx_sent_bytes += send_len;
+    }
+    else if (msg_type == MCLAG_MSG_TYPE_SET_FDB
+             && syncd_tx_queue_coalesce_fdb(sys, send_buff, msg_len))
+    {
+        syncd_tx_queue_mark_fdb(issue_usec);
+        syncd_tx_queue_update_depth(sys);
         SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_OK);
+        return msg_len;
     }
 
-    return pos;
+    queue_len = msg_len - send_len;
+    if (g_syncd_tx_tail + queue_len > SYNCD_TX_QUEUE_SIZE && g_syncd_tx_head > 0)
+    {
+        memmove(g_syncd_tx_queue, &g_syncd_tx_queue[g_syncd_tx_head], g_syncd_tx_tail - g_syncd_tx_head);
+        g_syncd_tx_tail -= g_syncd_tx_head;
+        g_syncd_tx_fdb_msg -= g_syncd_tx_head;
+        g_syncd_tx_head = 0;
+    }
 
+    /* A partially sent msg always fits in the (then empty) queue */
+    if (g_syncd_tx_tail + queue_len > SYNCD_TX_QUEUE_SIZE)
+    {
+        if (sys->dbg_counters.syncd_tx_drop_counter++ % SYNCD_TX_DROP_LOG_INTERVAL == 0)
+            ICCPD_LOG_WARN("ICCP_FSM", "Mclagsyncd TX queue full, drop msg_type: %d, total dropped %u",
+                           msg_type, sys->dbg_counters.syncd_tx_drop_counter);
+        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
+        return MCLAG_ERROR;
+    }
+
+    /* Only an unsent SET_FDB msg at the queue tail can take more entries */
+    g_syncd_tx_fdb_valid = (msg_type == MCLAG_MSG_TYPE_SET_FDB && send_len == 0);
+    g_syncd_tx_fdb_msg = g_syncd_tx_tail;
+
+    memcpy(&g_syncd_tx_queue[g_syncd_tx_tail], send_buff + send_len, queue_len);
+    g_syncd_tx_tail += queue_len;
+    if (issue_usec)
+        syncd_tx_queue_mark_fdb(issue_usec);
+    syncd_tx_queue_set_pollout(sys, 1);
+    syncd_tx_queue_update_depth(sys);
+    SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_OK);
+
+    return msg_len;
 }
 
 #if 0
@@ -542,19 +754,12 @@ void set_peerlink_mlag_port_learn(struct LocalInterface *lif, int enable)
     /*send msg*/
     if (sys->sync_fd)
     {
-        rc = write(sys->sync_fd,msg_buf, msg_hdr->len);
+        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
         if ((rc <= 0) || (rc != msg_hdr->len))
         {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
             ICCPD_LOG_ERR(__FUNCTION__, "Failed to write for %s, rc %d",
                 lif->name, rc);
         }
-        else
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
-        }
     }
     return;
 }
@@ -843,7 +1048,7 @@ int mlacp_link_del_iccp_info(
     msg_hdr->len += (sizeof(mclag_sub_option_hdr_t) + sub_msg->op_len);
 
     if (sys->sync_fd)
-        rc = send(sys->sync_fd,msg_buf, msg_hdr->len, MSG_DONTWAIT);
+        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
 
     if ((rc <= 0) || (rc != msg_hdr->len))
     {
@@ -853,7 +1058,6 @@ int mlacp_link_del_iccp_info(
     }
     else
     {
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
         ICCPD_LOG_DEBUG("ICCP_FSM", "Delete mlag %d", mlag_id);
         return 0;
     }
@@ -1191,18 +1395,9 @@ void update_peerlink_isolate_from_all_csm_lif(
     /*send msg*/
     if (sys->sync_fd)
     {
-        rc = write(sys->sync_fd,msg_buf, msg_hdr->len);
+        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
         if ((rc <= 0) || (rc != msg_hdr->len))
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
             ICCPD_LOG_ERR(__FUNCTION__, "Failed to write, rc %d", rc);
-        }
-        else
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
-        }
     }
 
     return;
@@ -1491,7 +1686,7 @@ void syn_arp_info_to_peer(struct CSM *csm, struct LocalInterface *local_if)
 
     if (!TAILQ_EMPTY(&(MLACP(csm).arp_list)))
     {
-        TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+        LIST_FOREACH(msg, &MLACP(csm).arp_if_hash[mlacp_neigh_if_hash(local_if->name)], neigh_if_next)
         {
             arp_info = (struct ARPMsg*)msg->buf;
 
@@ -1528,7 +1723,7 @@ void syn_ndisc_info_to_peer(struct CSM *csm, struct LocalInterface *local_if)
 
     if (!TAILQ_EMPTY(&(MLACP(csm).ndisc_list)))
     {
-        TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+        LIST_FOREACH(msg, &MLACP(csm).ndisc_if_hash[mlacp_neigh_if_hash(local_if->name)], neigh_if_next)
         {
             ndisc_info = (struct NDISCMsg *)msg->buf;
 
@@ -1653,7 +1848,7 @@ void iccp_send_fdb_entry_to_syncd( struct MACMsg* mac_msg, uint8_t mac_type, uin
     /*mac msg */
     mac_info = (struct mclag_fdb_info *)&msg_buf[sizeof(struct IccpSyncdHDr)];
     mac_info->vid = mac_msg->vid;
-    memcpy(mac_info->port_name, mac_msg->ifname, MAX_L_PORT_NAME);
+    memcpy(mac_info->port_name, ifname_from_id(mac_msg->ifname_id), MAX_L_PORT_NAME);
     memcpy(mac_info->mac, mac_msg->mac_addr, ETHER_ADDR_LEN);
     mac_info->type = mac_type;
     mac_info->op_type = oper;
@@ -1713,7 +1908,7 @@ uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t
             new_age_flag &= ~MAC_AGE_LOCAL;
 
             ICCPD_LOG_DEBUG("ICCP_FDB", "After Remove local age, flag: %d interface  %s, "
-                "add %s vlan-id %d, old age_flag %d", new_age_flag, mac_msg->ifname,
+                "add %s vlan-id %d, old age_flag %d", new_age_flag, ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
 
             /*send mac MAC_SYNC_ADD message to peer*/
@@ -1722,10 +1917,11 @@ uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t
                 mac_msg->op_type = MAC_SYNC_ADD;
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
+                    mac_msg->trace_usec = system_latency_queue_stamp();
                     TAILQ_INSERT_TAIL(&(MLACP(csm).mac_msg_list), mac_msg, tail);
                 }
                 /*ICCPD_LOG_DEBUG(__FUNCTION__, "MAC-msg-list enqueue: %s, add %s vlan-id %d, age_flag %d",
-                               mac_msg->ifname, mac_msg->mac_str, mac_msg->vid, mac_msg->age_flag);*/
+                               ifname_from_id(mac_msg->ifname_id), mac_msg->mac_str, mac_msg->vid, mac_msg->age_flag);*/
             }
         }
     }
@@ -1736,7 +1932,7 @@ uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t
             new_age_flag |= MAC_AGE_LOCAL;
 
             ICCPD_LOG_DEBUG("ICCP_FDB", "After local age set, flag: %d interface %s, "
-                    "MAC %s vlan-id %d, old age_flag %d", new_age_flag, mac_msg->ifname,
+                    "MAC %s vlan-id %d, old age_flag %d", new_age_flag, ifname_from_id(mac_msg->ifname_id),
                     mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
 
             /*send mac MAC_SYNC_DEL message to peer*/
@@ -1745,11 +1941,12 @@ uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t
                 mac_msg->op_type = MAC_SYNC_DEL;
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
+                    mac_msg->trace_usec = system_latency_queue_stamp();
                     TAILQ_INSERT_TAIL(&(MLACP(csm).mac_msg_list), mac_msg, tail);
                 }
 
                 ICCPD_LOG_DEBUG("ICCP_FDB", "Set local age: MAC-msg-list enqueue interface: %s, oper: %s "
-                        "MAC %s vlan-id %d, age_flag %d", mac_msg->ifname,
+                        "MAC %s vlan-id %d, age_flag %d", ifname_from_id(mac_msg->ifname_id),
                         (mac_msg->op_type == MAC_SYNC_ADD) ? "add":"del",
                         mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
             }
@@ -1782,10 +1979,10 @@ static void update_l2_mac_state(struct CSM *csm,
     }
 
 
-    RB_FOREACH_SAFE (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb, mac_temp)
+    MAC_IF_FOREACH_SAFE (mac_msg, csm, lif->ifname_id, mac_temp)
     {
         /* find the MAC for this interface*/
-        if (strcmp(lif->name, mac_msg->origin_ifname) != 0)
+        if (lif->ifname_id != mac_msg->origin_ifname_id)
             continue;
 
         /*portchannel down*/
@@ -1796,11 +1993,11 @@ static void update_l2_mac_state(struct CSM *csm,
             {
                 if ((strlen(csm->peer_itf_name) != 0) && csm->peer_link_if && csm->peer_link_if->state == PORT_STATE_UP)
                 {
-                    memcpy(mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                    mac_msg->ifname_id = csm->peer_itf_id;
 
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down, MAC learn local only, age flag %d, "
                        "redirect MAC to peer-link: %s, MAC %s vlan-id %d",
-                       mac_msg->age_flag, mac_msg->ifname,
+                       mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                        mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
 
                     add_mac_to_chip(mac_msg, mac_msg->fdb_type);
@@ -1808,10 +2005,10 @@ static void update_l2_mac_state(struct CSM *csm,
                 else
                 {
                     del_mac_from_chip(mac_msg);
-                    memcpy(mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                    mac_msg->ifname_id = csm->peer_itf_id;
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down,  MAC learn local only, age flag %d, "
                        "can not redirect, del MAC as peer-link %s not available or down, "
-                       "MAC %s vlan-id %d", mac_msg->age_flag, mac_msg->ifname,
+                       "MAC %s vlan-id %d", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                        mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                 }
 
@@ -1824,7 +2021,7 @@ static void update_l2_mac_state(struct CSM *csm,
 
             ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down, age flag %d, MAC %s, "
                 "vlan-id %d, Interface: %s", mac_msg->age_flag ,
-                mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->ifname);
+                mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
 
             if (mac_msg->age_flag == (MAC_AGE_LOCAL | MAC_AGE_PEER))
             {
@@ -1834,7 +2031,7 @@ static void update_l2_mac_state(struct CSM *csm,
 
                 ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down, del MAC %s, vlan-id %d,"
                         " Interface: %s,", mac_addr_to_str(mac_msg->mac_addr),
-                       mac_msg->vid, mac_msg->ifname);
+                       mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
 
                 MAC_RB_REMOVE(mac_rb_tree, &MLACP(csm).mac_rb, mac_msg);
 
@@ -1842,7 +2039,7 @@ static void update_l2_mac_state(struct CSM *csm,
                 // else free is taken care after sending the update to peer
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
                 }
             }
             else
@@ -1854,11 +2051,11 @@ static void update_l2_mac_state(struct CSM *csm,
                     /*Is need to delete the old item before add?(Old item probably is static)*/
                     if (csm->peer_link_if && csm->peer_link_if->state == PORT_STATE_UP)
                     {
-                        memcpy(mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_msg->ifname_id = csm->peer_itf_id;
                         add_mac_to_chip(mac_msg, mac_msg->fdb_type);
                         ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down, age flag %d, "
                            "redirect MAC to peer-link: %s, MAC %s vlan-id %d",
-                           mac_msg->age_flag, mac_msg->ifname,
+                           mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                            mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                     }
                     else
@@ -1866,10 +2063,10 @@ static void update_l2_mac_state(struct CSM *csm,
                         /*must redirect but peerlink is down, del mac from ASIC*/
                         /*if peerlink change to up, mac will add back to ASIC*/
                         del_mac_from_chip(mac_msg);
-                        memcpy(mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_msg->ifname_id = csm->peer_itf_id;
                         ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down, age flag %d, "
                            "can not redirect, del MAC as peer-link: %s down, "
-                           "MAC %s vlan-id %d", mac_msg->age_flag, mac_msg->ifname,
+                           "MAC %s vlan-id %d", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                            mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                     }
                 }
@@ -1879,7 +2076,7 @@ static void update_l2_mac_state(struct CSM *csm,
                     del_mac_from_chip(mac_msg);
 
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Intf down, flag %d, peer-link: %s not available, "
-                    "MAC %s vlan-id %d", mac_msg->age_flag, mac_msg->ifname,
+                    "MAC %s vlan-id %d", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                     mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                 }
             }
@@ -1888,10 +2085,10 @@ static void update_l2_mac_state(struct CSM *csm,
         {
             /*the old item is redirect to peerlink for portchannel down*/
             /*when this portchannel up, recover the mac back*/
-            if (strcmp(mac_msg->ifname, csm->peer_itf_name) == 0)
+            if (mac_msg->ifname_id == csm->peer_itf_id)
             {
                 ICCPD_LOG_DEBUG("ICCP_FDB", "Intf up, redirect MAC to Interface: %s,"
-                " MAC %s vlan-id %d, age flag: %d ", mac_msg->ifname,
+                " MAC %s vlan-id %d, age flag: %d ", ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
 
                 if (mac_msg->pending_local_del)
@@ -1903,7 +2100,7 @@ static void update_l2_mac_state(struct CSM *csm,
                 //mac_msg->age_flag = set_mac_local_age_flag(csm, mac_msg, 0, 1);
 
                 /*Reverse interface from peer-link to the original portchannel*/
-                memcpy(mac_msg->ifname, mac_msg->origin_ifname, MAX_L_PORT_NAME);
+                mac_msg->ifname_id = mac_msg->origin_ifname_id;
 
                 /*Send dynamic or static mac add message to mclagsyncd*/
 
@@ -1918,7 +2115,7 @@ static void update_l2_mac_state(struct CSM *csm,
                 if (mac_msg->pending_local_del)
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Intf up, Clear pending MAC: interface: %s, mac %s vlan-id %d, age_flag %d",
-                            mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
+                            ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
 
                     del_mac_from_chip(mac_msg);
 
@@ -1931,7 +2128,7 @@ static void update_l2_mac_state(struct CSM *csm,
                         mac_msg->op_type = MAC_SYNC_DEL;
                         if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                         {
-                            free(mac_msg);
+                            iccp_csm_free_mac_msg(mac_msg);
                         }
                     }
                     else
@@ -1945,13 +2142,13 @@ static void update_l2_mac_state(struct CSM *csm,
                 /*when this portchannel up, add the mac back to ASIC*/
                 ICCPD_LOG_DEBUG("ICCP_FDB", "Intf up, add MAC %s to ASIC,"
                     " vlan-id %d Interface %s", mac_addr_to_str(mac_msg->mac_addr),
-                    mac_msg->vid, mac_msg->ifname);
+                    mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
 
                 /*Remove MAC_AGE_LOCAL flag*/
                 mac_msg->age_flag = set_mac_local_age_flag(csm, mac_msg, 0, 1);
 
 
-                memcpy(mac_msg->ifname, mac_msg->origin_ifname, MAX_L_PORT_NAME);
+                mac_msg->ifname_id = mac_msg->origin_ifname_id;
 
                 /*Send dynamic or static mac add message to mclagsyncd*/
                 add_mac_to_chip(mac_msg, mac_msg->fdb_type);
@@ -1975,13 +2172,13 @@ void update_orphan_port_mac(struct CSM *csm,
     if (!state)
         return;
 
-    RB_FOREACH_SAFE (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb, mac_temp)
+    MAC_IF_FOREACH_SAFE (mac_msg, csm, lif->ifname_id, mac_temp)
     {
-        if (strcmp(mac_msg->origin_ifname, lif->name ) != 0)
+        if (mac_msg->origin_ifname_id != lif->ifname_id)
             continue;
 
         ICCPD_LOG_DEBUG("ICCP_FDB", "Orphan port is UP sync MAC: interface %s, "
-                "MAC %s vlan-id %d, age flag: %d, exchange state :%d", mac_msg->origin_ifname,
+                "MAC %s vlan-id %d, age flag: %d, exchange state :%d", ifname_from_id(mac_msg->origin_ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
                 mac_msg->age_flag, MLACP(csm).current_state);
 
@@ -2013,9 +2210,9 @@ void mlacp_convert_remote_mac_to_local(struct CSM *csm, char *po_name)
         return;
     }
 
-    RB_FOREACH_SAFE (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb, mac_temp)
+    MAC_IF_FOREACH_SAFE (mac_msg, csm, lif->ifname_id, mac_temp)
     {
-        if (strcmp(mac_msg->origin_ifname, po_name) != 0)
+        if (mac_msg->origin_ifname_id != lif->ifname_id)
             continue;
 
         // convert only remote macs.
@@ -2023,8 +2220,8 @@ void mlacp_convert_remote_mac_to_local(struct CSM *csm, char *po_name)
         {
             mac_msg->age_flag = MAC_AGE_PEER;
             ICCPD_LOG_DEBUG("ICCP_FDB", "Convert remote mac on Origin Interface as local: interface %s, "
-                    "interface %s, MAC %s vlan-id %d age flag:%d", mac_msg->origin_ifname,
-                    mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
+                    "interface %s, MAC %s vlan-id %d age flag:%d", ifname_from_id(mac_msg->origin_ifname_id),
+                    ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->age_flag);
 
             /*Send mac add message to mclagsyncd with aging enabled*/
             add_mac_to_chip(mac_msg, MAC_TYPE_DYNAMIC_LOCAL);
@@ -2042,15 +2239,15 @@ void mlacp_convert_remote_mac_to_local(struct CSM *csm, char *po_name)
 //update remote macs to point to peerlink, if peer link is configured
 static void update_remote_macs_to_peerlink(struct CSM *csm, struct LocalInterface *lif)
 {
-    struct MACMsg* mac_entry = NULL;
+    struct MACMsg* mac_entry = NULL, *mac_temp = NULL;
 
     if (!csm || !lif)
         return;
 
-    RB_FOREACH (mac_entry, mac_rb_tree, &MLACP(csm).mac_rb)
+    MAC_IF_FOREACH_SAFE (mac_entry, csm, lif->ifname_id, mac_temp)
     {
         /* find the MAC for this interface*/
-        if (strcmp(lif->name, mac_entry->origin_ifname) != 0)
+        if (lif->ifname_id != mac_entry->origin_ifname_id)
             continue;
 
         //consider only remote mac; rest of MACs no need to handle
@@ -2061,7 +2258,7 @@ static void update_remote_macs_to_peerlink(struct CSM *csm, struct LocalInterfac
 
         ICCPD_LOG_DEBUG("ICCP_FDB", "Update remote macs to peer: age flag %d, MAC %s, "
                 "vlan-id %d, Interface: %s", mac_entry->age_flag ,
-                mac_addr_to_str(mac_entry->mac_addr), mac_entry->vid, mac_entry->ifname);
+                mac_addr_to_str(mac_entry->mac_addr), mac_entry->vid, ifname_from_id(mac_entry->ifname_id));
 
         //If local interface unbinded, redirect the mac to peer-link if peer
         //link is configured
@@ -2072,13 +2269,13 @@ static void update_remote_macs_to_peerlink(struct CSM *csm, struct LocalInterfac
             {
                 //if the mac is already pointing to peer interface, no need to
                 //change it
-                if (strcmp(mac_entry->ifname, csm->peer_itf_name) != 0)
+                if (mac_entry->ifname_id != csm->peer_itf_id)
                 {
-                    memcpy(mac_entry->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                    mac_entry->ifname_id = csm->peer_itf_id;
                     add_mac_to_chip(mac_entry, mac_entry->fdb_type);
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Update remote macs to peer: age flag %d, "
                             "redirect MAC to peer-link: %s, MAC %s vlan-id %d",
-                            mac_entry->age_flag, mac_entry->ifname,
+                            mac_entry->age_flag, ifname_from_id(mac_entry->ifname_id),
                             mac_addr_to_str(mac_entry->mac_addr), mac_entry->vid);
                 }
             }
@@ -2318,11 +2515,11 @@ void mlacp_peer_disconn_fdb_handler(struct CSM* csm)
     RB_FOREACH_SAFE (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb, mac_temp)
     {
         ICCPD_LOG_DEBUG("ICCP_FDB", "ICCP session down: existing flag %d interface %s, MAC %s vlan-id %d,"
-                " pending_del %s", mac_msg->age_flag, mac_msg->ifname,
+                " pending_del %s", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
                 (mac_msg->pending_local_del) ? "true":"false");
 
-        if (strcmp(mac_msg->ifname, csm->peer_itf_name) == 0)
+        if (mac_msg->ifname_id == csm->peer_itf_id)
         {
             mac_msg->age_flag |= MAC_AGE_PEER;
 
@@ -2331,7 +2528,7 @@ void mlacp_peer_disconn_fdb_handler(struct CSM* csm)
             if ((mac_msg->age_flag == (MAC_AGE_LOCAL | MAC_AGE_PEER)) || mac_msg->pending_local_del)
             {
                 ICCPD_LOG_DEBUG("ICCP_FDB", "ICCP session down: del MAC pointing to peer_link for %s, "
-                    "MAC %s vlan-id %d", mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
+                    "MAC %s vlan-id %d", ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
 
                 /*Send mac del message to mclagsyncd, may be already deleted*/
                 del_mac_from_chip(mac_msg);
@@ -2341,7 +2538,7 @@ void mlacp_peer_disconn_fdb_handler(struct CSM* csm)
                 // else free is taken care after sending the update to peer
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
                 }
             }
         }
@@ -2352,7 +2549,7 @@ void mlacp_peer_disconn_fdb_handler(struct CSM* csm)
                 // MAC learned on both nodes convert to local not update to ASIC required.
                 mac_msg->age_flag = MAC_AGE_PEER;
                 ICCPD_LOG_DEBUG("ICCP_FDB", "ICCP session down: MAC learned on both nodes update to local only"
-                    " flag %d interface %s, MAC %s vlan-id %d", mac_msg->age_flag, mac_msg->ifname,
+                    " flag %d interface %s, MAC %s vlan-id %d", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                     mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
             }
             else if (mac_msg->age_flag == MAC_AGE_LOCAL)
@@ -2361,7 +2558,7 @@ void mlacp_peer_disconn_fdb_handler(struct CSM* csm)
                 add_mac_to_chip(mac_msg, MAC_TYPE_DYNAMIC_LOCAL);
                 mac_msg->age_flag = MAC_AGE_PEER;
                 ICCPD_LOG_DEBUG("ICCP_FDB", "ICCP session down: MAC is remote convert to local"
-                    " flag %d interface %s, MAC %s vlan-id %d", mac_msg->age_flag, mac_msg->ifname,
+                    " flag %d interface %s, MAC %s vlan-id %d", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                     mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
             }
             //else MAC is local (mac_msg->age_flag == MAC_AGE_PEER) no changes required
@@ -2478,11 +2675,11 @@ void mlacp_peerlink_up_handler(struct CSM* csm)
     RB_FOREACH (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb)
     {
         /* Find the MAC that the port is peer-link to be added*/
-        if (strcmp(mac_msg->ifname, csm->peer_itf_name) != 0)
+        if (mac_msg->ifname_id != csm->peer_itf_id)
             continue;
 
         ICCPD_LOG_DEBUG("ICCP_FDB", "Peer link up, add MAC to ASIC for peer-link: %s, "
-                "MAC %s vlan-id %d", mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
+                "MAC %s vlan-id %d", ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
 
         /*Send mac add message to mclagsyncd, local age flag is already set*/
         add_mac_to_chip(mac_msg, mac_msg->fdb_type);
@@ -2506,14 +2703,14 @@ void mlacp_peerlink_down_handler(struct CSM* csm)
     RB_FOREACH_SAFE (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb, mac_temp)
     {
         /* Find the MAC that the port is peer-link to be deleted*/
-        if (strcmp(mac_msg->ifname, csm->peer_itf_name) != 0)
+        if (mac_msg->ifname_id != csm->peer_itf_id)
             continue;
 
         if (!mac_msg->pending_local_del)
             mac_msg->age_flag = set_mac_local_age_flag(csm, mac_msg, 1, 1);
 
         ICCPD_LOG_DEBUG("ICCP_FDB", "Peer link down, del MAC for peer-link: %s,"
-            " MAC %s vlan-id %d", mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
+            " MAC %s vlan-id %d", ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
 
         /*Send mac del message to mclagsyncd*/
         del_mac_from_chip(mac_msg);
@@ -2528,7 +2725,7 @@ void mlacp_peerlink_down_handler(struct CSM* csm)
             // else free is taken care after sending the update to peer
             if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
             {
-                free(mac_msg);
+                iccp_csm_free_mac_msg(mac_msg);
             }
         }
     }
@@ -2632,6 +2829,7 @@ int iccp_connect_syncd()
 
     ICCPD_LOG_NOTICE(__FUNCTION__, "Success to link syncd");
     sys->sync_fd = fd;
+    syncd_tx_queue_reset(sys);
 
     event.data.fd = fd;
     event.events = EPOLLIN;
@@ -2664,6 +2862,7 @@ void syncd_info_close()
         close(sys->sync_fd);
         sys->sync_fd = -1;
     }
+    syncd_tx_queue_reset(sys);
 
     return;
 }
@@ -2775,7 +2974,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
         mac_exist = 1;
         ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: RB_FIND success for the MAC entry : %s, "
             " vid: %d , ifname %s, type: %d, age flag: %d", mac_addr_to_str(mac_info->mac_addr),
-            mac_info->vid, mac_info->ifname, mac_info->fdb_type, mac_info->age_flag );
+            mac_info->vid, ifname_from_id(mac_info->ifname_id), mac_info->fdb_type, mac_info->age_flag );
     }
 
     /*handle mac add*/
@@ -2789,14 +2988,14 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
             return;
         }
 
-        sprintf(mac_msg->ifname, "%s", ifname);
-        sprintf(mac_msg->origin_ifname, "%s", ifname);
+        mac_msg->ifname_id = mac_lif->ifname_id;
+        mac_msg->origin_ifname_id = mac_lif->ifname_id;
 
         /*If the recv mac port is peer-link, no need to handle*/
-        if (strcmp(csm->peer_itf_name, mac_msg->ifname) == 0)
+        if (mac_msg->ifname_id == csm->peer_itf_id)
         {
             ICCPD_LOG_DEBUG("ICCP_FDB", "MAC learn received on peer_link %s ignore MAC %s vlan %d",
-                mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
+                ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
             return;
         }
 
@@ -2804,7 +3003,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
         if (mac_exist)
         {
             /*If the current mac port is peer-link, it will handle by port up event*/
-            /*if(strcmp(csm->peer_itf_name, mac_info->ifname) == 0)
+            /*if(mac_info->ifname_id == csm->peer_itf_id)
                {
                 return;
                }*/
@@ -2812,7 +3011,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
             {
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: MAC add received, "
                     "MAC exists interface %s down, MAC %s vlan %d, is mclag interface : %s ",
-                    mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
+                    ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
                     from_mclag_intf ? "true":"false" );
 
                 // if from mclag intf update mac to point to peer_link.
@@ -2821,15 +3020,15 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: MAC add received, "
                         "MAC exists interface %s down, point to peer link MAC %s, vlan %d, is pending local del : %s ",
-                        mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
+                        ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
                         mac_info->pending_local_del ? "true":"false" );
 
                     mac_info->pending_local_del = 1;
                     mac_info->fdb_type = mac_msg->fdb_type;
-                    memcpy(&mac_info->origin_ifname, mac_msg->ifname, MAX_L_PORT_NAME);
+                    mlacp_mac_set_origin(csm, mac_info, mac_msg->ifname_id);
 
                     //existing mac must be pointing to peer_link, else update if info and send to syncd
-                    if (strcmp(mac_info->ifname, csm->peer_itf_name) == 0)
+                    if (mac_info->ifname_id == csm->peer_itf_id)
                     {
                         add_mac_to_chip(mac_info, mac_msg->fdb_type);
                     }
@@ -2837,7 +3036,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                     {
                         // this for the case of MAC move , existing mac may point to different interface.
                         // need to update the ifname and update to syncd.
-                        memcpy(&mac_info->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_info->ifname_id = csm->peer_itf_id;
                         add_mac_to_chip(mac_info, mac_msg->fdb_type);
                     }
 
@@ -2850,24 +3049,24 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
 
             /* update MAC*/
             if (mac_info->fdb_type != mac_msg->fdb_type
-                || strcmp(mac_info->ifname, mac_msg->ifname) != 0
-                || strcmp(mac_info->origin_ifname, mac_msg->ifname) != 0)
+                || mac_info->ifname_id != mac_msg->ifname_id
+                || mac_info->origin_ifname_id != mac_msg->ifname_id)
             {
                 mac_info->fdb_type = mac_msg->fdb_type;
-                sprintf(mac_info->ifname, "%s", mac_msg->ifname);
-                sprintf(mac_info->origin_ifname, "%s", mac_msg->ifname);
+                mac_info->ifname_id = mac_msg->ifname_id;
+                mlacp_mac_set_origin(csm, mac_info, mac_msg->ifname_id);
 
                 /*Remove MAC_AGE_LOCAL flag*/
                 mac_info->age_flag = set_mac_local_age_flag(csm, mac_info, 0, 1);
 
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Update MAC %s, vlan %d ifname %s",
-                    mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->ifname);
+                    mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
                 // MAC is local now Del entry from MCLAG_FDB_TABLE if peer not aged.
                 if (!(mac_msg->age_flag & MAC_AGE_PEER))
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", " MAC update from mclagsyncd: MAC move Update MAC remote to local %s, vlan %d"
                             " ifname %s, del entry from MCLAG_FDB_TABLE",
-                            mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->ifname);
+                            mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
 		    mac_info->age_flag = MAC_AGE_PEER;
                     del_mac_from_chip(mac_msg);
                 }
@@ -2878,13 +3077,13 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                 /*In theory, this will be happened that mac age and then learn*/
                 mac_info->age_flag = set_mac_local_age_flag(csm, mac_info, 0, 1);
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Duplicate update MAC %s, vlan %d ifname %s",
-                        mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->ifname);
+                        mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
                 // MAC is local now Del entry from MCLAG_FDB_TABLE if peer not aged.
                 if (!(mac_msg->age_flag & MAC_AGE_PEER))
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Update MAC remote to local %s, vlan %d"
                             " ifname %s, del entry from MCLAG_FDB_TABLE",
-                            mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->ifname);
+                            mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
                     del_mac_from_chip(mac_msg);
                 }
                 return;
@@ -2918,7 +3117,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
             /*set MAC_AGE_PEER flag before send this item to peer*/
             mac_msg->age_flag |= MAC_AGE_PEER;
             ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Add peer age flag, age %d interface %s, "
-                "MAC %s vlan-id %d ", mac_msg->age_flag, mac_msg->ifname,
+                "MAC %s vlan-id %d ", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
             mac_msg->op_type = MAC_SYNC_ADD;
 
@@ -2926,9 +3125,10 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
             if (iccp_csm_init_mac_msg(&new_mac_msg, (char*)mac_msg, msg_len) == 0)
             {
                 RB_INSERT(mac_rb_tree, &MLACP(csm).mac_rb, new_mac_msg);
+                mlacp_mac_index_add(csm, new_mac_msg);
 
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: MAC-list enqueue interface %s, "
-                        "MAC %s vlan-id %d", mac_msg->ifname,
+                        "MAC %s vlan-id %d", ifname_from_id(mac_msg->ifname_id),
                         mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
 
                 //if port is down do not sync the MAC.
@@ -2939,27 +3139,28 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                     if (from_mclag_intf && pif && (pif->state == PORT_STATE_UP))
                     {
                         mac_msg->pending_local_del = 1;
-                        memcpy(&mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_msg->ifname_id = csm->peer_itf_id;
                         add_mac_to_chip(mac_msg, mac_msg->fdb_type);
                         ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: mclag interface %s down, MAC %s,"
                            " vlan %d point to peer link %s", ifname, mac_addr_to_str(mac_msg->mac_addr),
-                           mac_msg->vid, mac_msg->ifname);
+                           mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
                     }
                     return;
                 }
 
                 if ((MLACP(csm).current_state == MLACP_STATE_EXCHANGE))
                 {
+                    new_mac_msg->trace_usec = system_latency_queue_stamp();
                     TAILQ_INSERT_TAIL(&(MLACP(csm).mac_msg_list), new_mac_msg, tail);
 
                     ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: MAC-msg-list enqueue interface %s, "
-                        "MAC %s vlan-id %d, age_flag %d", new_mac_msg->ifname,
+                        "MAC %s vlan-id %d, age_flag %d", ifname_from_id(new_mac_msg->ifname_id),
                         mac_addr_to_str(new_mac_msg->mac_addr), new_mac_msg->vid, new_mac_msg->age_flag);
                 }
             }
             else
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Failed to enqueue interface %s, MAC %s vlan-id %d",
-                    mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
+                    ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
         }
     }
     else/*handle mac del*/
@@ -2968,13 +3169,13 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
         if (mac_exist)
         {
             /*orphan port mac or origin from_mclag_intf but state is down*/
-            if (strcmp(mac_info->ifname, csm->peer_itf_name) == 0)
+            if (mac_info->ifname_id == csm->peer_itf_id)
             {
                 if (mac_info->pending_local_del)
                 {
                     //do not delete the MAC.
                     ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: do not del pending MAC on %s(peer-link), "
-                        "MAC %s vlan-id %d", mac_info->ifname,
+                        "MAC %s vlan-id %d", ifname_from_id(mac_info->ifname_id),
                         mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
                     return;
                 }
@@ -2984,7 +3185,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                 if (mac_info->age_flag == (MAC_AGE_LOCAL | MAC_AGE_PEER))
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Recv MAC del interface %s(peer-link), "
-                        "MAC %s vlan-id %d", mac_info->ifname,
+                        "MAC %s vlan-id %d", ifname_from_id(mac_info->ifname_id),
                         mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
 
                     if (mac_info->add_to_syncd)
@@ -2999,7 +3200,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                     // else free is taken care after sending the update to peer
                     if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_info, tail))
                     {
-                        free(mac_info);
+                        iccp_csm_free_mac_msg(mac_info);
                     }
                 }
                 else if (csm->peer_link_if && csm->peer_link_if->state != PORT_STATE_DOWN)
@@ -3008,7 +3209,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                     add_mac_to_chip(mac_info, mac_info->fdb_type);
 
                     ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Recv MAC del interface %s(peer-link is up), "
-                        "add back MAC %s vlan-id %d", mac_info->ifname,
+                        "add back MAC %s vlan-id %d", ifname_from_id(mac_info->ifname_id),
                         mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
                 }
 
@@ -3021,7 +3222,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
             if (mac_info->age_flag == (MAC_AGE_LOCAL | MAC_AGE_PEER))
             {
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Recv MAC del interface %s, "
-                    "MAC %s vlan-id %d", mac_info->ifname,
+                    "MAC %s vlan-id %d", ifname_from_id(mac_info->ifname_id),
                     mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
 
                 //before removing the MAC send del to syncd if added before.
@@ -3036,28 +3237,28 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                 // else free is taken care after sending the update to peer
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_info, tail))
                 {
-                    free(mac_info);
+                    iccp_csm_free_mac_msg(mac_info);
                 }
             }
             else
             {
                 ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Recv MAC del interface %s, "
                     "MAC %s vlan-id %d, peer is not age, add back to chip",
-                    mac_info->ifname, mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
+                    ifname_from_id(mac_info->ifname_id), mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
 
                 if (from_mclag_intf && lif_po && lif_po->state == PORT_STATE_DOWN)
                 {
                     /*If local if is down, redirect the mac to peer-link*/
                     if (strlen(csm->peer_itf_name) != 0)
                     {
-                        memcpy(&mac_info->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_info->ifname_id = csm->peer_itf_id;
 
                         if (csm->peer_link_if && csm->peer_link_if->state == PORT_STATE_UP)
                         {
                             add_mac_to_chip(mac_info, mac_info->fdb_type);
                             ICCPD_LOG_DEBUG("ICCP_FDB", "MAC update from mclagsyncd: Recv MAC del interface %s(down), "
                                 "MAC %s vlan-id %d, redirect to peer-link",
-                                mac_info->ifname, mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
+                                ifname_from_id(mac_info->ifname_id), mac_addr_to_str(mac_info->mac_addr), mac_info->vid);
                         }
                     }
 
@@ -3067,7 +3268,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                 /*If local is aged but peer is not aged, Send mac add message to mclagsyncd*/
                 /*it is from_mclag_intf and port state is up, local orphan mac can not be here*/
                 /* Find local itf*/
-                if (!(mac_lif = local_if_find_by_name(mac_info->ifname)))
+                if (!(mac_lif = local_if_find_by_name(ifname_from_id(mac_info->ifname_id))))
                     return;
                 if (mac_lif->state == PORT_STATE_UP)
                     add_mac_to_chip(mac_info, mac_info->fdb_type);
@@ -3366,6 +3567,10 @@ int iccp_receive_fdb_handler_from_syncd(struct System *sys, char *msg_buf)
         mac_info = (struct mclag_fdb_info *)&msg_buf[sizeof(struct IccpSyncdHDr )+ i * sizeof(struct mclag_fdb_info)];
 
         do_mac_update_from_syncd(mac_info->mac, mac_info->vid, mac_info->port_name, mac_info->type, mac_info->op_type);
+
+        /* A full receive buffer holds many thousands of entries */
+        if ((i + 1) % SYNCD_RX_FDB_HEARTBEAT_INTERVAL == 0)
+            scheduler_heartbeat_service();
     }
     return 0;
 }
@@ -3685,6 +3890,9 @@ char * mclagd_ctl_cmd_str(int req_type)
         case INFO_TYPE_DUMP_DBG_COUNTERS:
             return "dump debug counters";
 
+        case INFO_TYPE_DUMP_DBG_LATENCY:
+            return "dump debug latency";
+
         case INFO_TYPE_DUMP_UNIQUE_IP:
             return "dump unique_ip";
 
@@ -3768,60 +3976,206 @@ int mclagd_ctl_sock_accept(int fd)
     return client_fd;
 }
 
-int mclagd_ctl_sock_read(int fd, char *r_buf, int total_len)
+/*****************************************
+* mclagdctl clients
+*
+* Requests are read and replies written without
+* blocking, several clients are served at once.
+* A reply is built in one go when the request is
+* complete, so it is a consistent snapshot.
+* ***************************************/
+static struct mclagd_ctl_client* mclagd_ctl_client_find(int fd)
 {
-    int read_len = 0;
-    int ret = 0;
-    struct timeval tv = { 0 };
-    fd_set read_fd;
+    struct mclagd_ctl_client* client = NULL;
 
-    while (read_len < total_len)
+    LIST_FOREACH(client, &g_mclagd_ctl_client_list, next)
     {
-        FD_ZERO(&read_fd);
-        FD_SET(fd, &read_fd);
-        tv.tv_sec = 5;
-        tv.tv_usec = 0;
+        if (client->fd == fd)
+            return client;
+    }
 
-        switch ((ret = select(fd + 1, &read_fd, NULL, NULL, &tv)))
-        {
-            case -1:
-            /* error*/
-            case 0:
-                /* timeout*/
-                return MCLAG_ERROR;
+    return NULL;
+}
 
-            default:
-                break;
-        }
+static void mclagd_ctl_client_close(struct mclagd_ctl_client* client)
+{
+    struct System* sys = NULL;
 
-        if (FD_ISSET(fd, &read_fd))
-            ret = read(fd, r_buf + read_len, total_len - read_len);
-        if (ret <= 0)
+    if ((sys = system_get_instance()) != NULL)
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+
+    scheduler_timer_stop(&client->timer);
+    close(client->fd);
+    LIST_REMOVE(client, next);
+    --g_mclagd_ctl_client_count;
+
+    if (client->reply)
+        free(client->reply);
+    free(client);
+}
+
+static void mclagd_ctl_client_timeout(struct SchedTimer* timer)
+{
+    struct mclagd_ctl_client* client = (struct mclagd_ctl_client*)timer->arg;
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "mclagdctl client fd %d timeout, %s %d/%d bytes",
+                     client->fd, client->reply ? "reply" : "request",
+                     client->reply ? client->reply_pos : client->req_len,
+                     client->reply ? client->reply_len : (int)sizeof(struct mclagdctl_req_hdr));
+    mclagd_ctl_client_close(client);
+}
+
+int mclagd_ctl_client_add(int client_fd)
+{
+    struct System* sys = NULL;
+    struct mclagd_ctl_client* client = NULL;
+    struct epoll_event event;
+
+    if ((sys = system_get_instance()) == NULL)
+    {
+        close(client_fd);
+        return MCLAG_ERROR;
+    }
+
+    if (g_mclagd_ctl_client_count >= MCLAGD_CTL_CLIENT_MAX)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Too many mclagdctl clients, reject fd %d", client_fd);
+        close(client_fd);
+        return MCLAG_ERROR;
+    }
+
+    client = (struct mclagd_ctl_client*)calloc(1, sizeof(struct mclagd_ctl_client));
+    if (client == NULL)
+    {
+        close(client_fd);
+        return MCLAG_ERROR;
+    }
+
+    fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
+
+    event.data.fd = client_fd;
+    event.events = EPOLLIN;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, client_fd, &event) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to add mclagdctl client fd %d, errno %d", client_fd, errno);
+        free(client);
+        close(client_fd);
+        return MCLAG_ERROR;
+    }
+
+    client->fd = client_fd;
+    scheduler_timer_init(&client->timer, mclagd_ctl_client_timeout, client);
+    scheduler_timer_start(&client->timer, MCLAGD_CTL_CLIENT_TIMEOUT_MSEC);
+    LIST_INSERT_HEAD(&g_mclagd_ctl_client_list, client, next);
+    ++g_mclagd_ctl_client_count;
+
+    return 0;
+}
+
+/* Write as much of the reply as the socket takes, close when done */
+static void mclagd_ctl_client_flush(struct mclagd_ctl_client* client)
+{
+    struct System* sys = NULL;
+    struct epoll_event event;
+    ssize_t ret;
+
+    while (client->reply_pos < client->reply_len)
+    {
+        ret = write(client->fd, client->reply + client->reply_pos, client->reply_len - client->reply_pos);
+        if (ret < 0)
         {
-            return MCLAG_ERROR;
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            mclagd_ctl_client_close(client);
+            return;
         }
-        read_len += ret;
+        client->reply_pos += ret;
     }
 
-    return read_len;
+    if (client->reply_pos >= client->reply_len)
+    {
+        mclagd_ctl_client_close(client);
+        return;
+    }
+
+    if (!client->wait_out && (sys = system_get_instance()) != NULL)
+    {
+        event.data.fd = client->fd;
+        event.events = EPOLLOUT;
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+        client->wait_out = 1;
+    }
+    scheduler_timer_start(&client->timer, MCLAGD_CTL_CLIENT_TIMEOUT_MSEC);
+}
+
+/* Hand a malloc'ed reply over to the client */
+static void mclagd_ctl_client_set_reply(int fd, char* buf, int len)
+{
+    struct mclagd_ctl_client* client = mclagd_ctl_client_find(fd);
+
+    if (client == NULL || client->reply)
+    {
+        free(buf);
+        return;
+    }
+
+    client->reply = buf;
+    client->reply_len = len;
+    client->reply_pos = 0;
 }
 
 int mclagd_ctl_sock_write(int fd, char *w_buf, int total_len)
 {
-    int write_len = 0;
-    int ret = 0;
+    char* reply = NULL;
+
+    reply = (char*)malloc(total_len);
+    if (reply == NULL)
+        return 0;
+
+    memcpy(reply, w_buf, total_len);
+    mclagd_ctl_client_set_reply(fd, reply, total_len);
 
-    while (write_len < total_len)
+    return total_len;
+}
+
+/* Keep entries of a dump matching the interface/vlan filter of the request */
+static int mclagd_ctl_dump_filter(char *entries, int num, size_t entry_size,
+                                  size_t ifname_offset, int vid_offset, struct mclagdctl_req_hdr *req)
+{
+    unsigned short entry_vid;
+    int vid = 0;
+    int i;
+    int kept = 0;
+
+    if (req->para1[0] == '\0' && req->para2[0] == '\0')
+        return num;
+
+    if (vid_offset >= 0 && req->para2[0] != '\0')
+        vid = atoi(req->para2);
+
+    for (i = 0; i < num; ++i)
     {
-        ret = write(fd, w_buf + write_len, total_len - write_len);
-        if (ret <= 0)
+        char *entry = entries + i * entry_size;
+
+        if (req->para1[0] != '\0'
+            && strncmp(entry + ifname_offset, req->para1, MCLAGDCTL_MAX_L_PORT_NANE) != 0)
+            continue;
+
+        if (vid > 0)
         {
-            return 0;
+            memcpy(&entry_vid, entry + vid_offset, sizeof(entry_vid));
+            if (entry_vid != vid)
+                continue;
         }
-        write_len += ret;
+
+        if (kept != i)
+            memcpy(entries + kept * entry_size, entry, entry_size);
+        ++kept;
     }
 
-    return write_len;
+    return kept;
 }
 
 void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
@@ -3856,15 +4210,12 @@ void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
 
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
 
-void mclagd_ctl_handle_dump_arp(int client_fd, int mclag_id)
+void mclagd_ctl_handle_dump_arp(int client_fd, struct mclagdctl_req_hdr *req)
 {
     char * Pbuf = NULL;
     char buf[512] = { 0 };
@@ -3873,7 +4224,7 @@ void mclagd_ctl_handle_dump_arp(int client_fd, int mclag_id)
     struct mclagd_reply_hdr *hd = NULL;
     int len_tmp = 0;
 
-    ret = iccp_arp_dump(&Pbuf, &arp_num, mclag_id);
+    ret = iccp_arp_dump(&Pbuf, &arp_num, req->mclag_id);
     if (ret != EXEC_TYPE_SUCCESS)
     {
         len_tmp = sizeof(struct mclagd_reply_hdr);
@@ -3893,18 +4244,17 @@ void mclagd_ctl_handle_dump_arp(int client_fd, int mclag_id)
     hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
     hd->exec_result = EXEC_TYPE_SUCCESS;
     hd->info_type = INFO_TYPE_DUMP_ARP;
+    arp_num = mclagd_ctl_dump_filter(Pbuf + MCLAGD_REPLY_INFO_HDR, arp_num, sizeof(struct mclagd_arp_msg),
+                                     offsetof(struct mclagd_arp_msg, ifname), -1, req);
     hd->data_len = arp_num * sizeof(struct mclagd_arp_msg);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
 
-void mclagd_ctl_handle_dump_ndisc(int client_fd, int mclag_id)
+void mclagd_ctl_handle_dump_ndisc(int client_fd, struct mclagdctl_req_hdr *req)
 {
     char *Pbuf = NULL;
     char buf[512] = { 0 };
@@ -3913,7 +4263,7 @@ void mclagd_ctl_handle_dump_ndisc(int client_fd, int mclag_id)
     struct mclagd_reply_hdr *hd = NULL;
     int len_tmp = 0;
 
-    ret = iccp_ndisc_dump(&Pbuf, &ndisc_num, mclag_id);
+    ret = iccp_ndisc_dump(&Pbuf, &ndisc_num, req->mclag_id);
     if (ret != EXEC_TYPE_SUCCESS)
     {
         len_tmp = sizeof(struct mclagd_reply_hdr);
@@ -3933,18 +4283,17 @@ void mclagd_ctl_handle_dump_ndisc(int client_fd, int mclag_id)
     hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
     hd->exec_result = EXEC_TYPE_SUCCESS;
     hd->info_type = INFO_TYPE_DUMP_NDISC;
+    ndisc_num = mclagd_ctl_dump_filter(Pbuf + MCLAGD_REPLY_INFO_HDR, ndisc_num, sizeof(struct mclagd_ndisc_msg),
+                                     offsetof(struct mclagd_ndisc_msg, ifname), -1, req);
     hd->data_len = ndisc_num * sizeof(struct mclagd_ndisc_msg);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
 
-void mclagd_ctl_handle_dump_mac(int client_fd, int mclag_id)
+void mclagd_ctl_handle_dump_mac(int client_fd, struct mclagdctl_req_hdr *req)
 {
     char * Pbuf = NULL;
     char buf[512] = { 0 };
@@ -3953,7 +4302,7 @@ void mclagd_ctl_handle_dump_mac(int client_fd, int mclag_id)
     struct mclagd_reply_hdr *hd = NULL;
     int len_tmp = 0;
 
-    ret = iccp_mac_dump(&Pbuf, &mac_num, mclag_id);
+    ret = iccp_mac_dump(&Pbuf, &mac_num, req->mclag_id);
     if (ret != EXEC_TYPE_SUCCESS)
     {
         len_tmp = sizeof(struct mclagd_reply_hdr);
@@ -3973,15 +4322,15 @@ void mclagd_ctl_handle_dump_mac(int client_fd, int mclag_id)
     hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
     hd->exec_result = EXEC_TYPE_SUCCESS;
     hd->info_type = INFO_TYPE_DUMP_MAC;
+    mac_num = mclagd_ctl_dump_filter(Pbuf + MCLAGD_REPLY_INFO_HDR, mac_num, sizeof(struct mclagd_mac_msg),
+                                     offsetof(struct mclagd_mac_msg, ifname),
+                                     offsetof(struct mclagd_mac_msg, vid), req);
     hd->data_len = mac_num * sizeof(struct mclagd_mac_msg);
 
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
 
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
@@ -4018,10 +4367,7 @@ void mclagd_ctl_handle_dump_local_portlist(int client_fd, int mclag_id)
     hd->data_len = lif_num * sizeof(struct mclagd_local_if);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
@@ -4058,10 +4404,7 @@ void mclagd_ctl_handle_dump_peer_portlist(int client_fd, int mclag_id)
     hd->data_len = pif_num * sizeof(struct mclagd_peer_if);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
@@ -4097,10 +4440,41 @@ void mclagd_ctl_handle_dump_dbg_counters(int client_fd, int mclag_id)
     hd->data_len = data_len;
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+}
+
+void mclagd_ctl_handle_dump_dbg_latency(int client_fd)
+{
+    char * Pbuf = NULL;
+    char buf[512] = {0};
+    int data_len = 0;
+    int ret = 0;
+    struct mclagd_reply_hdr *hd = NULL;
+    int len_tmp = 0;
 
-    if (Pbuf)
-       free(Pbuf);
+    ret = iccp_cmd_dbg_latency_dump(&Pbuf, &data_len);
+    if (ret != EXEC_TYPE_SUCCESS)
+    {
+        len_tmp = sizeof(struct mclagd_reply_hdr);
+        memcpy(buf, &len_tmp, sizeof(int));
+        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
+        hd->exec_result = ret;
+        hd->info_type = INFO_TYPE_DUMP_DBG_LATENCY;
+        hd->data_len = 0;
+        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+
+        if (Pbuf)
+            free(Pbuf);
+        return;
+    }
+
+    hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
+    hd->exec_result = EXEC_TYPE_SUCCESS;
+    hd->info_type = INFO_TYPE_DUMP_DBG_LATENCY;
+    hd->data_len = data_len;
+    len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
+    memcpy(Pbuf, &len_tmp, sizeof(int));
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 }
 
 void mclagd_ctl_handle_dump_unique_ip(int client_fd, int mclag_id)
@@ -4135,10 +4509,7 @@ void mclagd_ctl_handle_dump_unique_ip(int client_fd, int mclag_id)
     hd->data_len = lif_num * sizeof(struct mclagd_unique_ip_if);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    mclagd_ctl_client_set_reply(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     return;
 }
@@ -4162,23 +4533,8 @@ void mclagd_ctl_handle_config_loglevel(int client_fd, int log_level)
     return;
 }
 
-int mclagd_ctl_interactive_process(int client_fd)
+static int mclagd_ctl_interactive_process(int client_fd, struct mclagdctl_req_hdr* req)
 {
-    char buf[512] = { 0 };
-    int ret = 0;
-
-    struct mclagdctl_req_hdr* req = NULL;
-
-    if (client_fd < 0)
-        return MCLAG_ERROR;
-
-    ret = mclagd_ctl_sock_read(client_fd, buf, sizeof(struct mclagdctl_req_hdr));
-
-    if (ret < 0)
-        return MCLAG_ERROR;
-
-    req = (struct mclagdctl_req_hdr*)buf;
-
     ICCPD_LOG_DEBUG(__FUNCTION__, "Receive request %s from mclagdctl", mclagd_ctl_cmd_str(req->info_type));
 
     switch (req->info_type)
@@ -4188,15 +4544,15 @@ int mclagd_ctl_interactive_process(int client_fd)
             break;
 
         case INFO_TYPE_DUMP_ARP:
-            mclagd_ctl_handle_dump_arp(client_fd, req->mclag_id);
+            mclagd_ctl_handle_dump_arp(client_fd, req);
             break;
 
         case INFO_TYPE_DUMP_NDISC:
-            mclagd_ctl_handle_dump_ndisc(client_fd, req->mclag_id);
+            mclagd_ctl_handle_dump_ndisc(client_fd, req);
             break;
 
         case INFO_TYPE_DUMP_MAC:
-            mclagd_ctl_handle_dump_mac(client_fd, req->mclag_id);
+            mclagd_ctl_handle_dump_mac(client_fd, req);
             break;        
 
         case INFO_TYPE_DUMP_LOCAL_PORTLIST:
@@ -4211,6 +4567,10 @@ int mclagd_ctl_interactive_process(int client_fd)
              mclagd_ctl_handle_dump_dbg_counters(client_fd, req->mclag_id);
             break;
 
+        case INFO_TYPE_DUMP_DBG_LATENCY:
+            mclagd_ctl_handle_dump_dbg_latency(client_fd);
+            break;
+
         case INFO_TYPE_DUMP_UNIQUE_IP:
             mclagd_ctl_handle_dump_unique_ip(client_fd, req->mclag_id);
             break;
@@ -4226,6 +4586,52 @@ int mclagd_ctl_interactive_process(int client_fd)
     return 0;
 }
 
+/* Handle epoll event of a mclagdctl client, return 0 if fd is no client */
+int mclagd_ctl_client_handler(int fd, uint32_t events)
+{
+    struct mclagd_ctl_client* client = NULL;
+    int req_size = sizeof(struct mclagdctl_req_hdr);
+    ssize_t ret;
+
+    if ((client = mclagd_ctl_client_find(fd)) == NULL)
+        return 0;
+
+    if (client->reply)
+    {
+        if (events & (EPOLLERR | EPOLLHUP))
+            mclagd_ctl_client_close(client);
+        else
+            mclagd_ctl_client_flush(client);
+        return 1;
+    }
+
+    while (client->req_len < req_size)
+    {
+        ret = read(fd, client->req_buf + client->req_len, req_size - client->req_len);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 1;
+        if (ret <= 0)
+        {
+            mclagd_ctl_client_close(client);
+            return 1;
+        }
+        client->req_len += ret;
+    }
+
+    if (mclagd_ctl_interactive_process(fd, (struct mclagdctl_req_hdr*)client->req_buf) < 0
+        || client->reply == NULL)
+    {
+        mclagd_ctl_client_close(client);
+        return 1;
+    }
+
+    mclagd_ctl_client_flush(client);
+
+    return 1;
+}
+
 int syn_local_mac_info_to_peer(struct CSM* csm, struct LocalInterface *local_if, int sync_add, int is_sag)
 {
     struct MACMsg mac_msg = {0};
@@ -4257,10 +4663,10 @@ int syn_local_mac_info_to_peer(struct CSM* csm, struct LocalInterface *local_if,
 
     mac_msg.vid = vid;
     mac_msg.fdb_type = MAC_TYPE_STATIC;
-    memcpy(mac_msg.origin_ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+    mac_msg.origin_ifname_id = csm->peer_itf_id;
     memcpy(mac_msg.mac_addr, MLACP(csm).system_id, ETHER_ADDR_LEN);
 
-    ICCPD_LOG_DEBUG(__FUNCTION__,"add %d, mac name %s, vid %d", sync_add, mac_msg.origin_ifname, mac_msg.vid);
+    ICCPD_LOG_DEBUG(__FUNCTION__,"add %d, mac name %s, vid %d", sync_add, ifname_from_id(mac_msg.origin_ifname_id), mac_msg.vid);
     ICCPD_LOG_DEBUG(__FUNCTION__,"mac [%02X:%02X:%02X:%02X:%02X:%02X]",
         mac_msg.mac_addr[0], mac_msg.mac_addr[1], mac_msg.mac_addr[2], mac_msg.mac_addr[3], mac_msg.mac_addr[4], mac_msg.mac_addr[5]);
 
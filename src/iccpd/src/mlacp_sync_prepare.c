@@ -146,6 +146,47 @@ int mlacp_prepare_for_sync_data_tlv(struct CSM* csm, char* buf, size_t max_buf_s
     return msg_len;
 }
 
+/*****************************************
+* Append Sync Digest TLV to the message of msg_len
+* in buf, after a sync request or a sync start
+*
+* ***************************************/
+int mlacp_prepare_for_sync_digest_tlv(struct CSM* csm, char* buf, size_t max_buf_size, size_t msg_len, int delta)
+{
+    ICCHdr* icc_hdr = (ICCHdr*)buf;
+    mLACPSyncDigestTLV* tlv = NULL;
+
+    if (csm == NULL)
+        return MCLAG_ERROR;
+
+    if (buf == NULL)
+        return MCLAG_ERROR;
+
+    if (msg_len + sizeof(mLACPSyncDigestTLV) > max_buf_size)
+        return MCLAG_ERROR;
+
+    tlv = (mLACPSyncDigestTLV*)&buf[msg_len];
+    memset(tlv, 0, sizeof(mLACPSyncDigestTLV));
+    msg_len += sizeof(mLACPSyncDigestTLV);
+    icc_hdr->ldp_hdr.msg_len = htons(msg_len - MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS);
+
+    tlv->icc_parameter.u_bit = 0;
+    tlv->icc_parameter.f_bit = 0;
+    tlv->icc_parameter.type = htons(TLV_T_MLACP_SYNC_DIGEST);
+    tlv->icc_parameter.len = htons(sizeof(mLACPSyncDigestTLV) - sizeof(ICCParameter));
+
+    tlv->flags = delta ? MLACP_SYNC_DIGEST_F_DELTA : 0;
+    tlv->sync_gen = htonl(MLACP(csm).sync_gen);
+    tlv->arp_count = htonl(MLACP(csm).arp_digest.count);
+    tlv->arp_sum = htonl(MLACP(csm).arp_digest.sum);
+    tlv->ndisc_count = htonl(MLACP(csm).ndisc_digest.count);
+    tlv->ndisc_sum = htonl(MLACP(csm).ndisc_digest.sum);
+
+    ICCPD_LOG_DEBUG("ICCP_CSM", "TX sync digest: gen %u, ARP %u, ND %u, delta %d",
+        MLACP(csm).sync_gen, MLACP(csm).arp_digest.count, MLACP(csm).ndisc_digest.count, delta);
+    return msg_len;
+}
+
 /*****************************************
 * Prprare Sync System-Config TLV
 *
@@ -318,6 +359,10 @@ int mlacp_prepare_for_mac_info_to_peer(struct CSM* csm, char* buf, size_t max_bu
     if ((msg_len = sizeof(ICCHdr) + tlv_len) > max_buf_size)
         return MCLAG_ERROR;
 
+    /* Buffer is reused across entries, only clear what is written */
+    if (count == 0)
+        memset(buf, 0, sizeof(ICCHdr) + sizeof(struct mLACPMACInfoTLV));
+
     /* ICC header */
     icc_hdr = (ICCHdr*)buf;
     mlacp_fill_icc_header(csm, icc_hdr, msg_len);
@@ -334,13 +379,14 @@ int mlacp_prepare_for_mac_info_to_peer(struct CSM* csm, char* buf, size_t max_bu
     }
 
     MacData = (struct mLACPMACData *)&buf[sizeof(ICCHdr) + sizeof(struct mLACPMACInfoTLV) + sizeof(struct mLACPMACData) * count];
+    memset(MacData, 0, sizeof(struct mLACPMACData));
     MacData->type = mac_msg->op_type;
     MacData->mac_type = mac_msg->fdb_type;
     memcpy(MacData->mac_addr, mac_msg->mac_addr,ETHER_ADDR_LEN);
-    sprintf(MacData->ifname, "%s", mac_msg->origin_ifname);
+    sprintf(MacData->ifname, "%s", ifname_from_id(mac_msg->origin_ifname_id));
     MacData->vid = htons(mac_msg->vid);
 
-    ICCPD_LOG_DEBUG("ICCP_FDB", "Send MAC messge to peer, port %s  mac = %s, vid = %d, type = %s count %d ", mac_msg->origin_ifname,
+    ICCPD_LOG_DEBUG("ICCP_FDB", "Send MAC messge to peer, port %s  mac = %s, vid = %d, type = %s count %d ", ifname_from_id(mac_msg->origin_ifname_id),
                                   mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->op_type == MAC_SYNC_ADD ? "add" : "del", count);
 
     return msg_len;
@@ -368,6 +414,10 @@ int mlacp_prepare_for_arp_info(struct CSM* csm, char* buf, size_t max_buf_size,
     if ((msg_len = sizeof(ICCHdr) + tlv_len) > max_buf_size)
         return MCLAG_ERROR;
 
+    /* Buffer is reused across entries, only clear what is written */
+    if (count == 0)
+        memset(buf, 0, sizeof(ICCHdr) + sizeof(struct mLACPARPInfoTLV));
+
     /* ICC header */
     icc_hdr = (ICCHdr*)buf;
     mlacp_fill_icc_header(csm, icc_hdr, msg_len);
@@ -385,6 +435,7 @@ int mlacp_prepare_for_arp_info(struct CSM* csm, char* buf, size_t max_buf_size,
     }
 
     ArpData = (struct ARPMsg *)&buf[sizeof(ICCHdr) + sizeof(struct mLACPARPInfoTLV) + sizeof(struct ARPMsg) * count];
+    memset(ArpData, 0, sizeof(struct ARPMsg));
 
     ArpData->op_type = arp_msg->op_type;
     ArpData->flag = arp_msg->flag;
@@ -421,6 +472,10 @@ int mlacp_prepare_for_ndisc_info(struct CSM *csm, char *buf, size_t max_buf_size
     if ((msg_len = sizeof(ICCHdr) + tlv_len) > max_buf_size)
         return -1;
 
+    /* Buffer is reused across entries, only clear what is written */
+    if (count == 0)
+        memset(buf, 0, sizeof(ICCHdr) + sizeof(struct mLACPNDISCInfoTLV));
+
     /* ICC header */
     icc_hdr = (ICCHdr *)buf;
     mlacp_fill_icc_header(csm, icc_hdr, msg_len);
@@ -438,6 +493,7 @@ int mlacp_prepare_for_ndisc_info(struct CSM *csm, char *buf, size_t max_buf_size
     }
 
     NdiscData = (struct NDISCMsg *)&buf[sizeof(ICCHdr) + sizeof(struct mLACPNDISCInfoTLV) + sizeof(struct NDISCMsg) * count];
+    memset(NdiscData, 0, sizeof(struct NDISCMsg));
 
     NdiscData->op_type = ndisc_msg->op_type;
     NdiscData->flag = ndisc_msg->flag;
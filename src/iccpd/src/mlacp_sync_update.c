@@ -33,6 +33,7 @@
 #include "../include/mlacp_link_handler.h"
 #include "../include/iccp_netlink.h"
 #include "../include/iccp_consistency_check.h"
+#include "../include/mlacp_sync_update.h"
 #include "../include/port.h"
 #include "../include/openbsd_tree.h"
 
@@ -220,6 +221,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
     struct MACMsg mac_data, mac_find;
     struct LocalInterface* local_if = NULL;
     uint8_t from_mclag_intf = 0;/*0: orphan port, 1: MCLAG port*/
+    uint16_t ifname_id = 0;
     memset(&mac_data, 0, sizeof(struct MACMsg));
     memset(&mac_find, 0, sizeof(struct MACMsg));
     uint8_t null_mac[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
@@ -235,11 +237,24 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
         return 0;
     }
 
+    /* Only names of known interfaces are interned, so the peer can't use up
+     * the interface ids. The name is not needed to delete a MAC */
+    if (strnlen(MacData->ifname, MAX_L_PORT_NAME) < MAX_L_PORT_NAME
+        && (local_if = local_if_find_by_name(MacData->ifname)) != NULL)
+    {
+        ifname_id = local_if->ifname_id;
+    }
+    else if (MacData->type == MAC_SYNC_ADD)
+    {
+        ICCPD_LOG_WARN("ICCP_FDB", "Ignore MAC ADD from peer on unknown interface %.*s, MAC %s vlan-id %d",
+            MAX_L_PORT_NAME, MacData->ifname, mac_addr_to_str(MacData->mac_addr), ntohs(MacData->vid));
+        return 0;
+    }
 
     /*Find the interface in MCLAG interface list*/
     LIST_FOREACH(local_if, &(MLACP(csm).lif_list), mlacp_next)
     {
-        if (local_if->type == IF_T_PORT_CHANNEL && strcmp(local_if->name, MacData->ifname) == 0)
+        if (local_if->type == IF_T_PORT_CHANNEL && local_if->ifname_id == ifname_id)
         {
             from_mclag_intf = 1;
             break;
@@ -255,7 +270,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
     if (mac_msg)
     {
         ICCPD_LOG_DEBUG("ICCP_FDB", "Recv MAC update from peer RB_FIND success, existing MAC age flag:%d interface %s, "
-            "MAC %s vlan-id %d, fdb_type: %d, op_type %s", mac_msg->age_flag, mac_msg->ifname,
+            "MAC %s vlan-id %d, fdb_type: %d, op_type %s", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
             mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->fdb_type,
             (mac_msg->op_type == MAC_SYNC_ADD) ? "add":"del");
 
@@ -279,23 +294,23 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
             }
 
             ICCPD_LOG_DEBUG("ICCP_FDB", "Recv ADD, Remove peer age flag:%d interface %s, "
-                "MAC %s vlan-id %d, op_type %s, from_mclag_intf: %d ", mac_msg->age_flag, mac_msg->ifname,
+                "MAC %s vlan-id %d, op_type %s, from_mclag_intf: %d ", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
                 (mac_msg->op_type == MAC_SYNC_ADD) ? "add":"del", from_mclag_intf);
 
             /*mac_msg->fdb_type = tlv->fdb_type;*/
             /*The port ifname is different to the local item*/
-            if (strcmp(mac_msg->ifname, MacData->ifname) != 0 || strcmp(mac_msg->origin_ifname, MacData->ifname) != 0)
+            if (mac_msg->ifname_id != ifname_id || mac_msg->origin_ifname_id != ifname_id)
             {
                 if (mac_msg->fdb_type != MAC_TYPE_STATIC)
                 {
                     /*Update local item*/
-                    memcpy(&mac_msg->origin_ifname, MacData->ifname, MAX_L_PORT_NAME);
+                    mlacp_mac_set_origin(csm, mac_msg, ifname_id);
                 }
                 else
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Ignore Recv MAC ADD, Local static present,"
-                        " interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                        " interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                         mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                     //set back the peer age flag
                     mac_msg->age_flag |= MAC_AGE_PEER;
@@ -310,11 +325,11 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
 
                     if (strlen(csm->peer_itf_name) != 0)
                     {
-                        if (strcmp(mac_msg->ifname, csm->peer_itf_name) == 0)
+                        if (mac_msg->ifname_id == csm->peer_itf_id)
                         {
                             /*This MAC is already point to peer-link*/
                             ICCPD_LOG_NOTICE("ICCP_FDB", "Remote MAC ADD local IF down, MAC already points to Peer_link done processing "
-                                " interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                                " interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                             return 0;
                         }
@@ -322,25 +337,25 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                         if (csm->peer_link_if && (csm->peer_link_if->state == PORT_STATE_UP))
                         {
                             /*Redirect the mac to peer-link*/
-                            memcpy(&mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                            mac_msg->ifname_id = csm->peer_itf_id;
 
                             /*Send mac add message to mclagsyncd*/
                             add_mac_to_chip(mac_msg, mac_msg->fdb_type);
 
                             ICCPD_LOG_DEBUG("ICCP_FDB", "Remote MAC ADD , local mac exist move to peer link up "
-                                " interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                                " interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
 
                         }
                         else
                         {
                             /*Redirect the mac to peer-link, if peerlink is down FdbOrch deletes MAC*/
-                            memcpy(&mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                            mac_msg->ifname_id = csm->peer_itf_id;
 
                             add_mac_to_chip(mac_msg, mac_msg->fdb_type);
 
                             ICCPD_LOG_DEBUG("ICCP_FDB", "Remote MAC ADD , local mac exist move to peer link down "
-                                    " interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                                    " interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                                     mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                         }
                     }
@@ -350,7 +365,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                         del_mac_from_chip(mac_msg);
 
                         /*Update local item*/
-                        memcpy(&mac_msg->ifname, MacData->ifname, MAX_L_PORT_NAME);
+                        mac_msg->ifname_id = ifname_id;
 
                         /*if orphan port mac but no peerlink, don't keep this mac*/
                         if (from_mclag_intf == 0)
@@ -361,12 +376,12 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                             // else free is taken care after sending the update to peer
                             if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                             {
-                                free(mac_msg);
+                                iccp_csm_free_mac_msg(mac_msg);
                             }
 
                             ICCPD_LOG_ERR(__FUNCTION__, "Ignore Recv MAC ADD "
                                 "MAC %s vlan %d interface %s peer link not available ",
-                                mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->ifname);
+                                mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, ifname_from_id(mac_msg->ifname_id));
                             return 0;
                         }
                     }
@@ -374,22 +389,22 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                 else
                 {
                     /*Update local item*/
-                    memcpy(&mac_msg->ifname, MacData->ifname, MAX_L_PORT_NAME);
+                    mac_msg->ifname_id = ifname_id;
 
                     /*from MCLAG port and the local port is up, add mac to ASIC to update port*/
                     add_mac_to_chip(mac_msg, mac_msg->fdb_type);
                 }
             }
-	    else if(!from_mclag_intf && (strcmp(mac_msg->ifname, MacData->ifname) == 0))
+	    else if(!from_mclag_intf && (mac_msg->ifname_id == ifname_id))
             {
                 // local to remote MAC move on Orphan port.
                 if (strlen(csm->peer_itf_name) != 0)
                 {
-                    if (strcmp(mac_msg->ifname, csm->peer_itf_name) == 0)
+                    if (mac_msg->ifname_id == csm->peer_itf_id)
                     {
                         /*This MAC is already point to peer-link*/
                         ICCPD_LOG_DEBUG("ICCP_FDB", "Remote MAC ADD learn on Orphan port ,MAC already points to Peer_link"
-                            " interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                            " interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                             mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                         return 0;
                     }
@@ -397,10 +412,10 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                     if (csm->peer_link_if && csm->peer_link_if->state == PORT_STATE_UP)
                     {
                         /*Redirect the mac to peer-link*/
-                        memcpy(&mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_msg->ifname_id = csm->peer_itf_id;
 
                         ICCPD_LOG_DEBUG("ICCP_FDB", "Remote MAC ADD learn on Orphan port ,point MAC address to Peer_link"
-                            "interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                            "interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                             mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                         /*Send mac add message to mclagsyncd*/
                         add_mac_to_chip(mac_msg, mac_msg->fdb_type);
@@ -409,11 +424,11 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                     {
                         /*Redirect the mac to peer-link*/
                          /*must redirect but if peerlink is down FdbOrch will delete MAC */
-                        memcpy(&mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                        mac_msg->ifname_id = csm->peer_itf_id;
                         add_mac_to_chip(mac_msg, mac_msg->fdb_type);
 
                         ICCPD_LOG_DEBUG("ICCP_FDB", "Remote MAC ADD learn on Orphan port ,point MAC address to Peer_link"
-                            " peer link is down, delete the MAC, interface  %s, MAC %s vlan-id %d ", mac_msg->ifname,
+                            " peer link is down, delete the MAC, interface  %s, MAC %s vlan-id %d ", ifname_from_id(mac_msg->ifname_id),
                             mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid);
                     }
                 }
@@ -427,7 +442,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                 /*Reply mac ack message to peer, peer will clean MAC_AGE_PEER flag*/
                 TAILQ_INSERT_TAIL(&(MLACP(csm).mac_msg_list), msg_send, tail);
                 ICCPD_LOG_DEBUG(__FUNCTION__, "Recv ADD, MAC-msg-list enqueue: %s, "
-                    "add %s vlan-id %d, op_type %d", mac_msg->ifname,
+                    "add %s vlan-id %d, op_type %d", ifname_from_id(mac_msg->ifname_id),
                     mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->op_type);
             }
             #endif
@@ -439,7 +454,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
             /*Clean the MAC_AGE_PEER flag*/
             mac_msg->age_flag &= ~MAC_AGE_PEER;
             ICCPD_LOG_DEBUG(__FUNCTION__, "Recv ACK, Remove peer age flag:%d ifname  %s, "
-                "add %s vlan-id %d, op_type %d", mac_msg->age_flag, mac_msg->ifname,
+                "add %s vlan-id %d, op_type %d", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
                 mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->op_type);
         }
         #endif
@@ -451,7 +466,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
     {
         mac_msg->age_flag |= MAC_AGE_PEER;
         ICCPD_LOG_DEBUG("ICCP_FDB", "Recv MAC DEL from peer: Add peer age flag: %d interface %s, "
-            "MAC %s vlan %d, op_type %s", mac_msg->age_flag, mac_msg->ifname,
+            "MAC %s vlan %d, op_type %s", mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id),
             mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid,
             (mac_msg->op_type == MAC_SYNC_ADD) ? "add":"del");
 
@@ -467,7 +482,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
             // else free is taken care after sending the update to peer
             if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
             {
-                free(mac_msg);
+                iccp_csm_free_mac_msg(mac_msg);
             }
         }
         else
@@ -481,8 +496,8 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
         mac_msg->fdb_type = MacData->mac_type;
         mac_msg->vid = ntohs(MacData->vid);
         memcpy(mac_msg->mac_addr, MacData->mac_addr, ETHER_ADDR_LEN);
-        sprintf(mac_msg->ifname, "%s", MacData->ifname);
-        sprintf(mac_msg->origin_ifname, "%s", MacData->ifname);
+        mac_msg->ifname_id = ifname_id;
+        mac_msg->origin_ifname_id = ifname_id;
         mac_msg->age_flag = 0;
 
         /*Set MAC_AGE_LOCAL flag*/
@@ -500,7 +515,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                 {
                     ICCPD_LOG_DEBUG("ICCP_FDB", "Recv MAC ADD from peer: Ignore MAC learn on orphan port "
                         "peer-link is not configured interface %s, MAC %s vlan-id %d, "
-                        " op_type %d", from_mclag_intf, mac_msg->ifname,
+                        " op_type %d", from_mclag_intf, ifname_from_id(mac_msg->ifname_id),
                         mac_addr_to_str(mac_msg->mac_addr),
                         mac_msg->vid, mac_msg->op_type);
                     return 0;
@@ -509,11 +524,11 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
             else
             {
                 /*Redirect the mac to peer-link*/
-                memcpy(&mac_msg->ifname, csm->peer_itf_name, MAX_L_PORT_NAME);
+                mac_msg->ifname_id = csm->peer_itf_id;
 
                 ICCPD_LOG_DEBUG("ICCP_FDB", "Recv MAC ADD from peer: Redirect to peerlink for orphan port or portchannel is down,"
                     " age flag: %d interface %s, MAC %s vlan %d, op_type %d",
-                    mac_msg->age_flag, mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr),
+                    mac_msg->age_flag, ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr),
                     mac_msg->vid, mac_msg->op_type);
             }
         }
@@ -522,9 +537,10 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
         {
             /*ICCPD_LOG_INFO(__FUNCTION__, "add mac queue successfully");*/
             RB_INSERT(mac_rb_tree, &MLACP(csm).mac_rb, new_mac_msg);
+            mlacp_mac_index_add(csm, new_mac_msg);
 
             /*If the mac is from orphan port, or from MCLAG port but the local port is down*/
-            if (strcmp(mac_msg->ifname, csm->peer_itf_name) == 0)
+            if (mac_msg->ifname_id == csm->peer_itf_id)
             {
                 /*Send mac add message to mclagsyncd*/
                 if (csm->peer_link_if && csm->peer_link_if->state == PORT_STATE_UP)
@@ -543,7 +559,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                 /*Reply mac ack message to peer, peer will clean MAC_AGE_PEER flag*/
                 TAILQ_INSERT_TAIL(&(MLACP(csm).mac_msg_list), msg_send, tail);
                 ICCPD_LOG_DEBUG(__FUNCTION__, "MAC-msg-list enqueue: %s, add %s vlan-id %d, op_type %d",
-                    mac_msg->ifname, mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->op_type);
+                    ifname_from_id(mac_msg->ifname_id), mac_addr_to_str(mac_msg->mac_addr), mac_msg->vid, mac_msg->op_type);
             }
             #endif
         }
@@ -568,6 +584,375 @@ int mlacp_fsm_update_mac_info_from_peer(struct CSM* csm, struct mLACPMACInfoTLV*
     }
 }
 
+/*****************************************
+ * Tool : ARP/ND table index hashes
+ *
+ ****************************************/
+static unsigned int mlacp_neigh_word_hash(uint32_t hash, uint32_t word)
+{
+    hash ^= word;
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+static unsigned int mlacp_neigh_ipv4_hash(uint32_t ipv4_addr)
+{
+    return mlacp_neigh_word_hash(0, ipv4_addr) & (NEIGH_IP_HASH_SIZE - 1);
+}
+
+static unsigned int mlacp_neigh_ipv6_hash(const uint32_t *ipv6_addr)
+{
+    uint32_t hash = 0;
+    int i;
+
+    for (i = 0; i < 4; i++)
+        hash = mlacp_neigh_word_hash(hash, ipv6_addr[i]);
+
+    return hash & (NEIGH_IP_HASH_SIZE - 1);
+}
+
+unsigned int mlacp_neigh_if_hash(const char *ifname)
+{
+    unsigned int hash = 5381;
+
+    while (*ifname)
+        hash = hash * 33 + (unsigned char)*ifname++;
+
+    return hash & (NEIGH_IF_HASH_SIZE - 1);
+}
+
+/*****************************************
+ * Tool : Reset ARP/ND table indexes, after
+ * arp_list and ndisc_list are flushed
+ *
+ ****************************************/
+void mlacp_neigh_index_reinit(struct CSM* csm)
+{
+    int i;
+
+    for (i = 0; i < NEIGH_IP_HASH_SIZE; i++)
+    {
+        LIST_INIT(&(MLACP(csm).arp_ip_hash[i]));
+        LIST_INIT(&(MLACP(csm).ndisc_ip_hash[i]));
+    }
+    for (i = 0; i < NEIGH_IF_HASH_SIZE; i++)
+    {
+        LIST_INIT(&(MLACP(csm).arp_if_hash[i]));
+        LIST_INIT(&(MLACP(csm).ndisc_if_hash[i]));
+    }
+
+    return;
+}
+
+/*****************************************
+ * Tool : MAC table index by origin interface,
+ * an entry is indexed while it is in mac_rb,
+ * MAC_RB_REMOVE takes it out of the index
+ *
+ ****************************************/
+void mlacp_mac_index_add(struct CSM* csm, struct MACMsg* mac_msg)
+{
+    LIST_INSERT_HEAD(&(MLACP(csm).mac_if_hash[MAC_IF_HASH(mac_msg->origin_ifname_id)]), mac_msg, mac_if_next);
+
+    return;
+}
+
+void mlacp_mac_set_origin(struct CSM* csm, struct MACMsg* mac_msg, uint16_t origin_ifname_id)
+{
+    if (mac_msg->origin_ifname_id == origin_ifname_id)
+        return;
+
+    mac_msg->origin_ifname_id = origin_ifname_id;
+    if (mac_msg->mac_if_next.le_prev == NULL)
+        return;
+
+    LIST_REMOVE(mac_msg, mac_if_next);
+    mlacp_mac_index_add(csm, mac_msg);
+
+    return;
+}
+
+/* Reset the index, after mac_rb is emptied */
+void mlacp_mac_index_reinit(struct CSM* csm)
+{
+    int i;
+
+    for (i = 0; i < MAC_IF_HASH_SIZE; i++)
+        LIST_INIT(&(MLACP(csm).mac_if_hash[i]));
+
+    return;
+}
+
+/*****************************************
+ * Tool : ARP/ND sync digests. An entry is marked
+ * with the digest of the content sent to or
+ * received from the peer, an entry whose content
+ * no longer matches its mark is resent on resync
+ *
+ ****************************************/
+static uint32_t mlacp_neigh_digest(const uint8_t *addr, size_t addr_len, const uint8_t *mac_addr, const char *ifname)
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < addr_len; i++)
+        hash = (hash ^ addr[i]) * 16777619u;
+    for (i = 0; i < ETHER_ADDR_LEN; i++)
+        hash = (hash ^ mac_addr[i]) * 16777619u;
+    for (i = 0; i < MAX_L_PORT_NAME && ifname[i]; i++)
+        hash = (hash ^ (uint8_t)ifname[i]) * 16777619u;
+
+    /* 0 marks an entry never exchanged */
+    return hash ? hash : 1;
+}
+
+uint32_t mlacp_arp_digest(const struct ARPMsg *arp_msg)
+{
+    return mlacp_neigh_digest((const uint8_t *)&arp_msg->ipv4_addr, sizeof(arp_msg->ipv4_addr),
+                              arp_msg->mac_addr, arp_msg->ifname);
+}
+
+uint32_t mlacp_ndisc_digest(const struct NDISCMsg *ndisc_msg)
+{
+    return mlacp_neigh_digest((const uint8_t *)ndisc_msg->ipv6_addr, sizeof(ndisc_msg->ipv6_addr),
+                              ndisc_msg->mac_addr, ndisc_msg->ifname);
+}
+
+void mlacp_neigh_sync_mark(struct mLACPSyncDigest *digest, struct Msg *msg, uint32_t entry_digest)
+{
+    if (msg->sync_digest)
+        digest->sum -= msg->sync_digest;
+    else
+        digest->count++;
+
+    msg->sync_digest = entry_digest;
+    digest->sum += entry_digest;
+
+    return;
+}
+
+/* Only for entries the peer is told to delete, others stay in the
+ * digest as the peer keeps them */
+void mlacp_neigh_sync_unmark(struct mLACPSyncDigest *digest, struct Msg *msg)
+{
+    if (msg->sync_digest == 0)
+        return;
+
+    digest->sum -= msg->sync_digest;
+    digest->count--;
+    msg->sync_digest = 0;
+
+    return;
+}
+
+/* Forget what was exchanged, before a full sync */
+void mlacp_neigh_sync_reset(struct CSM* csm)
+{
+    struct Msg* msg = NULL;
+
+    TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+        msg->sync_digest = 0;
+    TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_list), tail)
+        msg->sync_digest = 0;
+
+    memset(&MLACP(csm).arp_digest, 0, sizeof(struct mLACPSyncDigest));
+    memset(&MLACP(csm).ndisc_digest, 0, sizeof(struct mLACPSyncDigest));
+    MLACP(csm).sync_gen = 0;
+
+    return;
+}
+
+/*****************************************
+ * Tool : Find ARP Info in ARP list by IP
+ *
+ ****************************************/
+struct Msg* mlacp_arp_find(struct CSM* csm, uint32_t ipv4_addr)
+{
+    struct Msg* msg = NULL;
+    struct ARPMsg *arp_msg = NULL;
+
+    LIST_FOREACH(msg, &(MLACP(csm).arp_ip_hash[mlacp_neigh_ipv4_hash(ipv4_addr)]), neigh_ip_next)
+    {
+        arp_msg = (struct ARPMsg*)msg->buf;
+        if (arp_msg->ipv4_addr == ipv4_addr)
+            return msg;
+    }
+
+    return NULL;
+}
+
+/*****************************************
+ * Tool : Find Ndisc Info in ndisc list by IP
+ *
+ ****************************************/
+struct Msg* mlacp_ndisc_find(struct CSM *csm, const uint32_t *ipv6_addr)
+{
+    struct Msg *msg = NULL;
+    struct NDISCMsg *ndisc_msg = NULL;
+
+    LIST_FOREACH(msg, &(MLACP(csm).ndisc_ip_hash[mlacp_neigh_ipv6_hash(ipv6_addr)]), neigh_ip_next)
+    {
+        ndisc_msg = (struct NDISCMsg *)msg->buf;
+        if (memcmp((char *)ndisc_msg->ipv6_addr, (char *)ipv6_addr, 16) == 0)
+            return msg;
+    }
+
+    return NULL;
+}
+
+/*****************************************
+ * Tool : Move ARP Info to another interface
+ *
+ ****************************************/
+void mlacp_arp_set_ifname(struct CSM* csm, struct Msg* msg, const char *ifname)
+{
+    struct ARPMsg *arp_msg = (struct ARPMsg*)msg->buf;
+
+    if (strcmp(arp_msg->ifname, ifname) == 0)
+        return;
+
+    LIST_REMOVE(msg, neigh_if_next);
+    snprintf(arp_msg->ifname, MAX_L_PORT_NAME, "%s", ifname);
+    LIST_INSERT_HEAD(&(MLACP(csm).arp_if_hash[mlacp_neigh_if_hash(arp_msg->ifname)]), msg, neigh_if_next);
+
+    return;
+}
+
+/*****************************************
+ * Tool : Move Ndisc Info to another interface
+ *
+ ****************************************/
+void mlacp_ndisc_set_ifname(struct CSM *csm, struct Msg *msg, const char *ifname)
+{
+    struct NDISCMsg *ndisc_msg = (struct NDISCMsg *)msg->buf;
+
+    if (strcmp(ndisc_msg->ifname, ifname) == 0)
+        return;
+
+    LIST_REMOVE(msg, neigh_if_next);
+    snprintf(ndisc_msg->ifname, MAX_L_PORT_NAME, "%s", ifname);
+    LIST_INSERT_HEAD(&(MLACP(csm).ndisc_if_hash[mlacp_neigh_if_hash(ndisc_msg->ifname)]), msg, neigh_if_next);
+
+    return;
+}
+
+/*****************************************
+ * Tool : Remove ARP Info from ARP list and free it
+ *
+ ****************************************/
+void mlacp_dequeue_arp(struct CSM* csm, struct Msg* msg)
+{
+    TAILQ_REMOVE(&(MLACP(csm).arp_list), msg, tail);
+    /* deletes are sent to the peer in exchange state only*/
+    if (MLACP(csm).current_state == MLACP_STATE_EXCHANGE)
+        mlacp_neigh_sync_unmark(&MLACP(csm).arp_digest, msg);
+    LIST_REMOVE(msg, neigh_ip_next);
+    LIST_REMOVE(msg, neigh_if_next);
+    iccp_csm_free_msg(msg);
+
+    return;
+}
+
+/*****************************************
+ * Tool : Remove Ndisc Info from ndisc list and free it
+ *
+ ****************************************/
+void mlacp_dequeue_ndisc(struct CSM *csm, struct Msg *msg)
+{
+    TAILQ_REMOVE(&(MLACP(csm).ndisc_list), msg, tail);
+    /* deletes are sent to the peer in exchange state only*/
+    if (MLACP(csm).current_state == MLACP_STATE_EXCHANGE)
+        mlacp_neigh_sync_unmark(&MLACP(csm).ndisc_digest, msg);
+    LIST_REMOVE(msg, neigh_ip_next);
+    LIST_REMOVE(msg, neigh_if_next);
+    iccp_csm_free_msg(msg);
+
+    return;
+}
+
+/*****************************************
+ * Tool : Drop a neighbor the kernel refused to add
+ *
+ * The entry and its queued advertisements are removed so that the peer
+ * is not told about it. The peer still counts it in the sync digest,
+ * the digest resync offers it again.
+ ****************************************/
+void mlacp_neigh_add_failed(int family, const uint8_t *addr, const uint8_t *mac_addr, const char *ifname)
+{
+    struct System *sys = NULL;
+    struct CSM *csm = NULL;
+    struct Msg *msg = NULL;
+    struct Msg *next = NULL;
+    struct ARPMsg *arp_msg = NULL;
+    struct NDISCMsg *ndisc_msg = NULL;
+    uint32_t ipv4_addr;
+
+    if (!(sys = system_get_instance()))
+        return;
+
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+    {
+        if (family == AF_INET)
+        {
+            memcpy(&ipv4_addr, addr, sizeof(ipv4_addr));
+            msg = mlacp_arp_find(csm, ipv4_addr);
+            if (!msg)
+                continue;
+
+            arp_msg = (struct ARPMsg*)msg->buf;
+            if (arp_msg->op_type == NEIGH_SYNC_DEL || strcmp(arp_msg->ifname, ifname) != 0
+                || memcmp(arp_msg->mac_addr, mac_addr, ETHER_ADDR_LEN) != 0)
+                continue;
+
+            ICCPD_LOG_NOTICE(__FUNCTION__, "Drop ARP entry %s %s, kernel add failed",
+                             ifname, show_ip_str(ipv4_addr));
+            mlacp_dequeue_arp(csm, msg);
+
+            for (msg = TAILQ_FIRST(&(MLACP(csm).arp_msg_list)); msg; msg = next)
+            {
+                next = TAILQ_NEXT(msg, tail);
+                arp_msg = (struct ARPMsg*)msg->buf;
+                if (arp_msg->ipv4_addr == ipv4_addr && arp_msg->op_type == NEIGH_SYNC_ADD)
+                {
+                    TAILQ_REMOVE(&(MLACP(csm).arp_msg_list), msg, tail);
+                    iccp_csm_free_msg(msg);
+                }
+            }
+        }
+        else
+        {
+            msg = mlacp_ndisc_find(csm, (const uint32_t *)addr);
+            if (!msg)
+                continue;
+
+            ndisc_msg = (struct NDISCMsg *)msg->buf;
+            if (ndisc_msg->op_type == NEIGH_SYNC_DEL || strcmp(ndisc_msg->ifname, ifname) != 0
+                || memcmp(ndisc_msg->mac_addr, mac_addr, ETHER_ADDR_LEN) != 0)
+                continue;
+
+            ICCPD_LOG_NOTICE(__FUNCTION__, "Drop ND entry %s %s, kernel add failed",
+                             ifname, show_ipv6_str((char *)addr));
+            mlacp_dequeue_ndisc(csm, msg);
+
+            for (msg = TAILQ_FIRST(&(MLACP(csm).ndisc_msg_list)); msg; msg = next)
+            {
+                next = TAILQ_NEXT(msg, tail);
+                ndisc_msg = (struct NDISCMsg *)msg->buf;
+                if (memcmp(ndisc_msg->ipv6_addr, addr, 16) == 0 && ndisc_msg->op_type == NEIGH_SYNC_ADD)
+                {
+                    TAILQ_REMOVE(&(MLACP(csm).ndisc_msg_list), msg, tail);
+                    iccp_csm_free_msg(msg);
+                }
+            }
+        }
+    }
+
+    return;
+}
+
 /*****************************************
  * Tool : Add ARP Info into ARP list
  *
@@ -589,6 +974,8 @@ void mlacp_enqueue_arp(struct CSM* csm, struct Msg* msg)
     if (arp_msg->op_type != NEIGH_SYNC_DEL)
     {
         TAILQ_INSERT_TAIL(&(MLACP(csm).arp_list), msg, tail);
+        LIST_INSERT_HEAD(&(MLACP(csm).arp_ip_hash[mlacp_neigh_ipv4_hash(arp_msg->ipv4_addr)]), msg, neigh_ip_next);
+        LIST_INSERT_HEAD(&(MLACP(csm).arp_if_hash[mlacp_neigh_if_hash(arp_msg->ifname)]), msg, neigh_if_next);
     }
 
     return;
@@ -615,6 +1002,8 @@ void mlacp_enqueue_ndisc(struct CSM *csm, struct Msg *msg)
     if (ndisc_msg->op_type != NEIGH_SYNC_DEL)
     {
         TAILQ_INSERT_TAIL(&(MLACP(csm).ndisc_list), msg, tail);
+        LIST_INSERT_HEAD(&(MLACP(csm).ndisc_ip_hash[mlacp_neigh_ipv6_hash(ndisc_msg->ipv6_addr)]), msg, neigh_ip_next);
+        LIST_INSERT_HEAD(&(MLACP(csm).ndisc_if_hash[mlacp_neigh_if_hash(ndisc_msg->ifname)]), msg, neigh_if_next);
     }
 
     return;
@@ -795,14 +1184,13 @@ int mlacp_fsm_update_arp_entry(struct CSM* csm, struct ARPMsg *arp_entry)
 
         if (arp_entry->op_type == NEIGH_SYNC_ADD)
         {
+            /* Kernel errors show up when the request completes, see mlacp_neigh_add_failed() */
             err = iccp_netlink_neighbor_request(AF_INET, (uint8_t *)&arp_entry->ipv4_addr, 1, arp_entry->mac_addr, arp_entry->ifname, permanent_neigh, 8);
             if (err < 0)
             {
-                if (err != ICCP_NLE_SEQ_MISMATCH) {
-                    ICCPD_LOG_ERR(__FUNCTION__, "ARP add failure for %s %s %s, status %d",
-                                arp_entry->ifname, show_ip_str(arp_entry->ipv4_addr), mac_str, err);
-                    return MCLAG_ERROR;
-                }
+                ICCPD_LOG_ERR(__FUNCTION__, "ARP add request failure for %s %s %s, status %d",
+                              arp_entry->ifname, show_ip_str(arp_entry->ipv4_addr), mac_str, err);
+                return MCLAG_ERROR;
             }
 
            if (arp_entry->flag & NEIGH_SYNC_FLAG_ACK)
@@ -816,11 +1204,9 @@ int mlacp_fsm_update_arp_entry(struct CSM* csm, struct ARPMsg *arp_entry)
             err = iccp_netlink_neighbor_request(AF_INET, (uint8_t *)&arp_entry->ipv4_addr, 0, arp_entry->mac_addr, arp_entry->ifname, permanent_neigh, 9);
             if (err < 0)
             {
-                if (err != ICCP_NLE_SEQ_MISMATCH) {
-                    ICCPD_LOG_ERR(__FUNCTION__, "ARP delete failure for %s %s %s, status %d",
-                                arp_entry->ifname, show_ip_str(arp_entry->ipv4_addr), mac_str, err);
-                    return MCLAG_ERROR;
-                }
+                ICCPD_LOG_ERR(__FUNCTION__, "ARP delete request failure for %s %s %s, status %d",
+                              arp_entry->ifname, show_ip_str(arp_entry->ipv4_addr), mac_str, err);
+                return MCLAG_ERROR;
             }
         }
 
@@ -841,24 +1227,19 @@ int mlacp_fsm_update_arp_entry(struct CSM* csm, struct ARPMsg *arp_entry)
     }
 
     /* update ARP list*/
-    TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+    msg = mlacp_arp_find(csm, arp_entry->ipv4_addr);
+    if (msg)
     {
         arp_msg = (struct ARPMsg*)msg->buf;
-        if (arp_msg->ipv4_addr == arp_entry->ipv4_addr)
-        {
-            /*arp_msg->op_type = tlv->type;*/
-            sprintf(arp_msg->ifname, "%s", arp_entry->ifname);
-            memcpy(arp_msg->mac_addr, arp_entry->mac_addr, ETHER_ADDR_LEN);
-            break;
-        }
+        /*arp_msg->op_type = tlv->type;*/
+        mlacp_arp_set_ifname(csm, msg, arp_entry->ifname);
+        memcpy(arp_msg->mac_addr, arp_entry->mac_addr, ETHER_ADDR_LEN);
     }
 
     /* delete/add ARP list*/
     if (msg && arp_entry->op_type == NEIGH_SYNC_DEL)
     {
-        TAILQ_REMOVE(&(MLACP(csm).arp_list), msg, tail);
-        free(msg->buf);
-        free(msg);
+        mlacp_dequeue_arp(csm, msg);
         /*ICCPD_LOG_INFO(__FUNCTION__, "Del arp queue successfully");*/
     }
     else if (!msg && arp_entry->op_type == NEIGH_SYNC_ADD)
@@ -877,6 +1258,10 @@ int mlacp_fsm_update_arp_entry(struct CSM* csm, struct ARPMsg *arp_entry)
         }
     }
 
+    /* the peer has this content now*/
+    if (msg && arp_entry->op_type == NEIGH_SYNC_ADD)
+        mlacp_neigh_sync_mark(&MLACP(csm).arp_digest, msg, mlacp_arp_digest(arp_entry));
+
     /* remove all ARP msg queue, when receive peer's ARP list at the same time*/
     TAILQ_FOREACH(msg, &(MLACP(csm).arp_msg_list), tail)
     {
@@ -1118,14 +1503,13 @@ int mlacp_fsm_update_ndisc_entry(struct CSM *csm, struct NDISCMsg *ndisc_entry)
 
         if (ndisc_entry->op_type == NEIGH_SYNC_ADD)
         {
+            /* Kernel errors show up when the request completes, see mlacp_neigh_add_failed() */
             err = iccp_netlink_neighbor_request(AF_INET6, (uint8_t *)ndisc_entry->ipv6_addr, 1, ndisc_entry->mac_addr, ndisc_entry->ifname, permanent_neigh, 10);
             if (err < 0)
             {
-                if (err != ICCP_NLE_SEQ_MISMATCH) {
-                    ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to add nd entry(%s %s %s) to kernel, status %d",
-                                ndisc_entry->ifname, show_ipv6_str((char *)ndisc_entry->ipv6_addr), mac_str, err);
-                    return MCLAG_ERROR;
-                }
+                ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to request nd entry(%s %s %s) add, status %d",
+                                 ndisc_entry->ifname, show_ipv6_str((char *)ndisc_entry->ipv6_addr), mac_str, err);
+                return MCLAG_ERROR;
             }
 
            if (ndisc_entry->flag & NEIGH_SYNC_FLAG_ACK)
@@ -1139,11 +1523,9 @@ int mlacp_fsm_update_ndisc_entry(struct CSM *csm, struct NDISCMsg *ndisc_entry)
             err = iccp_netlink_neighbor_request(AF_INET6, (uint8_t *)ndisc_entry->ipv6_addr, 0, ndisc_entry->mac_addr, ndisc_entry->ifname, permanent_neigh, 11);
             if (err < 0)
             {
-                if (err != ICCP_NLE_SEQ_MISMATCH) {
-                    ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to delete nd entry(%s %s %s) from kernel status %d",
-                                ndisc_entry->ifname, show_ipv6_str((char *)ndisc_entry->ipv6_addr), mac_str, err);
-                    return MCLAG_ERROR;
-                }
+                ICCPD_LOG_NOTICE(__FUNCTION__, "Failed to request nd entry(%s %s %s) delete, status %d",
+                                 ndisc_entry->ifname, show_ipv6_str((char *)ndisc_entry->ipv6_addr), mac_str, err);
+                return MCLAG_ERROR;
             }
         }
 
@@ -1163,24 +1545,19 @@ int mlacp_fsm_update_ndisc_entry(struct CSM *csm, struct NDISCMsg *ndisc_entry)
     }
 
     /* update NDISC list */
-    TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_list), tail)
+    msg = mlacp_ndisc_find(csm, ndisc_entry->ipv6_addr);
+    if (msg)
     {
         ndisc_msg = (struct NDISCMsg *)msg->buf;
-        if (memcmp((char *)ndisc_msg->ipv6_addr, (char *)ndisc_entry->ipv6_addr, 16) == 0)
-        {
-            /* ndisc_msg->op_type = tlv->type; */
-            sprintf(ndisc_msg->ifname, "%s", ndisc_entry->ifname);
-            memcpy(ndisc_msg->mac_addr, ndisc_entry->mac_addr, ETHER_ADDR_LEN);
-            break;
-        }
+        /* ndisc_msg->op_type = tlv->type; */
+        mlacp_ndisc_set_ifname(csm, msg, ndisc_entry->ifname);
+        memcpy(ndisc_msg->mac_addr, ndisc_entry->mac_addr, ETHER_ADDR_LEN);
     }
 
     /* delete/add NDISC list */
     if (msg && ndisc_entry->op_type == NEIGH_SYNC_DEL)
     {
-        TAILQ_REMOVE(&(MLACP(csm).ndisc_list), msg, tail);
-        free(msg->buf);
-        free(msg);
+        mlacp_dequeue_ndisc(csm, msg);
         /* ICCPD_LOG_INFO(__FUNCTION__, "Del ndisc queue successfully"); */
     }
     else if (!msg && ndisc_entry->op_type == NEIGH_SYNC_ADD)
@@ -1199,6 +1576,10 @@ int mlacp_fsm_update_ndisc_entry(struct CSM *csm, struct NDISCMsg *ndisc_entry)
         }
     }
 
+    /* the peer has this content now */
+    if (msg && ndisc_entry->op_type == NEIGH_SYNC_ADD)
+        mlacp_neigh_sync_mark(&MLACP(csm).ndisc_digest, msg, mlacp_ndisc_digest(ndisc_entry));
+
     /* remove all NDISC msg queue, when receive peer's NDISC list at the same time */
     TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_msg_list), tail)
     {
@@ -46,6 +46,106 @@ static int vlan_node_compare(const struct VLAN_ID *p_vlan_node1, const struct VL
 }
 RB_GENERATE(vlan_rb_tree, VLAN_ID, vlan_entry, vlan_node_compare);
 
+static unsigned int local_if_name_hash(const char* ifname)
+{
+    unsigned int hash = 5381;
+
+    while (*ifname)
+        hash = hash * 33 + (unsigned char)*ifname++;
+
+    return hash & (LIF_HASH_SIZE - 1);
+}
+
+/* Interned names are never released, there are as many as interfaces
+ * ever seen. Chunks are not moved so returned names stay valid */
+struct IfNameId
+{
+    char name[MAX_L_PORT_NAME];
+    uint16_t hash_next;
+};
+
+static struct IfNameId* ifname_id_chunks[(UINT16_MAX + 1) / IFNAME_ID_CHUNK_SIZE];
+static uint16_t ifname_id_hash[IFNAME_ID_HASH_SIZE];
+static uint32_t ifname_id_count = 1;
+
+static struct IfNameId* ifname_id_entry(uint16_t id)
+{
+    return &ifname_id_chunks[id / IFNAME_ID_CHUNK_SIZE][id % IFNAME_ID_CHUNK_SIZE];
+}
+
+uint16_t ifname_intern(const char* ifname)
+{
+    struct IfNameId* entry = NULL;
+    unsigned int hash;
+    uint16_t id;
+
+    if (ifname == NULL || ifname[0] == '\0')
+        return 0;
+
+    hash = local_if_name_hash(ifname) & (IFNAME_ID_HASH_SIZE - 1);
+    for (id = ifname_id_hash[hash]; id != 0; id = entry->hash_next)
+    {
+        entry = ifname_id_entry(id);
+        if (strncmp(entry->name, ifname, MAX_L_PORT_NAME - 1) == 0)
+            return id;
+    }
+
+    if (ifname_id_count >= IFNAME_ID_INVALID)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "No interface id left for %s", ifname);
+        return IFNAME_ID_INVALID;
+    }
+
+    id = ifname_id_count;
+    if (ifname_id_chunks[id / IFNAME_ID_CHUNK_SIZE] == NULL)
+    {
+        ifname_id_chunks[id / IFNAME_ID_CHUNK_SIZE] = calloc(IFNAME_ID_CHUNK_SIZE, sizeof(struct IfNameId));
+        if (ifname_id_chunks[id / IFNAME_ID_CHUNK_SIZE] == NULL)
+        {
+            ICCPD_LOG_ERR(__FUNCTION__, "Failed to allocate interface id for %s", ifname);
+            return IFNAME_ID_INVALID;
+        }
+    }
+    ++ifname_id_count;
+
+    entry = ifname_id_entry(id);
+    snprintf(entry->name, MAX_L_PORT_NAME, "%s", ifname);
+    entry->hash_next = ifname_id_hash[hash];
+    ifname_id_hash[hash] = id;
+
+    return id;
+}
+
+const char* ifname_from_id(uint16_t id)
+{
+    if (id == 0 || id >= ifname_id_count)
+        return "";
+
+    return ifname_id_entry(id)->name;
+}
+
+static unsigned int local_if_id_hash(int id)
+{
+    return (unsigned int)id & (LIF_HASH_SIZE - 1);
+}
+
+/* Add interface to System lookup indexes, in step with lif_list */
+static void local_if_index_add(struct System* sys, struct LocalInterface* local_if)
+{
+    LIST_INSERT_HEAD(&(sys->lif_name_hash[local_if_name_hash(local_if->name)]), local_if, name_hash_next);
+    LIST_INSERT_HEAD(&(sys->lif_ifindex_hash[local_if_id_hash(local_if->ifindex)]), local_if, ifindex_hash_next);
+    if (local_if->type == IF_T_PORT_CHANNEL)
+        LIST_INSERT_HEAD(&(sys->lif_po_id_hash[local_if_id_hash(local_if->po_id)]), local_if, po_id_hash_next);
+}
+
+static void local_if_index_del(struct LocalInterface* local_if)
+{
+    LIST_REMOVE(local_if, name_hash_next);
+    LIST_REMOVE(local_if, ifindex_hash_next);
+    if (local_if->type == IF_T_PORT_CHANNEL)
+        LIST_REMOVE(local_if, po_id_hash_next);
+}
+
 void local_if_init(struct LocalInterface* local_if)
 {
     if (local_if == NULL)
@@ -131,7 +231,15 @@ struct LocalInterface* local_if_create(int ifindex, char* ifname, int type, uint
     }
 
     if (ifname)
+    {
         snprintf(local_if->name, MAX_L_PORT_NAME, "%s", ifname);
+        local_if->ifname_id = ifname_intern(local_if->name);
+        if (local_if->ifname_id == IFNAME_ID_INVALID)
+        {
+            free(local_if);
+            return NULL;
+        }
+    }
 
     switch (type)
     {
@@ -165,6 +273,7 @@ struct LocalInterface* local_if_create(int ifindex, char* ifname, int type, uint
                    local_if->mac_addr[3], local_if->mac_addr[4], local_if->mac_addr[5], local_if->state ? "down" : "up");
 
     LIST_INSERT_HEAD(&(sys->lif_list), local_if, system_next);
+    local_if_index_add(sys, local_if);
 
     //if there is pending vlan membership for this interface move to system lif
     move_pending_vlan_mbr_to_lif(sys, local_if);
@@ -202,7 +311,7 @@ struct LocalInterface* local_if_find_by_name(const char* ifname)
     if (!(sys = system_get_instance()))
         return NULL;
 
-    LIST_FOREACH(local_if, &(sys->lif_list), system_next)
+    LIST_FOREACH(local_if, &(sys->lif_name_hash[local_if_name_hash(ifname)]), name_hash_next)
     {
         if (strcmp(local_if->name, ifname) == 0)
             return local_if;
@@ -219,7 +328,7 @@ struct LocalInterface* local_if_find_by_ifindex(int ifindex)
     if ((sys = system_get_instance()) == NULL)
         return NULL;
 
-    LIST_FOREACH(local_if, &(sys->lif_list), system_next)
+    LIST_FOREACH(local_if, &(sys->lif_ifindex_hash[local_if_id_hash(ifindex)]), ifindex_hash_next)
     {
         if (local_if->ifindex == ifindex)
             return local_if;
@@ -236,15 +345,30 @@ struct LocalInterface* local_if_find_by_po_id(int po_id)
     if ((sys = system_get_instance()) == NULL)
         return NULL;
 
-    LIST_FOREACH(local_if, &(sys->lif_list), system_next)
+    LIST_FOREACH(local_if, &(sys->lif_po_id_hash[local_if_id_hash(po_id)]), po_id_hash_next)
     {
-        if (local_if->type == IF_T_PORT_CHANNEL && local_if->po_id == po_id)
+        if (local_if->po_id == po_id)
             return local_if;
     }
 
     return NULL;
 }
 
+/* Change ifindex of an existing interface, keeping the ifindex index in step */
+void local_if_update_ifindex(struct LocalInterface* local_if, int ifindex)
+{
+    struct System* sys = NULL;
+
+    if ((sys = system_get_instance()) == NULL)
+        return;
+
+    LIST_REMOVE(local_if, ifindex_hash_next);
+    local_if->ifindex = ifindex;
+    LIST_INSERT_HEAD(&(sys->lif_ifindex_hash[local_if_id_hash(ifindex)]), local_if, ifindex_hash_next);
+
+    return;
+}
+
  void local_if_vlan_remove(struct LocalInterface *lif_vlan)
 {
     struct System *sys = NULL;
@@ -365,6 +489,7 @@ void local_if_destroy(char *ifname)
 to_sys_purge:
     /* sys purge */
     LIST_REMOVE(lif, system_next);
+    local_if_index_del(lif);
     if (lif->csm)
         LIST_REMOVE(lif, mlacp_next);
     LIST_INSERT_HEAD(&(sys->lif_purge_list), lif, system_purge_next);
@@ -373,6 +498,7 @@ to_sys_purge:
 to_mlacp_purge:
     /* sys & mlacp purge */
     LIST_REMOVE(lif, system_next);
+    local_if_index_del(lif);
     LIST_REMOVE(lif, mlacp_next);
     LIST_INSERT_HEAD(&(sys->lif_purge_list), lif, system_purge_next);
     LIST_INSERT_HEAD(&(MLACP(csm).lif_purge_list), lif, mlacp_purge_next);
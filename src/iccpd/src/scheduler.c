@@ -23,6 +23,8 @@
 
 #include <unistd.h>
 #include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
 
 #include <sys/select.h>
 #include <sys/time.h>
@@ -32,6 +34,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 #include "../include/logger.h"
 #include "../include/system.h"
@@ -41,6 +44,7 @@
 #include "../include/iccp_cmd.h"
 #include "../include/mlacp_link_handler.h"
 #include "../include/iccp_netlink.h"
+#include "../include/iccp_snapshot.h"
 
 /******************************************************
 *
@@ -51,8 +55,14 @@
 //this needs to be fine tuned 
 #define PEER_SOCK_SND_BUF_LEN  (6 * 1024 * 1024)
 #define PEER_SOCK_RCV_BUF_LEN  (6 * 1024 * 1024)
-#define RECV_RETRY_INTERVAL_USEC    100000
-#define RECV_RETRY_MAX              10
+
+/* Timer wheel slots, a timer is linked to slot (expire_tick % TIMER_WHEEL_SLOTS) */
+static LIST_HEAD(timer_slot_list, SchedTimer) g_timer_wheel[TIMER_WHEEL_SLOTS];
+/* Last tick expired timers were run for */
+static uint64_t g_timer_wheel_tick = 0;
+/* Tick timerfd is armed for, 0 if not armed */
+static uint64_t g_timer_fd_tick = 0;
+static struct SchedTimer g_syncd_conn_timer;
 
 extern int mlacp_prepare_for_warm_reboot(struct CSM* csm, char* buf, size_t max_buf_size);
 
@@ -99,7 +109,256 @@ static void heartbeat_update(struct CSM *csm)
     return;
 }
 
-/* Transit FSM of all connections */
+/*****************************************
+* Timer wheel
+*
+* ***************************************/
+static uint64_t timer_wheel_now_tick()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000) / TIMER_WHEEL_TICK_MSEC;
+}
+
+static void timer_wheel_arm_fd(uint64_t tick)
+{
+    struct System* sys = NULL;
+    struct itimerspec its;
+    uint64_t msec = tick * TIMER_WHEEL_TICK_MSEC;
+
+    if ((sys = system_get_instance()) == NULL || sys->timer_fd < 0)
+        return;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = msec / 1000;
+    its.it_value.tv_nsec = (msec % 1000) * 1000000;
+    if (timerfd_settime(sys->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to arm timer fd, errno %d", errno);
+        return;
+    }
+    g_timer_fd_tick = tick;
+}
+
+/* Arm timerfd for the first non-empty slot. A slot may only hold timers
+ * of later wheel rounds, the wakeup is then spent re-arming. */
+static void timer_wheel_arm_next()
+{
+    uint64_t tick;
+
+    for (tick = g_timer_wheel_tick + 1; tick <= g_timer_wheel_tick + TIMER_WHEEL_SLOTS; ++tick)
+    {
+        if (!LIST_EMPTY(&g_timer_wheel[tick % TIMER_WHEEL_SLOTS]))
+        {
+            timer_wheel_arm_fd(tick);
+            return;
+        }
+    }
+}
+
+void scheduler_timer_init(struct SchedTimer* timer, void (*callback)(struct SchedTimer*), void* arg)
+{
+    memset(timer, 0, sizeof(struct SchedTimer));
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+void scheduler_timer_stop(struct SchedTimer* timer)
+{
+    if (!timer->armed)
+        return;
+
+    LIST_REMOVE(timer, next);
+    timer->armed = 0;
+}
+
+/* (Re)start one-shot timer expiring after msec */
+void scheduler_timer_start(struct SchedTimer* timer, uint32_t msec)
+{
+    uint32_t ticks = (msec + TIMER_WHEEL_TICK_MSEC - 1) / TIMER_WHEEL_TICK_MSEC;
+
+    scheduler_timer_stop(timer);
+
+    timer->expire_tick = timer_wheel_now_tick() + (ticks ? ticks : 1);
+    if (timer->expire_tick <= g_timer_wheel_tick)
+        timer->expire_tick = g_timer_wheel_tick + 1;
+    LIST_INSERT_HEAD(&g_timer_wheel[timer->expire_tick % TIMER_WHEEL_SLOTS], timer, next);
+    timer->armed = 1;
+
+    if (g_timer_fd_tick == 0 || timer->expire_tick < g_timer_fd_tick)
+        timer_wheel_arm_fd(timer->expire_tick);
+}
+
+/* Run callbacks of all expired timers */
+static void scheduler_timer_expire()
+{
+    LIST_HEAD(expired_list, SchedTimer) expired;
+    struct SchedTimer* timer = NULL;
+    struct SchedTimer* timer_next = NULL;
+    uint64_t now = timer_wheel_now_tick();
+    uint64_t tick;
+    uint64_t last = now;
+
+    if (now <= g_timer_wheel_tick)
+        return;
+
+    /* Visit every slot at most once */
+    if (now - g_timer_wheel_tick > TIMER_WHEEL_SLOTS)
+        last = g_timer_wheel_tick + TIMER_WHEEL_SLOTS;
+
+    /* Collect first, callbacks may start and stop timers */
+    LIST_INIT(&expired);
+    for (tick = g_timer_wheel_tick + 1; tick <= last; ++tick)
+    {
+        timer = LIST_FIRST(&g_timer_wheel[tick % TIMER_WHEEL_SLOTS]);
+        while (timer)
+        {
+            timer_next = LIST_NEXT(timer, next);
+            if (timer->expire_tick <= now)
+            {
+                LIST_REMOVE(timer, next);
+                LIST_INSERT_HEAD(&expired, timer, next);
+            }
+            timer = timer_next;
+        }
+    }
+    g_timer_wheel_tick = now;
+
+    while (!LIST_EMPTY(&expired))
+    {
+        timer = LIST_FIRST(&expired);
+        LIST_REMOVE(timer, next);
+        timer->armed = 0;
+        timer->callback(timer);
+    }
+}
+
+int scheduler_timer_wheel_init(struct System* sys)
+{
+    int i;
+
+    for (i = 0; i < TIMER_WHEEL_SLOTS; ++i)
+        LIST_INIT(&g_timer_wheel[i]);
+    g_timer_wheel_tick = timer_wheel_now_tick();
+    g_timer_fd_tick = 0;
+
+    sys->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (sys->timer_fd < 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to create timer fd, errno %d, fall back to polling", errno);
+        return MCLAG_ERROR;
+    }
+
+    return 0;
+}
+
+int scheduler_get_timer_fd(struct System* sys)
+{
+    return sys->timer_fd;
+}
+
+int scheduler_timer_handler(struct System* sys)
+{
+    uint64_t expirations;
+
+    if (read(sys->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+        ICCPD_LOG_DEBUG(__FUNCTION__, "Failed to read timer fd, errno %d", errno);
+
+    g_timer_fd_tick = 0;
+    scheduler_timer_expire();
+    if (g_timer_fd_tick == 0)
+        timer_wheel_arm_next();
+
+    return 0;
+}
+
+/*****************************************
+* FSM dirty scheduling
+*
+* ***************************************/
+void scheduler_csm_set_dirty(struct CSM* csm)
+{
+    csm->fsm_dirty = 1;
+}
+
+/* Events on shared sources (netlink, mclagsyncd, mclagdctl ...) may change
+ * lif/MAC/ARP state any session syncs to its peer */
+void scheduler_csm_set_dirty_all()
+{
+    struct System* sys = NULL;
+    struct CSM* csm = NULL;
+
+    if ((sys = system_get_instance()) == NULL)
+        return;
+
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+        csm->fsm_dirty = 1;
+}
+
+int scheduler_csm_dirty_pending()
+{
+    struct System* sys = NULL;
+    struct CSM* csm = NULL;
+
+    if ((sys = system_get_instance()) == NULL)
+        return 0;
+
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+    {
+        if (csm->fsm_dirty)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Send due heartbeats of all sessions, the event loop calls it between
+ * handlers so a burst of local events can not time out the peer */
+void scheduler_heartbeat_service()
+{
+    struct System* sys = NULL;
+    struct CSM* csm = NULL;
+
+    if ((sys = system_get_instance()) == NULL)
+        return;
+
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+        mlacp_fsm_send_heartbeat(csm);
+}
+
+void scheduler_csm_fsm_timer_expire(struct SchedTimer* timer)
+{
+    struct CSM* csm = (struct CSM*)timer->arg;
+
+    csm->fsm_dirty = 1;
+}
+
+/* Decide when the CSM FSMs have to run again */
+static void scheduler_csm_fsm_reschedule(struct CSM* csm)
+{
+    /* Received msgs are consumed a few per transit, keep going */
+    if (!TAILQ_EMPTY(&(csm->msg_list))
+        || !TAILQ_EMPTY(&(csm->app_csm.app_msg_list))
+        || !TAILQ_EMPTY(&(MLACP(csm).mlacp_msg_list)))
+        csm->fsm_dirty = 1;
+
+    /* Session setup resends and polls on every transit, so does a
+     * pending MAC/ARP/ND sync; steady state only needs heartbeat
+     * and the second based FSM timers */
+    if (csm->current_state == ICCP_OPERATIONAL
+        && csm->app_csm.current_state == APP_OPERATIONAL
+        && MLACP(csm).current_state == MLACP_STATE_EXCHANGE
+        && TAILQ_EMPTY(&(MLACP(csm).mac_msg_list))
+        && TAILQ_EMPTY(&(MLACP(csm).arp_msg_list))
+        && TAILQ_EMPTY(&(MLACP(csm).ndisc_msg_list)))
+        scheduler_timer_start(&csm->fsm_timer, TRANSIT_INTERVAL_SEC * 1000);
+    else
+        scheduler_timer_start(&csm->fsm_timer, TRANSIT_FAST_INTERVAL_MSEC);
+}
+
+/* Transit FSM of connections with pending work */
 static int scheduler_transit_fsm()
 {
     struct CSM* csm = NULL;
@@ -110,10 +369,15 @@ static int scheduler_transit_fsm()
 
     LIST_FOREACH(csm, &(sys->csm_list), next)
     {
+        if (!csm->fsm_dirty)
+            continue;
+
+        csm->fsm_dirty = 0;
         heartbeat_update(csm);
         iccp_csm_transit(csm);
         app_csm_transit(csm);
         mlacp_fsm_transit(csm);
+        scheduler_csm_fsm_reschedule(csm);
     }
 
     //lif->changed flag is marked for state change for lif, for active node when
@@ -126,129 +390,139 @@ static int scheduler_transit_fsm()
     return 1;
 }
 
-/* Receive packets call back function */
-int scheduler_csm_read_callback(struct CSM* csm)
+/* Queue complete ICCP frames in place in the session receive buffer,
+ * keep a trailing partial frame to be resumed on the next EPOLLIN */
+static int scheduler_csm_parse_frames(struct CSM* csm)
 {
     struct Msg* msg = NULL;
-    /*peer message*/
-    char *peer_msg = g_csm_buf;
-    LDPHdr* ldp_hdr = (LDPHdr*)peer_msg;
-    char* data = &peer_msg[sizeof(LDPHdr)];
-    size_t data_len = 0;
-    size_t pos = 0;
-    int recv_len = 0, len = 0, retval;
-    int num_retry = 0;
-    int total_retry_time = 0;
-    int total_data_len = 0;
-
-    if (csm->sock_fd <= 0)
-        return MCLAG_ERROR;
+    struct RxBuf* rx_buf = NULL;
+    LDPHdr* ldp_hdr = NULL;
+    size_t pos = csm->rx_start;
+    size_t frame_len = 0;
+    uint64_t rx_usec = system_get_usec();
 
-    memset(peer_msg, 0, CSM_BUFFER_SIZE);
+    while (csm->rx_len - pos >= sizeof(LDPHdr))
+    {
+        ldp_hdr = (LDPHdr*)&csm->rx_buf->data[pos];
+        if (ntohs(ldp_hdr->msg_len) < MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS)
+        {
+            ICCPD_LOG_ERR("ICCP_FSM", "Peer disconnect for invalid data error; length[%d] msg_type[0x%x] ", ntohs(ldp_hdr->msg_len),  ntohs(ldp_hdr->msg_type));
+            SYSTEM_INCR_INVALID_PEER_MSG_COUNTER(system_get_instance());
+            return MCLAG_ERROR;
+        }
 
-    recv_len = 0;
-    errno = 0;
+        frame_len = ntohs(ldp_hdr->msg_len) + MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS;
+        if (csm->rx_len - pos < frame_len)
+            break;
 
-    while (recv_len != sizeof(LDPHdr))
-    {
-        len = recv(csm->sock_fd, peer_msg + recv_len, sizeof(LDPHdr) - recv_len, 0);
-        if (len == -1)
+        if (csm->rx_resume_count > 0)
         {
-            perror("recv(). Error");
-            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for header read error[%s] len = -1 till now received len  = %d ", strerror(errno), recv_len);
-            SYSTEM_INCR_HDR_READ_SOCK_ERR_COUNTER(system_get_instance());
-            goto recv_err;
+            SYSTEM_SET_RETRY_COUNTER(system_get_instance(), csm->rx_resume_count);
+            csm->rx_resume_count = 0;
         }
-        else if (len == 0)
+
+        if (iccp_csm_init_rx_msg(&msg, csm->rx_buf, pos, frame_len) == 0)
         {
-            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for header read error[%s] len = 0, till now received len = %d ",strerror(errno), recv_len);
-            SYSTEM_INCR_HDR_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
-            goto recv_err;
+            msg->trace_usec = rx_usec;
+            iccp_csm_enqueue_msg(csm, msg);
+            ++csm->icc_msg_in_count;
         }
-        recv_len += len;
-        /*usleep(100);*/
+        else
+            ++csm->i_msg_in_count;
+
+        pos += frame_len;
     }
 
-    if (ntohs(ldp_hdr->msg_len) >= MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS)
+    csm->rx_start = pos;
+
+    /* Keep room for a maximum size frame. Queued frames still refer to
+     * the buffer, move the partial frame to a new one then */
+    if (CSM_RX_BUFFER_SIZE - csm->rx_start < CSM_BUFFER_SIZE + MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS)
     {
-        data_len = ntohs(ldp_hdr->msg_len) - MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS;
+        rx_buf = csm->rx_buf;
+        if (rx_buf->refcnt > 1)
+        {
+            rx_buf = iccp_csm_rx_buf_alloc();
+            if (!rx_buf)
+            {
+                ICCPD_LOG_ERR("ICCP_FSM", "Peer disconnect for receive buffer allocation failure");
+                return MCLAG_ERROR;
+            }
+        }
+
+        csm->rx_len -= csm->rx_start;
+        memmove(rx_buf->data, &csm->rx_buf->data[csm->rx_start], csm->rx_len);
+        csm->rx_start = 0;
+        if (rx_buf != csm->rx_buf)
+        {
+            iccp_csm_rx_buf_put(csm->rx_buf);
+            csm->rx_buf = rx_buf;
+        }
     }
-    else
+
+    return 0;
+}
+
+/* Receive packets call back function */
+int scheduler_csm_read_callback(struct CSM* csm)
+{
+    ssize_t len = 0;
+    int received = 0;
+
+    if (csm->sock_fd <= 0)
+        return MCLAG_ERROR;
+
+    if (!csm->rx_buf)
     {
-        ICCPD_LOG_ERR("ICCP_FSM", "Peer disconnect for invalid data error; length[%d] msg_type[0x%x] ", ntohs(ldp_hdr->msg_len),  ntohs(ldp_hdr->msg_type));
-        SYSTEM_INCR_INVALID_PEER_MSG_COUNTER(system_get_instance());
-        goto recv_err;
+        csm->rx_buf = iccp_csm_rx_buf_alloc();
+        if (!csm->rx_buf)
+        {
+            ICCPD_LOG_ERR("ICCP_FSM", "Peer disconnect for receive buffer allocation failure");
+            goto recv_err;
+        }
     }
-    total_data_len = data_len;
-    pos = 0;
 
-    while (data_len > 0)
+    /* Drain the socket without blocking, frames are parsed as they complete */
+    while (1)
     {
-        /* When consecutive CCP session flaps happen, recv() call got stuck.
-         * Change recv() to non-blocking with retry mechanism. If max
-         * retry reaches, attempt one more retry after waiting for one KA
-         * interval before bringing down the session.
-         */
-        recv_len = recv(csm->sock_fd, &data[pos], data_len, MSG_DONTWAIT);
-        if (recv_len == -1)
+        len = recv(csm->sock_fd, &csm->rx_buf->data[csm->rx_len], CSM_RX_BUFFER_SIZE - csm->rx_len, MSG_DONTWAIT);
+        if (len == -1)
         {
+            if (errno == EINTR)
+                continue;
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+
+            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for read error[%s], pending len = %zu ", strerror(errno),
+                           csm->rx_len - csm->rx_start);
+            SYSTEM_INCR_HDR_READ_SOCK_ERR_COUNTER(system_get_instance());
+            goto recv_err;
+        }
+        else if (len == 0)
+        {
+            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for read len = 0, pending len = %zu ", csm->rx_len - csm->rx_start);
+            if (csm->rx_len > csm->rx_start)
             {
-                ICCPD_LOG_NOTICE(
-                    "ICCP_FSM", "Non-blocking recv total/pending len %d/%d, errno %d, num_retry %d",
-                    total_data_len, data_len, errno, num_retry);
-                ++num_retry;
-                if (num_retry > RECV_RETRY_MAX)
-                {
-                    ICCPD_LOG_ERR(
-                        "ICCP_FSM", "Non-blocking recv() retry failed, total/pending len %d/%d",
-                        total_data_len, data_len);
-                    SYSTEM_INCR_RX_RETRY_FAIL_COUNTER(system_get_instance());
-                    goto recv_err;
-                }
-                else
-                {
-                    if (num_retry == RECV_RETRY_MAX)
-                        usleep((csm->session_timeout * 1000000) - total_retry_time);
-                    else
-                    {
-                        total_retry_time += (num_retry * RECV_RETRY_INTERVAL_USEC);
-                        usleep(num_retry * RECV_RETRY_INTERVAL_USEC);
-                    }
-                    recv_len = 0;
-                }
+                SYSTEM_INCR_TLV_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
             }
             else
             {
-                perror("continue recv() Error");
-                ICCPD_LOG_WARN("ICCP_FSM", "Peer data read error; recv_len:%d data_len:%d, errno %d",
-                               recv_len, data_len, errno);
-                SYSTEM_INCR_TLV_READ_SOCK_ERR_COUNTER(system_get_instance());
-                goto recv_err;
+                SYSTEM_INCR_HDR_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
             }
-        }
-        else if (recv_len == 0)
-        {
-            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for data read error; recv_len:%d data_len:%d ", recv_len, data_len);
-            SYSTEM_INCR_TLV_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
             goto recv_err;
         }
-        data_len -= recv_len;
-        pos += recv_len;
-        /*usleep(100);*/
-    }
-    if (num_retry > 0)
-    {
-        SYSTEM_SET_RETRY_COUNTER(system_get_instance(), num_retry);
-    }
-    retval = iccp_csm_init_msg(&msg, peer_msg, ntohs(ldp_hdr->msg_len) + MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS);
-    if (retval == 0)
-    {
-        iccp_csm_enqueue_msg(csm, msg);
-        ++csm->icc_msg_in_count;
+
+        received = 1;
+        csm->rx_len += len;
+        if (scheduler_csm_parse_frames(csm) == MCLAG_ERROR)
+            goto recv_err;
     }
-    else
-        ++csm->i_msg_in_count;
+
+    if (!received)
+        return 0;
+
+    if (csm->rx_len > csm->rx_start)
+        ++csm->rx_resume_count;
 
     return 1;
 
@@ -381,6 +655,8 @@ void scheduler_init()
         return;
 
     iccp_get_start_type(sys);
+    /*Tables saved on the last warm exit, restored per MC-LAG domain*/
+    iccp_snapshot_load(sys);
     /*Get kernel interface and port */
     iccp_sys_local_if_list_get_init();
     iccp_sys_local_if_list_get_addr();
@@ -458,6 +734,12 @@ int iccp_receive_signal_handler(struct System* sys)
     return 0;
 }
 
+/* Only wakes up the scheduler loop to retry the mclagsyncd connection */
+static void scheduler_syncd_conn_timer_expire(struct SchedTimer* timer)
+{
+    return;
+}
+
 /* Thread fetch to call */
 void scheduler_loop()
 {
@@ -466,21 +748,28 @@ void scheduler_loop()
     if ((sys = system_get_instance()) == NULL)
         return;
 
+    scheduler_timer_init(&g_syncd_conn_timer, scheduler_syncd_conn_timer_expire, NULL);
+
     while (1)
     {
         if (sys->sync_fd <= 0)
         {
             iccp_connect_syncd();
+            if (sys->sync_fd <= 0 && !g_syncd_conn_timer.armed)
+                scheduler_timer_start(&g_syncd_conn_timer, SYNCD_CONNECT_INTERVAL_MSEC);
         }
 
-        /*handle socket slelect event ,If no message received, it will block 0.1s*/
+        /*handle socket event, block until an fd or a timer fires, or 0.1s without timer fd*/
         iccp_handle_events(sys);
+        if (sys->timer_fd < 0)
+            scheduler_timer_expire();
         /*csm, app state machine transit */
         scheduler_transit_fsm();
 
         if (sys->warmboot_exit == WARM_REBOOT)
         {
             ICCPD_LOG_DEBUG(__FUNCTION__, "Warm reboot exit ......");
+            iccp_snapshot_save(sys);
             return;
         }
     }
@@ -553,13 +842,118 @@ void scheduler_finalize()
     return;
 }
 
+/* Double the interval before the next connect attempt */
+static void session_conn_backoff(struct CSM *csm)
+{
+    csm->conn_fd = -1;
+    csm->conn_backoff_sec *= 2;
+    if (csm->conn_backoff_sec > CONNECT_BACKOFF_MAX_SEC)
+        csm->conn_backoff_sec = CONNECT_BACKOFF_MAX_SEC;
+    time(&csm->connTimePrev);
+}
+
+/* Complete session setup once the peer connection is established */
+static int session_client_conn_established(struct System* sys, struct CSM *csm, int connFd)
+{
+    struct epoll_event event;
+    int send_buf_len = PEER_SOCK_SND_BUF_LEN;
+    int recv_buf_len = PEER_SOCK_RCV_BUF_LEN;
+    int flags;
+
+    /* Session I/O after connect stays blocking as before */
+    flags = fcntl(connFd, F_GETFL, 0);
+    if (flags == -1 || fcntl(connFd, F_SETFL, flags & ~O_NONBLOCK) == -1)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Clear socket non-blocking option failed. errno = %d", errno);
+        return MCLAG_ERROR;
+    }
+
+    event.data.fd = connFd;
+    event.events = EPOLLIN;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_MOD, connFd, &event) != 0)
+        return MCLAG_ERROR;
+
+    csm->conn_fd = -1;
+    csm->conn_backoff_sec = CONNECT_INTERVAL_SEC;
+    csm->sock_fd = connFd;
+    if (setsockopt(csm->sock_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_len, sizeof(send_buf_len)) == -1)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Set socket send buf option failed. Error");
+    }
+    if (setsockopt(csm->sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_buf_len, sizeof(recv_buf_len)) == -1)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Set socket recv buf option failed. Error");
+    }
+
+    FD_SET(connFd, &(sys->readfd));
+    sys->readfd_count++;
+    ICCPD_LOG_INFO(__FUNCTION__, "Connect to server %s sucess .", csm->peer_ip);
+
+    return 0;
+}
+
+/* Abort pending peer connection and back off the next attempt */
+void scheduler_csm_connect_abort(struct CSM* csm)
+{
+    struct System* sys = NULL;
+    struct epoll_event event;
+
+    if (csm == NULL || csm->conn_fd < 0)
+        return;
+
+    if ((sys = system_get_instance()) != NULL)
+    {
+        event.data.fd = csm->conn_fd;
+        event.events = EPOLLOUT;
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, csm->conn_fd, &event);
+    }
+
+    close(csm->conn_fd);
+    session_conn_backoff(csm);
+
+    return;
+}
+
+/* Handle EPOLLOUT on pending peer connection */
+int scheduler_csm_connect_callback(struct CSM* csm)
+{
+    struct System* sys = NULL;
+    int connFd;
+    int err = 0;
+    socklen_t len = sizeof(err);
+
+    if ((sys = system_get_instance()) == NULL)
+        return MCLAG_ERROR;
+
+    if (csm == NULL || csm->conn_fd < 0)
+        return MCLAG_ERROR;
+
+    connFd = csm->conn_fd;
+    if (getsockopt(connFd, SOL_SOCKET, SO_ERROR, &err, &len) == -1)
+        err = errno;
+
+    ICCPD_LOG_INFO(__FUNCTION__, "Connection. fd = [%d], status = [%d], %p",
+                   connFd, err, csm);
+
+    if (err != 0 || session_client_conn_established(sys, csm, connFd) != 0)
+    {
+        scheduler_csm_connect_abort(csm);
+        ICCPD_LOG_DEBUG(__FUNCTION__, "Peer IP:%s connect failed, retry in %d secs",
+                        csm->peer_ip, csm->conn_backoff_sec);
+        return MCLAG_ERROR;
+    }
+
+    time(&csm->connTimePrev);
+
+    return 0;
+}
+
 void session_client_conn_handler(struct CSM *csm)
 {
     struct System* sys = NULL;
     struct sockaddr_in peer_addr;
+    struct epoll_event event;
     int connFd = -1, connStat = -1;
-    struct timeval con_tv;
-    socklen_t len = sizeof(con_tv);
     int err = 0;
 
     struct sockaddr_in src_addr;
@@ -576,7 +970,7 @@ void session_client_conn_handler(struct CSM *csm)
         goto conn_fail;
 
     /* Create sock*/
-    connFd = socket(PF_INET, SOCK_STREAM, 0);
+    connFd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     bzero(&peer_addr, sizeof(peer_addr));
     peer_addr.sin_family = PF_INET;
     peer_addr.sin_port = htons(ICCP_TCP_PORT);
@@ -588,14 +982,6 @@ void session_client_conn_handler(struct CSM *csm)
         goto conn_fail;
     }
 
-    /* Set connect timeout secs*/
-    con_tv.tv_sec = 0;
-    con_tv.tv_usec = CONNECT_TIMEOUT_MSEC * 1000;
-    if (setsockopt(connFd, SOL_SOCKET, SO_SNDTIMEO, &con_tv, len) == -1)
-    {
-        ICCPD_LOG_INFO(__FUNCTION__, "Set socket timeout fail");
-    }
-
     err = bind(connFd, (struct sockaddr*)&(src_addr), sizeof(src_addr));
     if (err < 0)
     {
@@ -603,53 +989,38 @@ void session_client_conn_handler(struct CSM *csm)
         goto conn_fail;
     }
 
-    /* Try conn*/
+    /* Start conn, completion is reported by EPOLLOUT */
     ICCPD_LOG_INFO(__FUNCTION__, "Connecting. peer ip = [%s], %p", csm->peer_ip, csm);
     connStat = connect(connFd, (struct sockaddr*)&(peer_addr), sizeof(peer_addr));
-    ICCPD_LOG_INFO(__FUNCTION__, "Connection. fd = [%d], status = [%d], %p",
-                   connFd, connStat, csm);
-
-    if (connStat != 0)
+    if (connStat != 0 && errno != EINPROGRESS)
     {
         /* Conn Fail*/
+        ICCPD_LOG_INFO(__FUNCTION__, "Connection. fd = [%d], errno = [%d], %p",
+                       connFd, errno, csm);
         goto conn_fail;
     }
-    else
-    {
-        /* Conn OK*/
-        struct epoll_event event;
-        int err;
-        int send_buf_len = PEER_SOCK_SND_BUF_LEN;
-        int recv_buf_len = PEER_SOCK_RCV_BUF_LEN;
-        event.data.fd = connFd;
-        event.events = EPOLLIN;
-        err = epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, connFd, &event);
-        if (err)
-            goto conn_fail;
-        csm->sock_fd = connFd;
-        if (setsockopt(csm->sock_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_len, sizeof(send_buf_len)) == -1)
-        {
-            ICCPD_LOG_ERR(__FUNCTION__, "Set socket send buf option failed. Error");
-        }
-        if (setsockopt(csm->sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_buf_len, sizeof(recv_buf_len)) == -1)
-        {
-            ICCPD_LOG_ERR(__FUNCTION__, "Set socket recv buf option failed. Error");
-        }
 
-        FD_SET(connFd, &(sys->readfd));
-        sys->readfd_count++;
-        ICCPD_LOG_INFO(__FUNCTION__, "Connect to server %s sucess .", csm->peer_ip);
-        goto conn_ok;
-    }
+    event.data.fd = connFd;
+    event.events = EPOLLOUT;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, connFd, &event) != 0)
+        goto conn_fail;
+
+    csm->conn_fd = connFd;
+    time(&csm->connTimePrev);
+
+    /* Conn OK*/
+    if (connStat == 0)
+        scheduler_csm_connect_callback(csm);
+
+    session_conn_thread_unlock(&csm->conn_mutex);
+    return;
 
  conn_fail:
     if (connFd >= 0)
     {
-        csm->sock_fd = -1;
         close(connFd);
     }
- conn_ok:
-    time(&csm->connTimePrev);
+    session_conn_backoff(csm);
     session_conn_thread_unlock(&csm->conn_mutex);
     return;
 }
@@ -667,8 +1038,19 @@ int scheduler_prepare_session(struct CSM* csm)
         time(&csm->connTimePrev);
     }
 
-    /* Don't conn to svr continously*/
-    if ((time(NULL) - csm->connTimePrev) < CONNECT_INTERVAL_SEC)
+    /* Connect in progress, give up if the peer does not answer in time*/
+    if (csm->conn_fd >= 0)
+    {
+        if ((time(NULL) - csm->connTimePrev) >= CONNECT_TIMEOUT_SEC)
+        {
+            ICCPD_LOG_DEBUG(__FUNCTION__, "Peer IP:%s connect timeout", csm->peer_ip);
+            scheduler_csm_connect_abort(csm);
+        }
+        goto no_time_update;
+    }
+
+    /* Don't conn to svr continously, back off after failures*/
+    if ((time(NULL) - csm->connTimePrev) < csm->conn_backoff_sec)
     {
         goto no_time_update;
     }
@@ -700,6 +1082,7 @@ int scheduler_prepare_session(struct CSM* csm)
         session_client_conn_handler(csm);
         session_conn_thread_unlock(&csm->conn_mutex);
     }
+    goto no_time_update;
 
  time_update:
     time(&csm->connTimePrev);
@@ -842,6 +1225,7 @@ void scheduler_session_disconnect_handler(struct CSM* csm)
     ICCPD_LOG_NOTICE("ICCP_FSM", "scheduler session disconnect handler");
 
     session_conn_thread_lock(&csm->conn_mutex);
+    scheduler_csm_connect_abort(csm);
     scheduler_unregister_sock_read_event_callback(csm);
     if (csm->sock_fd > 0)
     {
@@ -892,5 +1276,6 @@ void scheduler_csm_socket_cleanup(struct CSM* csm, int location)
                          csm->sock_fd, location);
     }
     csm->sock_fd = -1;
+    iccp_csm_rx_release(csm);
 }
 
@@ -22,6 +22,7 @@
  */
 
 #include <stdio.h>
+#include <time.h>
 #include <netlink/msg.h>
 
 #include "../include/iccp_csm.h"
@@ -30,6 +31,7 @@
 #include "../include/scheduler.h"
 #include "../include/mlacp_link_handler.h"
 #include "../include/iccp_ifm.h"
+#include "../include/iccp_snapshot.h"
 
 #define ETHER_ADDR_LEN 6
 char mac_print_str[ETHER_ADDR_STR_LEN];
@@ -66,6 +68,7 @@ void system_init(struct System* sys)
     sys->arp_receive_fd = -1;
     sys->ndisc_receive_fd = -1;
     sys->epoll_fd = -1;
+    sys->timer_fd = -1;
     sys->family = -1;
     sys->warmboot_start = 0;
     sys->warmboot_exit = 0;
@@ -79,6 +82,7 @@ void system_init(struct System* sys)
     sys->cmd_file_path = strdup("/var/run/iccpd/iccpd.vty");
     sys->config_file_path = strdup("/etc/iccpd/iccpd.conf");
     sys->mclagdctl_file_path = strdup("/var/run/iccpd/mclagdctl.sock");
+    sys->snapshot_file_path = strdup("/var/warmboot/iccpd/iccpd.snapshot");
     sys->pid_file_fd = 0;
     sys->telnet_port = 2015;
     FD_ZERO(&(sys->readfd));
@@ -88,6 +92,7 @@ void system_init(struct System* sys)
     sys->need_sync_netlink_again = 0;
     scheduler_server_sock_init();
     iccp_system_init_netlink_socket();
+    scheduler_timer_wheel_init(sys);
     iccp_init_netlink_event_fd(sys);
 }
 
@@ -148,6 +153,9 @@ void system_finalize()
         free(sys->cmd_file_path);
     if (sys->config_file_path != NULL )
         free(sys->config_file_path);
+    if (sys->snapshot_file_path != NULL )
+        free(sys->snapshot_file_path);
+    iccp_snapshot_discard();
     if (sys->pid_file_fd > 0)
         close(sys->pid_file_fd);
     if (sys->server_fd > 0)
@@ -397,3 +405,52 @@ void system_update_netlink_counters(
             break;
     }
 }
+
+/* Monotonic time in usec, 0 is reserved for "not stamped" */
+uint64_t system_get_usec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + 1;
+}
+
+/* Add the time elapsed since start_usec to the histogram of a phase */
+void system_latency_record(ICCP_LATENCY_PHASE_e phase, uint64_t start_usec)
+{
+    struct System *sys;
+    iccp_latency_hist_t *hist;
+    uint64_t usec;
+    int bucket = 0;
+
+    if (start_usec == 0 || phase >= ICCP_LATENCY_PHASE_MAX)
+        return;
+
+    if ((sys = system_get_instance()) == NULL)
+        return;
+
+    usec = system_get_usec() - start_usec;
+    while (bucket < ICCP_LATENCY_BUCKETS - 1 && (usec >> bucket) != 0)
+        bucket++;
+
+    hist = &sys->latency[phase];
+    hist->count++;
+    hist->sum_usec += usec;
+    if (usec > hist->max_usec)
+        hist->max_usec = usec > UINT32_MAX ? UINT32_MAX : usec;
+    hist->buckets[bucket]++;
+}
+
+/* Called when an entry is queued for the peer: records the learn phase of
+ * the mclagsyncd/netlink event being handled and returns the queue time
+ * to keep with the entry, 0 if the entry is not queued by such an event */
+uint64_t system_latency_queue_stamp()
+{
+    struct System *sys;
+
+    if ((sys = system_get_instance()) == NULL || sys->latency_event_usec == 0)
+        return 0;
+
+    system_latency_record(ICCP_LATENCY_LEARN_QUEUE, sys->latency_event_usec);
+    return system_get_usec();
+}